@@ -0,0 +1,285 @@
+﻿#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <malloc.h> // _msize（Windows）/ malloc_usable_size（Linux）
+
+#include "AllocProfiler.h"
+using namespace std;
+
+namespace
+{
+    // 计数器都是常量初始化的原子量，静态初始化阶段的分配也能安全访问
+    struct TagCounters
+    {
+        atomic<long long> count;
+        atomic<long long> bytes;
+        atomic<long long> frees;
+        atomic<long long> peakLive; // 累计峰值
+        atomic<long long> tickPeak; // 本帧峰值（AllocTickTracker::tick时重置）
+    };
+
+    atomic<bool> profilingEnabled(false);
+    atomic<long long> liveBytes(0);
+    TagCounters counters[ALLOC_MAX_TAGS];
+    const char *tagNames[ALLOC_MAX_TAGS] = {"untagged", "other"};
+    atomic<int> tagCount(2);
+    atomic_flag registerLock = ATOMIC_FLAG_INIT;
+
+    const int OTHER_TAG = 1;
+
+    AllocStats statsOf(int tag)
+    {
+        AllocStats s;
+        s.name = tagNames[tag];
+        s.count = counters[tag].count.load(memory_order_relaxed);
+        s.bytes = counters[tag].bytes.load(memory_order_relaxed);
+        s.frees = counters[tag].frees.load(memory_order_relaxed);
+        s.peakLive = counters[tag].peakLive.load(memory_order_relaxed);
+        return s;
+    }
+}
+
+#ifndef CAR_SIM_NO_ALLOC_HOOK
+// 全局operator new/delete替换为带统计的版本
+namespace
+{
+    void atomicMax(atomic<long long> &target, long long value)
+    {
+        long long current = target.load(memory_order_relaxed);
+        while (value > current && !target.compare_exchange_weak(current, value, memory_order_relaxed))
+        {
+        }
+    }
+
+    size_t usableSize(void *p)
+    {
+#ifdef _WIN32
+        return _msize(p);
+#else
+        return malloc_usable_size(p);
+#endif
+    }
+
+    void noteAllocation(void *p, size_t size)
+    {
+        if (p == nullptr || !profilingEnabled.load(memory_order_relaxed))
+            return;
+        long long usable = (long long)usableSize(p);
+        long long live = liveBytes.fetch_add(usable, memory_order_relaxed) + usable;
+        TagCounters &c = counters[currentAllocTag()];
+        c.count.fetch_add(1, memory_order_relaxed);
+        c.bytes.fetch_add((long long)size, memory_order_relaxed);
+        atomicMax(c.peakLive, live);
+        atomicMax(c.tickPeak, live);
+    }
+
+    void noteFree(void *p)
+    {
+        if (p == nullptr || !profilingEnabled.load(memory_order_relaxed))
+            return;
+        counters[currentAllocTag()].frees.fetch_add(1, memory_order_relaxed);
+        liveBytes.fetch_sub((long long)usableSize(p), memory_order_relaxed);
+    }
+
+    // 按标准operator new的语义分配：失败时调用new_handler重试，没有handler时返回nullptr
+    void *allocate(size_t size)
+    {
+        if (size == 0)
+            size = 1;
+        while (true)
+        {
+            void *p = malloc(size);
+            if (p != nullptr)
+            {
+                noteAllocation(p, size);
+                return p;
+            }
+            new_handler handler = get_new_handler();
+            if (handler == nullptr)
+                return nullptr;
+            handler();
+        }
+    }
+
+    void release(void *p)
+    {
+        noteFree(p);
+        free(p);
+    }
+}
+
+void *operator new(size_t size)
+{
+    void *p = allocate(size);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const nothrow_t &tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, const nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, const nothrow_t &) noexcept { release(p); }
+void operator delete(void *p, size_t) noexcept { release(p); }
+void operator delete[](void *p, size_t) noexcept { release(p); }
+#endif
+
+int registerAllocTag(const char *name)
+{
+    while (registerLock.test_and_set(memory_order_acquire))
+    {
+    }
+    int count = tagCount.load(memory_order_relaxed);
+    int tag = -1;
+    for (int i = 0; i < count; ++i)
+    {
+        if (strcmp(tagNames[i], name) == 0)
+            tag = i;
+    }
+    if (tag < 0)
+    {
+        if (count < ALLOC_MAX_TAGS)
+        {
+            tag = count;
+            tagNames[tag] = name;
+            tagCount.store(count + 1, memory_order_release);
+        }
+        else
+        {
+            tag = OTHER_TAG;
+        }
+    }
+    registerLock.clear(memory_order_release);
+    return tag;
+}
+
+void enableAllocProfiling(bool enabled)
+{
+    profilingEnabled.store(enabled, memory_order_relaxed);
+}
+
+bool allocProfilingEnabled()
+{
+    return profilingEnabled.load(memory_order_relaxed);
+}
+
+void resetAllocStats()
+{
+    liveBytes.store(0, memory_order_relaxed);
+    for (auto &c : counters)
+    {
+        c.count.store(0, memory_order_relaxed);
+        c.bytes.store(0, memory_order_relaxed);
+        c.frees.store(0, memory_order_relaxed);
+        c.peakLive.store(0, memory_order_relaxed);
+        c.tickPeak.store(0, memory_order_relaxed);
+    }
+}
+
+long long allocLiveBytes()
+{
+    return liveBytes.load(memory_order_relaxed);
+}
+
+vector<AllocStats> allocSnapshot()
+{
+    int count = tagCount.load(memory_order_acquire);
+    vector<AllocStats> result;
+    result.reserve(ALLOC_MAX_TAGS); // 预留足够容量，下面的统计不会被本函数自己的分配打断
+    for (int tag = 0; tag < count; ++tag)
+    {
+        result.push_back(statsOf(tag));
+    }
+    return result;
+}
+
+void AllocTickTracker::start()
+{
+    enableAllocProfiling(false);
+    resetAllocStats();
+    previous.assign(ALLOC_MAX_TAGS, AllocStats{"", 0, 0, 0, 0});
+    lastTick = previous;
+    maxTick = previous;
+    ticks = 0;
+    busiestTick = -1;
+    busiestTickCount = 0;
+    enableAllocProfiling(true);
+}
+
+void AllocTickTracker::tick()
+{
+    // 统计时不记录本函数自己的分配（current在重新启用前释放）
+    bool wasEnabled = allocProfilingEnabled();
+    enableAllocProfiling(false);
+    {
+        vector<AllocStats> current = allocSnapshot();
+        long long tickCount = 0;
+        for (size_t tag = 0; tag < current.size(); ++tag)
+        {
+            AllocStats delta = current[tag];
+            delta.count -= previous[tag].count;
+            delta.bytes -= previous[tag].bytes;
+            delta.frees -= previous[tag].frees;
+            delta.peakLive = counters[tag].tickPeak.exchange(liveBytes.load(memory_order_relaxed), memory_order_relaxed);
+            lastTick[tag] = delta;
+            tickCount += delta.count;
+
+            AllocStats &m = maxTick[tag];
+            m.name = delta.name;
+            m.count = max(m.count, delta.count);
+            m.bytes = max(m.bytes, delta.bytes);
+            m.frees = max(m.frees, delta.frees);
+            m.peakLive = max(m.peakLive, delta.peakLive);
+            previous[tag] = current[tag];
+        }
+        if (tickCount > busiestTickCount)
+        {
+            busiestTickCount = tickCount;
+            busiestTick = ticks;
+        }
+        ++ticks;
+    }
+    enableAllocProfiling(wasEnabled);
+}
+
+void printAllocReport(const vector<AllocStats> &cumulative, const AllocTickTracker &tracker)
+{
+    double ticks = (double)max(1LL, tracker.ticks);
+    printf("allocations over %lld ticks (busiest tick %lld: %lld allocations)\n",
+           tracker.ticks, tracker.busiestTick, tracker.busiestTickCount);
+    printf("  %-14s %12s %14s %12s %12s %14s\n", "phase", "allocs/tick", "bytes/tick", "frees/tick", "max allocs", "peak live");
+    for (size_t tag = 0; tag < cumulative.size(); ++tag)
+    {
+        const AllocStats &s = cumulative[tag];
+        if (s.count == 0 && s.frees == 0)
+            continue;
+        long long maxCount = tag < tracker.maxTick.size() ? tracker.maxTick[tag].count : 0;
+        printf("  %-14s %12.1f %14.1f %12.1f %12lld %14lld\n", s.name, s.count / ticks, s.bytes / ticks,
+               s.frees / ticks, maxCount, s.peakLive);
+    }
+}
@@ -0,0 +1,77 @@
+﻿#include <vector>
+#include <cstddef>
+using namespace std;
+
+// 分配剖析：替换全局operator new/delete，把分配次数、字节数和在用内存峰值
+// 归到当前线程的标签（帧内阶段或调用点）上。标签用ALLOC_SCOPE按作用域压栈，
+// 嵌套时归到最内层的标签。默认不统计（只多一次原子读），enableAllocProfiling(true)后开始统计，
+// Release构建同样可用；定义CAR_SIM_NO_ALLOC_HOOK时不替换operator new（例如作为共享库嵌入时）。
+
+const int ALLOC_MAX_TAGS = 32; // 标签数上限，超出的标签归到"other"
+
+// 一个标签的分配统计
+struct AllocStats
+{
+    const char *name;
+    long long count;    // 分配次数
+    long long bytes;    // 申请的字节数
+    long long frees;    // 释放次数
+    long long peakLive; // 该标签活动期间观察到的全局在用内存峰值（字节，相对resetAllocStats时）
+};
+
+// 当前线程的标签（0为未标记）
+inline int &currentAllocTag()
+{
+    thread_local int tag = 0;
+    return tag;
+}
+
+// 注册标签，同名标签返回同一个编号（不分配内存，可在任意位置调用）
+int registerAllocTag(const char *name);
+
+// 作用域标签：构造时切换到tag，析构时恢复外层标签
+struct AllocScope
+{
+    int previous;
+
+    explicit AllocScope(int tag) : previous(currentAllocTag()) { currentAllocTag() = tag; }
+    ~AllocScope() { currentAllocTag() = previous; }
+};
+
+#define ALLOC_CONCAT_INNER(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_INNER(a, b)
+// 在当前作用域内把分配归到name（标签编号在第一次执行时注册）
+#define ALLOC_SCOPE(name)                                                               \
+    static const int ALLOC_CONCAT(allocTag, __LINE__) = registerAllocTag(name);         \
+    AllocScope ALLOC_CONCAT(allocScope, __LINE__)(ALLOC_CONCAT(allocTag, __LINE__))
+
+// 开始/停止统计
+void enableAllocProfiling(bool enabled);
+bool allocProfilingEnabled();
+// 清零所有标签的统计和在用内存
+void resetAllocStats();
+// 当前在用内存（字节，相对resetAllocStats时）
+long long allocLiveBytes();
+// 所有已注册标签的累计统计（按标签编号排列）
+vector<AllocStats> allocSnapshot();
+
+// 逐帧统计：每帧结束时调用tick()，得到这一帧的增量，并记录各标签单帧的最大值
+struct AllocTickTracker
+{
+    vector<AllocStats> previous; // 上一帧结束时的累计值
+    vector<AllocStats> lastTick; // 最近一帧的增量（peakLive为这一帧内的峰值）
+    vector<AllocStats> maxTick;  // 各标签单帧增量的最大值
+    long long ticks = 0;
+    long long busiestTick = -1;      // 分配次数最多的一帧（从0开始）
+    long long busiestTickCount = 0;  // 这一帧的分配次数
+
+    // 开始统计（清零并启用剖析）
+    void start();
+    // 一帧结束
+    void tick();
+};
+
+// 输出累计统计（每帧平均）和单帧最大值
+void printAllocReport(const vector<AllocStats> &cumulative, const AllocTickTracker &tracker);
+
+#pragma once
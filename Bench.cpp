@@ -0,0 +1,77 @@
+﻿#include <chrono>
+#include <cstdio>
+
+#include "Bench.h"
+#include "WarmStart.h"
+using namespace std;
+
+BenchResult runBenchmark(int windowWidth, int windowHeight, double scale, double widthScale, const BenchOptions &options)
+{
+    Simulation sim(windowWidth, windowHeight, scale, widthScale, options.seed);
+    sim.params.logRelativeSpeed = false;
+    WarmStartConfig config;
+    for (auto &lane : config.lanes)
+    {
+        lane.density = options.density;
+    }
+    warmStart(sim, config);
+
+    Simulation warm = sim; // 分配统计从同一状态开始
+    Simulation counted = sim; // 计数器统计也从同一状态开始
+    BenchResult result;
+    result.ticks = 0;
+    result.vehicleUpdates = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < options.ticks; ++i)
+    {
+        result.vehicleUpdates += (long long)sim.vehicles.size();
+        sim.step();
+        ++result.ticks;
+    }
+    auto end = chrono::steady_clock::now();
+    result.seconds = chrono::duration<double>(end - start).count();
+
+    // 计时不受统计开销影响：分配统计单独再推进一遍
+    if (options.profileAllocations)
+    {
+        result.allocTicks.start();
+        for (int i = 0; i < options.ticks; ++i)
+        {
+            warm.step();
+            result.allocTicks.tick();
+        }
+        enableAllocProfiling(false);
+        result.allocations = allocSnapshot();
+    }
+
+    // 每个阶段边界读一次计数器，开销同样不计入上面的计时
+    if (options.profileCounters)
+    {
+        PerfProfiler profiler;
+        profiler.start();
+        {
+            PerfProfilerScope scope(profiler);
+            for (int i = 0; i < options.ticks; ++i)
+            {
+                counted.step();
+            }
+        }
+        profiler.stop();
+        result.counters = profiler.report;
+    }
+    return result;
+}
+
+void printBenchResult(const BenchResult &result)
+{
+    printf("ticks: %lld  vehicle updates: %lld  time: %.3fs\n", result.ticks, result.vehicleUpdates, result.seconds);
+    printf("per tick: %.1f ns  per vehicle: %.1f ns\n", result.nanosecondsPerTick(), result.nanosecondsPerVehicle());
+    if (!result.allocations.empty())
+    {
+        printAllocReport(result.allocations, result.allocTicks);
+    }
+    if (!result.counters.phases.empty())
+    {
+        printPerfReport(result.counters, result.ticks, result.vehicleUpdates);
+    }
+}
@@ -0,0 +1,34 @@
+﻿#include "Simulation.h"
+#include "AllocProfiler.h"
+#include "PerfCounters.h"
+
+// 基准测试选项
+struct BenchOptions
+{
+    int ticks = 2000;       // 推进的帧数
+    double density = 6;     // 热启动密度（辆/100米/车道）
+    uint64_t seed = 1;      // 随机种子
+    bool profileAllocations = true; // 计时后从同一状态再推进一遍，统计各阶段的内存分配
+    bool profileCounters = true;    // 再推进一遍，读取各阶段的硬件性能计数器（不可用时只计时）
+};
+
+// 基准测试结果
+struct BenchResult
+{
+    long long ticks;          // 推进的帧数
+    long long vehicleUpdates; // 所有帧的车辆数之和
+    double seconds;           // 总耗时（秒）
+    vector<AllocStats> allocations; // 各阶段的累计分配统计（profileAllocations时）
+    AllocTickTracker allocTicks;    // 逐帧分配统计
+    PerfReport counters;            // 各阶段的硬件计数器或计时（profileCounters时）
+
+    double nanosecondsPerTick() const { return ticks > 0 ? seconds * 1e9 / ticks : 0; }
+    double nanosecondsPerVehicle() const { return vehicleUpdates > 0 ? seconds * 1e9 / vehicleUpdates : 0; }
+};
+
+// 无界面推进仿真并计时，输出每帧和每辆车的平均更新耗时
+BenchResult runBenchmark(int windowWidth, int windowHeight, double scale, double widthScale, const BenchOptions &options);
+// 输出基准测试结果
+void printBenchResult(const BenchResult &result);
+
+#pragma once
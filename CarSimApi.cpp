@@ -0,0 +1,244 @@
+﻿#define CARSIM_BUILD // 本文件实现导出的接口
+#include <string>
+#include <exception>
+#include <algorithm>
+
+#include "CarSimApi.h"
+#include "Simulation.h"
+#include "Sweep.h"
+using namespace std;
+
+// 句柄内部就是一个仿真，C接口只做参数检查和异常拦截
+struct CarSim
+{
+    Simulation sim;
+
+    CarSim(int width, int height, double scale, double widthScale, uint64_t seed)
+        : sim(width, height, scale, widthScale, seed) {}
+};
+
+namespace
+{
+    string &lastError()
+    {
+        thread_local string message;
+        return message;
+    }
+
+    void setError(const char *message)
+    {
+        lastError() = message;
+    }
+
+    // 车辆数组中某个成员的列视图：跨度就是sizeof(Vehicle)
+    template <typename T>
+    SimColumn memberColumn(const vector<Vehicle> &vehicles, T Vehicle::*member, SimElementType type)
+    {
+        SimColumn column;
+        column.data = vehicles.empty() ? nullptr : &(vehicles.front().*member);
+        column.stride = sizeof(Vehicle);
+        column.count = vehicles.size();
+        column.elementType = type;
+        return column;
+    }
+}
+
+static_assert(sizeof(int) == sizeof(int32_t), "列视图按int32导出int成员");
+static_assert(sizeof(bool) == sizeof(uint8_t), "列视图按uint8导出bool成员");
+static_assert(sizeof(VehicleType) == sizeof(int32_t), "车型按int32导出");
+
+int sim_api_version(void)
+{
+    return CARSIM_API_VERSION;
+}
+
+CarSim *sim_create(int width, int height, double scale, double widthScale, uint64_t seed)
+{
+    if (width <= 0 || height <= 0 || scale <= 0 || widthScale <= 0)
+    {
+        setError("sim_create: 尺寸和比例必须为正数");
+        return nullptr;
+    }
+    try
+    {
+        CarSim *handle = new CarSim(width, height, scale, widthScale, seed);
+        handle->sim.params.logRelativeSpeed = false; // 嵌入使用时不向控制台输出
+        lastError().clear();
+        return handle;
+    }
+    catch (const exception &e)
+    {
+        setError(e.what());
+        return nullptr;
+    }
+}
+
+void sim_destroy(CarSim *sim)
+{
+    delete sim;
+}
+
+long long sim_step(CarSim *sim, long long n)
+{
+    if (sim == nullptr || n < 0)
+    {
+        setError("sim_step: 无效的句柄或帧数");
+        return 0;
+    }
+    long long done = 0;
+    try
+    {
+        for (; done < n; ++done)
+        {
+            sim->sim.step();
+        }
+        lastError().clear();
+    }
+    catch (const exception &e)
+    {
+        setError(e.what());
+    }
+    return done;
+}
+
+void sim_set_random_spawn(CarSim *sim, int enabled)
+{
+    if (sim == nullptr)
+        return;
+    if (enabled)
+        sim->sim.spawnSource = nullptr;
+    else
+        sim->sim.spawnSource = [](Simulation &) {};
+}
+
+int sim_spawn(CarSim *sim, int lane, int type, double lengthMetres, double widthMetres, double speedMetresPerSecond)
+{
+    if (sim == nullptr || lane < 0 || lane >= sim->sim.laneCount || type < 0 || type > 2 ||
+        lengthMetres <= 0 || widthMetres <= 0 || speedMetresPerSecond <= 0)
+    {
+        setError("sim_spawn: 参数无效");
+        return 0;
+    }
+    Simulation &s = sim->sim;
+    SpawnAttempt attempt;
+    attempt.id = 0;
+    attempt.lane = lane;
+    attempt.carwidth = max(1, (int)(widthMetres * s.scale * s.widthScale));
+    attempt.carlength = max(1, (int)(lengthMetres * s.scale));
+    attempt.vehicleType = type;
+    // 米/秒换算为像素/帧（每帧0.2秒），与到达记录回放一致
+    attempt.speed = max(1, (int)(speedMetresPerSecond * s.scale * 0.2 + 0.5));
+    try
+    {
+        if (!s.isSpawnSafe(attempt, s.vehicles))
+        {
+            setError("sim_spawn: 入口位置不安全");
+            return 0;
+        }
+        attempt.rngSeed = s.engine();
+        attempt.id = s.nextVehicleId++;
+        s.vehicles.push_back(s.makeVehicle(attempt));
+        lastError().clear();
+        return attempt.id;
+    }
+    catch (const exception &e)
+    {
+        setError(e.what());
+        return 0;
+    }
+}
+
+int sim_clear_lane(CarSim *sim, int lane)
+{
+    if (sim == nullptr || lane < 0 || lane >= sim->sim.laneCount)
+    {
+        setError("sim_clear_lane: 参数无效");
+        return -1;
+    }
+    size_t before = sim->sim.vehicles.size();
+    clearLane(sim->sim.vehicles, lane);
+    lastError().clear();
+    return (int)(before - sim->sim.vehicles.size());
+}
+
+int sim_set_param(CarSim *sim, const char *name, double value)
+{
+    if (sim == nullptr || name == nullptr || !setSimParam(sim->sim.params, name, value))
+    {
+        setError("sim_set_param: 未知参数");
+        return 0;
+    }
+    lastError().clear();
+    return 1;
+}
+
+double sim_time(const CarSim *sim)
+{
+    return sim != nullptr ? sim->sim.time : 0;
+}
+
+long long sim_tick(const CarSim *sim)
+{
+    return sim != nullptr ? sim->sim.tick : 0;
+}
+
+long long sim_exited_count(const CarSim *sim)
+{
+    return sim != nullptr ? sim->sim.exitedCount : 0;
+}
+
+long long sim_broken_count(const CarSim *sim)
+{
+    return sim != nullptr ? sim->sim.brokenDownCount : 0;
+}
+
+size_t sim_vehicle_count(const CarSim *sim)
+{
+    return sim != nullptr ? sim->sim.vehicles.size() : 0;
+}
+
+SimColumn sim_column(const CarSim *sim, int column)
+{
+    SimColumn empty = {nullptr, sizeof(Vehicle), 0, SIM_INT32};
+    if (sim == nullptr)
+        return empty;
+
+    const vector<Vehicle> &v = sim->sim.vehicles;
+    switch (column)
+    {
+    case SIM_COL_ID:
+        return memberColumn(v, &Vehicle::id, SIM_INT32);
+    case SIM_COL_LANE:
+        return memberColumn(v, &Vehicle::lane, SIM_INT32);
+    case SIM_COL_X:
+        return memberColumn(v, &Vehicle::x, SIM_INT32);
+    case SIM_COL_Y:
+        return memberColumn(v, &Vehicle::y, SIM_INT32);
+    case SIM_COL_SPEED:
+        return memberColumn(v, &Vehicle::speed, SIM_INT32);
+    case SIM_COL_LENGTH:
+        return memberColumn(v, &Vehicle::carlength, SIM_INT32);
+    case SIM_COL_WIDTH:
+        return memberColumn(v, &Vehicle::carwidth, SIM_INT32);
+    case SIM_COL_TYPE:
+        return memberColumn(v, &Vehicle::type, SIM_INT32);
+    case SIM_COL_CHANGING_LANE:
+        return memberColumn(v, &Vehicle::isChangingLane, SIM_UINT8);
+    case SIM_COL_TARGET_LANE:
+        return memberColumn(v, &Vehicle::targetLane, SIM_INT32);
+    case SIM_COL_CHANGE_PROGRESS:
+        return memberColumn(v, &Vehicle::changeProgress, SIM_FLOAT32);
+    case SIM_COL_BROKEN_DOWN:
+        return memberColumn(v, &Vehicle::isBrokenDown, SIM_UINT8);
+    case SIM_COL_TOO_CLOSE:
+        return memberColumn(v, &Vehicle::isTooClose, SIM_UINT8);
+    default:
+        setError("sim_column: 未知列");
+        return empty;
+    }
+}
+
+const char *sim_last_error(void)
+{
+    return lastError().c_str();
+}
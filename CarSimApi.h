@@ -0,0 +1,112 @@
+﻿#include <stddef.h>
+#include <stdint.h>
+
+// 嵌入用C接口：外部程序（C、Python ctypes等）创建并推进仿真，直接读取车辆状态
+//
+// 车辆状态通过列视图读取：sim_column返回首个元素的地址和相邻元素之间的字节跨度，
+// 视图直接指向仿真内部的车辆数组，不做复制。sim_step、sim_spawn、sim_clear_lane、
+// sim_destroy会改变车辆数组，之前取得的视图随之失效，需要重新获取。
+// 同一个仿真句柄不能被多个线程同时调用；不同句柄之间互不影响。
+
+#ifdef _WIN32
+#ifdef CARSIM_BUILD
+#define CARSIM_API __declspec(dllexport)
+#else
+#define CARSIM_API __declspec(dllimport)
+#endif
+#else
+#define CARSIM_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CARSIM_API_VERSION 1
+
+    // 仿真句柄
+    typedef struct CarSim CarSim;
+
+    // 列的元素类型
+    enum SimElementType
+    {
+        SIM_INT32 = 0,   // int32_t
+        SIM_FLOAT32 = 1, // float
+        SIM_UINT8 = 2    // uint8_t（布尔量：0或1）
+    };
+
+    // 可读取的车辆状态列
+    enum SimColumnId
+    {
+        SIM_COL_ID = 0,              // 车辆编号（int32，按编号递增排列）
+        SIM_COL_LANE = 1,            // 车道（int32）
+        SIM_COL_X = 2,               // x坐标，像素（int32）
+        SIM_COL_Y = 3,               // y坐标，像素（int32）
+        SIM_COL_SPEED = 4,           // 速度，像素/帧（int32，0表示抛锚）
+        SIM_COL_LENGTH = 5,          // 车长，像素（int32）
+        SIM_COL_WIDTH = 6,           // 车宽，像素（int32）
+        SIM_COL_TYPE = 7,            // 车型：0-小轿车，1-SUV，2-大卡车（int32）
+        SIM_COL_CHANGING_LANE = 8,   // 是否正在变道（uint8）
+        SIM_COL_TARGET_LANE = 9,     // 目标车道（int32）
+        SIM_COL_CHANGE_PROGRESS = 10, // 变道进度 0-1（float32）
+        SIM_COL_BROKEN_DOWN = 11,    // 是否抛锚（uint8）
+        SIM_COL_TOO_CLOSE = 12,      // 是否距离前车过近（uint8）
+        SIM_COLUMN_COUNT = 13
+    };
+
+    // 列视图：第i辆车的值位于 (const char *)data + i * stride
+    typedef struct SimColumn
+    {
+        const void *data; // 首个元素地址，没有车辆时为NULL
+        size_t stride;    // 相邻元素之间的字节数
+        size_t count;     // 元素个数（车辆数）
+        int elementType;  // SimElementType
+    } SimColumn;
+
+    // 接口版本（CARSIM_API_VERSION）
+    CARSIM_API int sim_api_version(void);
+
+    // 创建仿真：width、height为桥面像素尺寸，scale为每米像素数，widthScale为宽度方向的放大倍数
+    // 参数无效或内存不足时返回NULL
+    CARSIM_API CarSim *sim_create(int width, int height, double scale, double widthScale, uint64_t seed);
+    CARSIM_API void sim_destroy(CarSim *sim);
+
+    // 推进n帧（每帧0.2秒），返回实际推进的帧数
+    CARSIM_API long long sim_step(CarSim *sim, long long n);
+
+    // 是否按内置分布随机生成新车（默认开启）；关闭后只由sim_spawn生成
+    CARSIM_API void sim_set_random_spawn(CarSim *sim, int enabled);
+
+    // 在lane车道入口生成一辆车：type为车型，长宽单位米，速度单位米/秒
+    // 返回新车编号；入口位置不安全或参数无效时返回0
+    CARSIM_API int sim_spawn(CarSim *sim, int lane, int type, double lengthMetres, double widthMetres, double speedMetresPerSecond);
+
+    // 清除lane车道的所有车辆，返回清除的车辆数，参数无效时返回-1
+    CARSIM_API int sim_clear_lane(CarSim *sim, int lane);
+
+    // 修改运行时参数（名称同--sweep：safeDistance、crashDistance、wait、crash、
+    // sedanSafeFactor、suvSafeFactor、truckSafeFactor、spawnPeriod、maxPredictionSteps、
+    // minPredictionSteps、brakingDeceleration），未知名称返回0
+    CARSIM_API int sim_set_param(CarSim *sim, const char *name, double value);
+
+    // 仿真时钟（秒）和已推进的帧数
+    CARSIM_API double sim_time(const CarSim *sim);
+    CARSIM_API long long sim_tick(const CarSim *sim);
+    // 已驶离桥面的车辆数和因危险情况抛锚的车辆数
+    CARSIM_API long long sim_exited_count(const CarSim *sim);
+    CARSIM_API long long sim_broken_count(const CarSim *sim);
+    // 桥上的车辆数
+    CARSIM_API size_t sim_vehicle_count(const CarSim *sim);
+
+    // 取得一列的只读视图，column无效时返回count为0、data为NULL的视图
+    CARSIM_API SimColumn sim_column(const CarSim *sim, int column);
+
+    // 最近一次调用失败的原因（本线程），没有错误时返回空字符串
+    CARSIM_API const char *sim_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#pragma once
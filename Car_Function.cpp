@@ -1,73 +1,90 @@
-﻿#include <graphics.h>
+﻿#ifndef CAR_SIM_HEADLESS
+#include <graphics.h>
+#endif
 #include <vector>
 #include <ctime>
+#ifndef CAR_SIM_HEADLESS
 #include <conio.h> // 需要包含此头文件_kbhit()函数需要
 #include <Windows.h>
+#endif
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <cmath>
 
 #include "Random.h"
 #include "Class.h"
 #include "Define.h"
+#include "VehicleTypes.h"
+#include "Render.h"
 using namespace std;
 
-// 绘制变道轨迹（红色虚线）
-// 平滑变道函数
-bool Vehicle::smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicles)
+// 推进正在进行的变道，完成时返回true
+bool Vehicle::advanceLaneChange()
 {
-    // 如果车辆已抛锚，不能变道
-    if (isBrokenDown)
+    // 更新变道进度
+    changeProgress += laneChangeRate(); // 变道速度由车型决定
+
+    if (changeProgress >= 1.0f)
     {
-        return false;
+        // 变道完成
+        changeProgress = 1.0f;
+        isChangingLane = false;
+        isGoing2change = false;
+        lane = targetLane;
+        speed=speed*2; // 恢复速度
+        return true;
     }
 
-    if (isChangingLane)
-    {
-        // 更新变道进度
-        changeProgress += 0.02f;
+    // 使用固定的渐入渐出贝塞尔曲线计算垂直方向速度
+    // y(t) = 3t² - 2t³，这是一个平滑的S型曲线，在t=0和t=1处导数为0
+    float t = changeProgress;
+    float verticalSpeed = 3 * t * t - 2 * t * t * t;
 
-        if (changeProgress >= 1.0f)
-        {
-            // 变道完成
-            changeProgress = 1.0f;
-            isChangingLane = false;
-            isGoing2change = false;
-            lane = targetLane;
-            speed=speed*2; // 恢复速度
-            return true;
-        }
+    // 计算垂直方向上的位置变化
+    float deltaY = (endY - startY) * verticalSpeed;
+    y = startY + (int)deltaY;
 
-        // 使用固定的渐入渐出贝塞尔曲线计算垂直方向速度
-        // y(t) = 3t² - 2t³，这是一个平滑的S型曲线，在t=0和t=1处导数为0
-        float t = changeProgress;
-        float verticalSpeed = 3 * t * t - 2 * t * t * t;
+    // 水平方向保持原有速度
+    // 注意：x的更新在moveForward函数中处理
 
-        // 计算垂直方向上的位置变化
-        float deltaY = (endY - startY) * verticalSpeed;
-        y = startY + (int)deltaY;
+    return false;
+}
 
-        // 水平方向保持原有速度
-        // 注意：x的更新在moveForward函数中处理
+// 确定目标车道：边车道只能向中间变道，中间车道随机选择左右（消耗车辆自己的随机数）
+int Vehicle::chooseTargetLane()
+{
+    return currentLaneKernels().chooseTarget(*this);
+}
 
-        return false;
-    }
+// 预览chooseTargetLane将做出的选择，不改变车辆自己的随机数状态
+int Vehicle::previewTargetLane() const
+{
+    Vehicle copy = *this;
+    return copy.chooseTargetLane();
+}
 
-    // 确定目标车道
-    int tempTargetLane = 0;
-    if (lane == 0 || lane == 3)
-    {
-        tempTargetLane = lane + 1;
-    }
-    else if (lane == 2 || lane == 5)
-    {
-        tempTargetLane = lane - 1;
-    }
-    else if (lane == 1 || lane == 4)
+// 预测帧数：停车距离加安全距离所需的帧数，不短于变道所需的帧数
+int Vehicle::predictionHorizon() const
+{
+    const SimParams &params = simParams();
+    int maxSteps = max(1, params.maxPredictionSteps);
+    int minSteps = min(maxSteps, max(1, params.minPredictionSteps));
+    // 变道轨迹至少要覆盖整个变道过程
+    int steps = (int)ceil(1.0f / laneChangeRate());
+    int v = abs(speed);
+    if (v > 0 && params.brakingDeceleration > 0)
     {
-        tempTargetLane = lane + (rand() % 2 ? 1 : -1);
+        // 以当前速度制动到停下的距离加上车型的安全距离，按当前速度需要的帧数
+        double stopping = (double)v * v / (2 * params.brakingDeceleration);
+        steps = max(steps, (int)ceil((stopping + getSafeDistance()) / v));
     }
+    return min(maxSteps, max(minSteps, steps));
+}
 
+// 变道到targetLane的预测轨迹（当前位置 + steps步）
+VirtualVehicle Vehicle::laneChangePath(int target, int laneHeight, int steps) const
+{
     // 创建虚拟车辆用于轨迹预测
     VirtualVehicle virtualCar(x, y, carlength, carwidth);
 
@@ -77,14 +94,14 @@ bool Vehicle::smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicle
     // 预测变道轨迹
     int currentX = x;
     int currentY = y;
-    int targetY = laneHeight * tempTargetLane + (int)(0.5 * laneHeight);
-    int currentSpeed = (y < laneHeight * 3) ? speed : -speed;
+    int targetY = laneHeight * target + (int)(0.5 * laneHeight);
+    int currentSpeed = direction() * speed;
 
     // 预测变道轨迹
-    for (int i = 1; i <= 30; ++i)
+    for (int i = 1; i <= steps; ++i)
     {
         // 计算进度
-        float t = min(1.0f, i * 0.02f);
+        float t = min(1.0f, i * laneChangeRate());
 
         // 计算垂直位置
         float verticalSpeed = 3 * t * t - 2 * t * t * t;
@@ -97,66 +114,75 @@ bool Vehicle::smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicle
         // 添加到轨迹
         virtualCar.addTrajectoryPoint(newX, newY);
     }
+    return virtualCar;
+}
 
-    // 检查与其他车辆的轨迹是否相交
-    for (const auto &other : allVehicles)
-    {
-        if (&other == this)
-            continue; // 跳过自己
+// 其他车辆按当前状态行驶的预测轨迹（steps步）
+VirtualVehicle Vehicle::predictedPath(int steps) const
+{
+    // 为其他车辆创建虚拟车辆
+    VirtualVehicle otherVirtual(x, y, carlength, carwidth);
 
-        // 为其他车辆创建虚拟车辆
-        VirtualVehicle otherVirtual(other.x, other.y, other.carlength, other.carwidth);
+    // 判断其他车辆是否在变道中
+    if (isChangingLane)
+    {
+        // 如果其他车辆也在变道，预测其变道轨迹
+        float otherProgress = changeProgress;
+        int otherSpeed = direction() * speed;
 
-        // 判断其他车辆是否在变道中
-        if (other.isChangingLane)
+        // 预测其他车辆的变道轨迹
+        for (int i = 1; i <= steps; ++i)
         {
-            // 如果其他车辆也在变道，预测其变道轨迹
-            float otherProgress = other.changeProgress;
-            int otherStartX = other.startX;
-            int otherStartY = other.startY;
-            int otherEndX = other.endX;
-            int otherEndY = other.endY;
-            int otherSpeed = (other.y < laneHeight * 3) ? other.speed : -other.speed;
-
-            // 预测其他车辆的变道轨迹
-            for (int i = 1; i <= 30; ++i)
-            {
-                // 更新进度
-                float t = min(1.0f, otherProgress + i * 0.02f);
+            // 更新进度
+            float t = min(1.0f, otherProgress + i * laneChangeRate());
 
-                // 计算垂直位置
-                float verticalSpeed = 3 * t * t - 2 * t * t * t;
-                float deltaY = (otherEndY - otherStartY) * verticalSpeed;
-                int newY = otherStartY + (int)deltaY;
+            // 计算垂直位置
+            float verticalSpeed = 3 * t * t - 2 * t * t * t;
+            float deltaY = (endY - startY) * verticalSpeed;
+            int newY = startY + (int)deltaY;
 
-                // 计算水平位置（保持原有速度）
-                int newX = other.x + i * otherSpeed;
+            // 计算水平位置（保持原有速度）
+            int newX = x + i * otherSpeed;
 
-                // 添加到轨迹
-                otherVirtual.addTrajectoryPoint(newX, newY);
-            }
+            // 添加到轨迹
+            otherVirtual.addTrajectoryPoint(newX, newY);
         }
-        else
+    }
+    else
+    {
+        // 其他车辆直线行驶，预测其直线轨迹
+        int otherSpeed = direction() * speed;
+        for (int i = 1; i <= steps; ++i)
         {
-            // 其他车辆直线行驶，预测其直线轨迹
-            int otherSpeed = (other.y < laneHeight * 3) ? other.speed : -other.speed;
-            for (int i = 1; i <= 30; ++i)
-            {
-                int newX = other.x + i * otherSpeed;
-                otherVirtual.addTrajectoryPoint(newX, other.y);
-            }
-        }
-
-        // 检查轨迹是否相交
-        if (virtualCar.isTrajectoryIntersecting(otherVirtual, 30))
-        {
-            isGoing2change = false; // 取消准备变道状态
-            return false;           // 轨迹相交，变道不安全，取消变道
+            int newX = x + i * otherSpeed;
+            otherVirtual.addTrajectoryPoint(newX, y);
         }
     }
+    return otherVirtual;
+}
+
+// predictedPath的外接矩形：x在第1步和第steps步之间，变道中的y在起止位置之间
+TrajectoryBox Vehicle::predictedBox(int steps) const
+{
+    int step = direction() * speed;
+    int first = x + step, last = x + steps * step;
+    int top = isChangingLane ? min(startY, endY) : y;
+    int bottom = isChangingLane ? max(startY, endY) : y;
+    return TrajectoryBox{min(first, last) - carlength / 2, top - carwidth / 2, max(first, last) + carlength / 2,
+                         bottom + carwidth / 2};
+}
 
-    // 变道安全，设置目标车道和变道参数
-    targetLane = tempTargetLane;
+bool trajectoryConflicts(const VirtualVehicle &path, const TrajectoryBox &box, const Vehicle &other, int steps)
+{
+    if (!box.intersects(other.predictedBox(steps)))
+        return false; // 整段轨迹都碰不到
+    return path.isTrajectoryIntersecting(other.predictedPath(steps), steps);
+}
+
+// 开始变道：设置目标车道和变道参数
+void Vehicle::startLaneChange(int target, int laneHeight)
+{
+    targetLane = target;
     startX = x;
     startY = y;
     endX = x + 25; // 向前移动50像素
@@ -165,12 +191,58 @@ bool Vehicle::smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicle
     // 开始变道
     isChangingLane = true;
     changeProgress = 0.0f;
+}
+
+// 平滑变道函数（单车判断，逐一检查所有车辆；仿真中使用LaneChange.h的批量判断）
+bool Vehicle::smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicles)
+{
+    // 如果车辆已抛锚，不能变道
+    if (isBrokenDown)
+    {
+        return false;
+    }
+
+    if (isChangingLane)
+    {
+        return advanceLaneChange();
+    }
+
+    int tempTargetLane = chooseTargetLane();
+    if (tempTargetLane < 0)
+    {
+        isGoing2change = false; // 所在方向只有一条车道
+        return false;
+    }
+    int steps = predictionHorizon();
+    VirtualVehicle virtualCar = laneChangePath(tempTargetLane, laneHeight, steps);
+    TrajectoryBox box = virtualCar.bounds();
+
+    // 检查与其他车辆的轨迹是否相交
+    for (const auto &other : allVehicles)
+    {
+        if (other.id == id)
+            continue; // 跳过自己
+
+        // 检查轨迹是否相交
+        if (trajectoryConflicts(virtualCar, box, other, steps))
+        {
+            isGoing2change = false; // 取消准备变道状态
+            return false;           // 轨迹相交，变道不安全，取消变道
+        }
+    }
+
+    // 变道安全，开始变道
+    startLaneChange(tempTargetLane, laneHeight);
     return false;
 }
 
 // 预测并绘制轨迹
-void Vehicle::predictAndDrawTrajectory(int laneHeight, int middleY, int predictionSteps, const vector<Vehicle> &allVehicles) const
+void Vehicle::predictAndDrawTrajectory(int predictionSteps, const vector<Vehicle> &allVehicles) const
 {
+    if (predictionSteps <= 0)
+    {
+        predictionSteps = predictionHorizon();
+    }
     // 创建虚拟车辆
     VirtualVehicle virtualCar(x, y, carlength, carwidth);
 
@@ -180,7 +252,7 @@ void Vehicle::predictAndDrawTrajectory(int laneHeight, int middleY, int predicti
     // 预测未来轨迹
     int currentX = x;
     int currentY = y;
-    int currentSpeed = (y < middleY) ? speed : -speed;
+    int currentSpeed = direction() * speed;
 
     // 如果正在变道，预测变道轨迹
     if (isChangingLane)
@@ -196,7 +268,7 @@ void Vehicle::predictAndDrawTrajectory(int laneHeight, int middleY, int predicti
         for (int i = 1; i <= predictionSteps; ++i)
         {
             // 更新进度
-            float t = min(1.0f, currentProgress + i * 0.02f);
+            float t = min(1.0f, currentProgress + i * laneChangeRate());
 
             // 计算垂直位置
             float verticalSpeed = 3 * t * t - 2 * t * t * t;
@@ -222,16 +294,25 @@ void Vehicle::predictAndDrawTrajectory(int laneHeight, int middleY, int predicti
 
     // 检查与其他车辆的轨迹是否相交
     bool isSafe = true;
+    TrajectoryBox box = virtualCar.bounds();
     for (const auto &other : allVehicles)
     {
-        if (&other == this)
+        if (other.id == id)
             continue; // 跳过自己
 
+        // 先比较整段直线轨迹的外接矩形
+        int otherStep = other.direction() * other.speed;
+        int otherFirst = other.x + otherStep, otherLast = other.x + predictionSteps * otherStep;
+        TrajectoryBox otherBox = {min(otherFirst, otherLast) - other.carlength / 2, other.y - other.carwidth / 2,
+                                  max(otherFirst, otherLast) + other.carlength / 2, other.y + other.carwidth / 2};
+        if (!box.intersects(otherBox))
+            continue;
+
         // 为其他车辆创建虚拟车辆
         VirtualVehicle otherVirtual(other.x, other.y, other.carlength, other.carwidth);
 
         // 预测其他车辆的直线行驶轨迹
-        int otherSpeed = (other.y < middleY) ? other.speed : -other.speed;
+        int otherSpeed = other.direction() * other.speed;
         for (int i = 1; i <= predictionSteps; ++i)
         {
             int newX = other.x + i * otherSpeed;
@@ -261,102 +342,23 @@ bool Vehicle::isLaneChangeSafe(int laneHeight, const vector<Vehicle> &allVehicle
         return true;
     }
 
-    // 确定目标车道
-    int target = 0;
-    if (lane == 0 || lane == 3)
-    {
-        target = lane + 1;
-    }
-    else if (lane == 2 || lane == 5)
+    int target = previewTargetLane();
+    if (target < 0)
     {
-        target = lane - 1;
-    }
-    else if (lane == 1 || lane == 4)
-    {
-        target = lane + (rand() % 2 ? 1 : -1);
-    }
-
-    // 创建虚拟车辆用于轨迹预测
-    VirtualVehicle virtualCar(x, y, carlength, carwidth);
-
-    // 添加当前位置
-    virtualCar.addTrajectoryPoint(x, y);
-
-    // 预测变道轨迹
-    int currentX = x;
-    int currentY = y;
-    int targetY = laneHeight * target + (int)(0.5 * laneHeight);
-    int currentSpeed = (y < laneHeight * 3) ? speed : -speed;
-
-    // 预测变道轨迹
-    for (int i = 1; i <= 30; ++i)
-    {
-        // 计算进度
-        float t = min(1.0f, i * 0.02f);
-
-        // 计算垂直位置
-        float verticalSpeed = 3 * t * t - 2 * t * t * t;
-        float deltaY = (targetY - currentY) * verticalSpeed;
-        int newY = currentY + (int)deltaY;
-
-        // 计算水平位置（保持原有速度）
-        int newX = currentX + i * currentSpeed;
-
-        // 添加到轨迹
-        virtualCar.addTrajectoryPoint(newX, newY);
+        return false; // 所在方向只有一条车道
     }
+    int steps = predictionHorizon();
+    VirtualVehicle virtualCar = laneChangePath(target, laneHeight, steps);
+    TrajectoryBox box = virtualCar.bounds();
 
     // 检查与其他车辆的轨迹是否相交
     for (const auto &other : allVehicles)
     {
-        if (&other == this)
+        if (other.id == id)
             continue; // 跳过自己
 
-        // 为其他车辆创建虚拟车辆
-        VirtualVehicle otherVirtual(other.x, other.y, other.carlength, other.carwidth);
-
-        // 判断其他车辆是否在变道中
-        if (other.isChangingLane)
-        {
-            // 如果其他车辆也在变道，预测其变道轨迹
-            float otherProgress = other.changeProgress;
-            int otherStartX = other.startX;
-            int otherStartY = other.startY;
-            int otherEndX = other.endX;
-            int otherEndY = other.endY;
-            int otherSpeed = (other.y < laneHeight * 3) ? other.speed : -other.speed;
-
-            // 预测其他车辆的变道轨迹
-            for (int i = 1; i <= 30; ++i)
-            {
-                // 更新进度
-                float t = min(1.0f, otherProgress + i * 0.02f);
-
-                // 计算垂直位置
-                float verticalSpeed = 3 * t * t - 2 * t * t * t;
-                float deltaY = (otherEndY - otherStartY) * verticalSpeed;
-                int newY = otherStartY + (int)deltaY;
-
-                // 计算水平位置（保持原有速度）
-                int newX = other.x + i * otherSpeed;
-
-                // 添加到轨迹
-                otherVirtual.addTrajectoryPoint(newX, newY);
-            }
-        }
-        else
-        {
-            // 其他车辆直线行驶，预测其直线轨迹
-            int otherSpeed = (other.y < laneHeight * 3) ? other.speed : -other.speed;
-            for (int i = 1; i <= 30; ++i)
-            {
-                int newX = other.x + i * otherSpeed;
-                otherVirtual.addTrajectoryPoint(newX, other.y);
-            }
-        }
-
         // 检查轨迹是否相交
-        if (virtualCar.isTrajectoryIntersecting(otherVirtual, 30))
+        if (trajectoryConflicts(virtualCar, box, other, steps))
         {
             return false; // 轨迹相交，变道不安全
         }
@@ -365,110 +367,87 @@ bool Vehicle::isLaneChangeSafe(int laneHeight, const vector<Vehicle> &allVehicle
     return true; // 轨迹不相交，变道安全
 }
 
-// 检查与前车距离
-void Vehicle::checkFrontVehicleDistance(vector<Vehicle> &allVehicles, int safeDistance)
+// 检查与前车距离：沿行驶方向找到快照中第一辆足够近的同车道前车（按当前布局的内核）
+void Vehicle::checkFrontVehicleDistance(const vector<Vehicle> &allVehicles, int safeDistance, vector<int> &crashedIds)
 {
-    // 遍历所有车辆，寻找同一车道的前方车辆
-    for (auto &other : allVehicles)
-    {
-        // 跳过自己
-        if (&other == this)
-            continue;
-
-        // 检查是否在同一车道
-        if (other.lane != lane)
-            continue;
-
-        // 判断方向：上方车道(0,1,2)向右行驶，下方车道(3,4,5)向左行驶
-        bool isMovingRight = (lane < 3);
+    currentLaneKernels().checkFront(*this, allVehicles, safeDistance, crashedIds);
+}
 
-        // 检查是否为前方车辆
-        bool isFrontVehicle = false;
-        if (isMovingRight)
-        {
-            // 向右行驶，x坐标更大的车是前车
-            isFrontVehicle = (other.x > x);
-        }
-        else
+// 对前车做出反应：距离不超过安全距离时减速或准备变道，不超过碰撞距离时两车都抛锚
+void Vehicle::reactToFrontVehicle(const Vehicle &other, int distance, int safeDistance, vector<int> &crashedIds)
+{
+    const SimParams &params = simParams();
+    // 如果距离小于等于安全距离，进行进一步处理
+    if ((distance <= safeDistance) && (distance > params.crashDistance))
+    {
+        showFlashingFrame();
+        // 计算相对速度
+        int relativeSpeed = abs(speed - other.speed);
+        if (relativeSpeed != 0 && params.logRelativeSpeed)
         {
-            // 向左行驶，x坐标更小的车是前车
-            isFrontVehicle = (other.x < x);
+            cout << "Relative Speed: " << relativeSpeed << endl;
         }
-
-        if (!isFrontVehicle)
-            continue;
-
-        // 计算两车之间的距离
-        int distance = abs(other.x - x) - (other.carlength / 2 + carlength / 2);
-
-        // 如果距离小于等于安全距离，进行进一步处理
-        if ((distance <= safeDistance) && (distance > CRASH_DISTANCE))
+        // 根据相对速度采取不同措施
+        if (relativeSpeed <= params.wait)
         {
-            showFlashingFrame();
-            // 计算相对速度
-            int relativeSpeed = abs(speed - other.speed);
-            if (relativeSpeed != 0)
-            {
-                cout << "Relative Speed: " << relativeSpeed << endl;
-            }
-            // 根据相对速度采取不同措施
-            if (relativeSpeed <= WAIT)
+            // 如果相对速度小于等于WAIT，将后车速度设为前车速度
+            if (relativeSpeed > params.wait / 2)
             {
-                // 如果相对速度小于等于WAIT，将后车速度设为前车速度
-                if (relativeSpeed > WAIT/2)
-                {
-                    speed = speed -5;
-                }
-                else
-                {
-                    speed = other.speed;
-                }
+                speed = speed -5;
             }
-            if (relativeSpeed > WAIT && relativeSpeed <= CRASH)
+            else
             {
-                isGoing2change = true;
-                if (other.speed != 0)
-                {
-                    speed = speed / 2;
-                }
+                speed = other.speed;
             }
-            return; // 找到最近的前车后即可返回
         }
-        else if (distance <= CRASH_DISTANCE)
+        if (relativeSpeed > params.wait && relativeSpeed <= params.crash)
         {
-            showFlashingFrame();
-            // 计算相对速度
-            int relativeSpeed = abs(speed - other.speed);
-            if (relativeSpeed != 0)
+            isGoing2change = true;
+            if (other.speed != 0)
             {
-                cout << "Relative Speed:CRASH " << relativeSpeed << endl;
+                speed = speed / 2;
             }
-            other.handleDangerousSituation();
-            handleDangerousSituation();
-            return; // 找到最近的前车后即可返回
         }
     }
+    else if (distance <= params.crashDistance)
+    {
+        showFlashingFrame();
+        // 计算相对速度
+        int relativeSpeed = abs(speed - other.speed);
+        if (relativeSpeed != 0 && params.logRelativeSpeed)
+        {
+            cout << "Relative Speed:CRASH " << relativeSpeed << endl;
+        }
+        crashedIds.push_back(other.id); // 前车在本阶段结束后统一进入抛锚状态
+        handleDangerousSituation();
+    }
 }
 
-// 显示橘色线框
+// 标记需要显示橘色线框（由绘制阶段画出，仿真本身不直接绘图）
 void Vehicle::showFlashingFrame()
+{
+    isFlashing = true;
+}
+
+// 绘制橘色线框
+void Vehicle::drawFlashingFrame() const
 {
     // 保存当前线型和颜色
-    LINESTYLE oldLineStyle;
-    getlinestyle(&oldLineStyle);
-    COLORREF oldLineColor = getlinecolor();
+    int oldStyle, oldThickness;
+    render::getlinestyle(oldStyle, oldThickness);
+    COLORREF oldLineColor = render::getlinecolor();
 
     // 设置橘色线框
-    setlinecolor(RGB(255, 165, 0)); // 橙色
-    setlinestyle(PS_SOLID, 2);      // 实线，线宽为2
+    render::setlinecolor(RGB(255, 165, 0)); // 橙色
+    render::setlinestyle(PS_SOLID, 2);      // 实线，线宽为2
 
     // 绘制车辆周围的橘色线框
-    rectangle(x - carlength / 2 - 5, y - carwidth / 2 - 5,
+    render::rectangle(x - carlength / 2 - 5, y - carwidth / 2 - 5,
               x + carlength / 2 + 5, y + carwidth / 2 + 5);
 
     // 恢复原来的线型和颜色
-    setlinestyle(oldLineStyle.style, oldLineStyle.thickness);
-    setlinecolor(oldLineColor);
+    render::setlinestyle(oldStyle, oldThickness);
+    render::setlinecolor(oldLineColor);
 }
 
 // 处理危险情况
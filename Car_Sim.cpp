@@ -6,248 +6,771 @@
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <chrono>
+#include <memory>
 
 #include "Random.h"
 #include "Class.h"
 #include "Define.h"
 #include "VehicleTypes.h"
+#include "Simulation.h"
+#include "Sweep.h"
+#include "Bench.h"
+#include "Domain.h"
+#include "Scene.h"
+#include "FrameExport.h"
+#include "Hybrid.h"
+#include "Pipeline.h"
+#include "Trace.h"
+#include "EventEngine.h"
+#include "SpaceTime.h"
+#include "Recording.h"
+#include "SafetyMetrics.h"
+#include "SoftRaster.h"
+#include "FrameGovernor.h"
+#include "RenderBatch.h"
 using namespace std;
 
-// 函数声明：清除指定车道的所有车辆
-int main()
+// 无界面参数扫描：比较不同安全距离和速度差阈值下的通过量与事故率
+int runSweepCommand(const Bridge &bridge)
 {
-    Bridge bridge;
-    // 输入桥梁参数
-    // cout << "请输入桥长（m）: ";
-    // cin >> bridge.bridgeLength;
-    // cout << "请输入桥宽（m）: ";
-    // cin >> bridge.bridgeWidth;
-    // cout << "请输入桥宽放大率: ";
-    // cin >> bridge.widthScale;
-    bridge.bridgeLength = 100;
-    bridge.bridgeWidth = 50;
-    bridge.widthScale = 1;
-    // 调用桥梁绘制函数计算窗口大小
     int windowWidth, windowHeight;
     double scale;
-    bridge.calculateWindowSize(windowWidth, windowHeight, scale);
+    bridge.computeWindowSize(windowWidth, windowHeight, scale);
+
+    vector<SweepAxis> axes = {
+        {"safeDistance", {100, 150, 200}},
+        {"wait", {20, 30, 40}},
+        {"truckSafeFactor", {1.2, 1.5, 1.8}},
+    };
+    SweepOptions options;
+    vector<SweepResult> results = runSweep(windowWidth, windowHeight, scale, bridge.widthScale, axes, options);
+    printSweepTable(results, axes);
+    return 0;
+}
+
+// 无界面基准测试：测量每辆车的平均更新耗时
+int runBenchCommand(const Bridge &bridge)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.computeWindowSize(windowWidth, windowHeight, scale);
+
+    BenchResult result = runBenchmark(windowWidth, windowHeight, scale, bridge.widthScale, BenchOptions());
+    printBenchResult(result);
+    return 0;
+}
+
+// 分域多进程运行：把20倍桥长的长走廊分给多个进程，并与单进程结果比较
+int runDomainCommand(const Bridge &bridge, int domains, int ticks)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.computeWindowSize(windowWidth, windowHeight, scale);
+
+    DomainConfig config;
+    config.domains = domains;
+    config.ticks = ticks;
+    config.corridorWidth = windowWidth * 20;
+    config.windowHeight = windowHeight;
+    config.scale = scale;
+    config.widthScale = bridge.widthScale;
+    return runDomainLauncher(config);
+}
+
+// 混合仿真：桥面逐车仿真，上下游各metres米远场路段用元胞传输模型，并与全微观仿真比较耗时
+int runHybridCommand(const Bridge &bridge, double metres, int ticks, int spawnPeriod)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.computeWindowSize(windowWidth, windowHeight, scale);
+
+    MesoConfig config;
+    config.upstreamLength = metres;
+    config.downstreamLength = metres;
+    config.spawnPeriod = spawnPeriod;
+    HybridReport report = runHybridComparison(windowWidth, windowHeight, scale, bridge.widthScale, config, ticks, 1);
+    printHybridReport(report);
+    return 0;
+}
+
+// 离散事件推进：稀疏交通下与逐帧推进比较事件和耗时
+int runEventsCommand(const Bridge &bridge, long long ticks, int spawnPeriod)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.computeWindowSize(windowWidth, windowHeight, scale);
+
+    EventComparison report = runEventComparison(windowWidth, windowHeight, scale, bridge.widthScale, spawnPeriod, ticks, 1);
+    printEventComparison(report);
+    return report.identicalState ? 0 : 1;
+}
+
+// 无界面运行并导出每条车道的时空图（热力图PNG和原始数组spacetime.bin）
+int runSpaceTimeCommand(const Bridge &bridge, const string &directory, long long ticks, int spawnPeriod)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.computeWindowSize(windowWidth, windowHeight, scale);
+
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, 1);
+    sim.params.logRelativeSpeed = false;
+    sim.params.spawnPeriod = spawnPeriod;
+    SpaceTimeAccumulator accumulator(sim.laneCount, windowWidth);
+    while (sim.tick < ticks)
+    {
+        sim.step();
+        accumulator.record(sim);
+    }
+
+    bool ok = accumulator.exportRaw(directory + "/spacetime.bin") && accumulator.exportHeatmaps(directory, sim.laneKernels.topology);
+    printf("lanes: %d  cells: %d  buckets: %lld (from %lld)  memory: %.1f MB\n", accumulator.laneCount,
+           accumulator.cellCount, accumulator.bucketsStored(), accumulator.firstBucket,
+           accumulator.cells.size() * sizeof(SpaceTimeCell) / 1048576.0);
+    if (!ok)
+        printf("cannot write to %s\n", directory.c_str());
+    return ok ? 0 : 1;
+}
+
+// 无界面运行并统计替代安全指标（TTC、PET、DRAC）的分布
+int runSafetyCommand(const Bridge &bridge, long long ticks, int spawnPeriod)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.computeWindowSize(windowWidth, windowHeight, scale);
+
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, 1);
+    sim.params.logRelativeSpeed = false;
+    sim.params.spawnPeriod = spawnPeriod;
+    SafetyMonitor monitor;
+    while (sim.tick < ticks)
+    {
+        sim.step();
+        monitor.record(sim);
+    }
+    printSafetyMetrics(monitor.metrics);
+    return 0;
+}
+
+// 无界面运行并记录每一帧，结束时写入旁路索引（文件名 + ".idx"）
+int runRecordCommand(const Bridge &bridge, const string &path, long long ticks, int spawnPeriod)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.computeWindowSize(windowWidth, windowHeight, scale);
 
-    vector<Vehicle> vehicles;
-    srand(unsigned int(time(0)));
-    double time = 0;
-    // 车辆长宽的分布，随机数取值
-    normal_distribution<> normalwidth(3, 0.1);  // 车的宽度  这里用了正态分布
-    normal_distribution<> normallength(6, 0.1); // 车辆长度  这里用了正态分布
-    uniform_int_distribution<int> int_dist(20, 120);
-    RandomGenerator rng(int_dist);
-    while (!_kbhit())
-    {
-        cleardevice();
-        // 显示桥的参数信息
-        wchar_t info[256];
-        swprintf_s(info, L"桥长： %.0fm  桥宽：%.0fm  桥宽放大率： %.1f", bridge.bridgeLength, bridge.bridgeWidth, bridge.widthScale);
-        settextstyle(20, 0, L"Arial");
-        outtextxy(10, 10, info);
-        // 显示时间
-        wchar_t info2[256];
-        swprintf_s(info2, L"时间： %.0fs", time);
-        settextstyle(20, 0, L"Arial");
-        outtextxy(windowWidth - 150, 10, info2);
-
-        // 绘制车道
-        setlinecolor(WHITE);                              // 设置线条为白色
-        settextcolor(WHITE);                              // 设置文字为白色
-        int laneCount = 6;                                // 车道数量
-        int laneHeight = (int)(windowHeight / laneCount); // 车道像素宽度
-        for (int i = 0; i < laneCount - 1; ++i)
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, 1);
+    sim.params.logRelativeSpeed = false;
+    sim.params.spawnPeriod = spawnPeriod;
+    RunRecorder recorder;
+    if (!recorder.open(path, sim))
+    {
+        printf("cannot create %s\n", path.c_str());
+        return 1;
+    }
+    auto start = chrono::steady_clock::now();
+    while (sim.tick < ticks)
+    {
+        sim.step();
+        recorder.record(sim);
+    }
+    uint64_t bytes = recorder.offset;
+    size_t chunks = recorder.chunks.size() + (recorder.chunkOpen ? 1 : 0);
+    size_t vehicles = recorder.postings.size();
+    if (!recorder.close())
+    {
+        printf("write failed: %s\n", path.c_str());
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("recorded %lld ticks: %.1f MB, %zu chunks, %zu vehicles, %.2f s\n", ticks, bytes / 1048576.0, chunks,
+           vehicles, seconds);
+    return 0;
+}
+
+// 查询运行记录：
+//   events 类型 t0 t1 [车道]  某段时间内的事件（enter/exit/lanechange/crash/nearmiss）
+//   vehicle id               一辆车的轨迹
+//   frames t0 t1             某段时间内每帧的概况
+int runQueryCommand(int argc, char **argv)
+{
+    RunReader reader;
+    string error;
+    if (!reader.open(argv[2], error))
+    {
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+    string mode = argv[3];
+    auto start = chrono::steady_clock::now();
+    auto elapsed = [&]() { return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(); };
+
+    if (mode == "events" && argc > 6)
+    {
+        RecordedEventKind kind;
+        if (!parseRecordedEventKind(argv[4], kind))
         {
-            drawDashedLine(0, (i + 1) * laneHeight, windowWidth, (i + 1) * laneHeight);
+            printf("unknown event type %s\n", argv[4]);
+            return 1;
         }
-        // 绘制箭头和可视化按钮
-        for (int i = 0; i < laneCount; ++i)
+        vector<RecordedEvent> events = reader.index.findEvents(kind, atof(argv[5]), atof(argv[6]), argc > 7 ? atoi(argv[7]) : -1);
+        double ms = elapsed();
+        for (const RecordedEvent &e : events)
         {
-            // 绘制按钮背景
-            int buttonX = 5;
-            int buttonY = laneHeight * i + (int)(0.5 * laneHeight) - (int)(laneHeight / 4);
-            int buttonWidth = 40;
-            int buttonHeight = (int)(laneHeight / 2);
-
-            // 设置按钮颜色
-            setfillcolor(RGB(70, 70, 70));    // 深灰色背景
-            setlinecolor(RGB(200, 200, 200)); // 浅灰色边框
-            fillrectangle(buttonX, buttonY, buttonX + buttonWidth, buttonY + buttonHeight);
-
-            // 绘制箭头
-            settextstyle((int)(laneHeight / 2), 0, L"Arial");
-            settextcolor(WHITE);
-            outtextxy(buttonX + 10, buttonY, i < laneCount / 2 ? L"→" : L"←");
+            printf("%10.1f  tick %-10lld  vehicle %-8d lane %d  x %-5d speed %d\n", e.time, (long long)e.tick,
+                   e.vehicleId, e.lane, e.x, e.speed);
         }
-
-        // 检查鼠标点击
-        if (MouseHit())
+        printf("%zu %s events, %.3f ms\n", events.size(), recordedEventName(kind), ms);
+        return 0;
+    }
+    if (mode == "vehicle" && argc > 4)
+    {
+        int id = atoi(argv[4]);
+        vector<VehicleSample> samples = reader.vehicleHistory(id);
+        double ms = elapsed();
+        for (const VehicleSample &s : samples)
         {
-            MOUSEMSG msg = GetMouseMsg();
-            if (msg.uMsg == WM_LBUTTONDOWN)
+            printf("%10.1f  tick %-10lld  lane %d  x %-5d speed %-4d flags %d\n", s.time, (long long)s.tick,
+                   s.state.lane, s.state.x, s.state.speed, s.state.flags);
+        }
+        const IndexVehicle *entry = reader.index.findVehicle(id);
+        printf("vehicle %d: %zu samples in %u chunks, %.3f ms\n", id, samples.size(),
+               entry != nullptr ? entry->postingCount : 0, ms);
+        return 0;
+    }
+    if (mode == "frames" && argc > 5)
+    {
+        double t0 = atof(argv[4]), t1 = atof(argv[5]);
+        uint64_t first, last;
+        reader.index.chunksInTime(t0, t1, first, last);
+        long long frames = 0;
+        for (uint64_t c = first; c < last; ++c)
+        {
+            reader.forEachFrame(reader.index.chunks()[c], [&](const RecordedFrame &frame, const LiveVehicle *vehicles)
             {
-                // 检查点击是否在按钮区域
-                if (msg.x < 45)
+                if (frame.time < t0 || frame.time > t1)
+                    return;
+                int flagged = 0;
+                long long speedSum = 0;
+                for (uint32_t i = 0; i < frame.count; ++i)
                 {
-                    // 计算点击所在的车道
-                    int clickedLane = msg.y / laneHeight;
-                    if (clickedLane >= 0 && clickedLane < laneCount)
-                    {
-                        // 清除该车道上的所有车辆
-                        clearLane(vehicles, clickedLane);
-                    }
+                    speedSum += vehicles[i].speed;
+                    flagged += (vehicles[i].flags & (LIVE_BROKEN_DOWN | LIVE_FLASHING)) != 0;
                 }
-            }
+                printf("%10.1f  tick %-10lld  vehicles %-4u mean speed %-6.2f flagged %d\n", frame.time,
+                       (long long)frame.tick, frame.count, frame.count ? (double)speedSum / frame.count : 0.0, flagged);
+                ++frames;
+            });
         }
+        printf("%lld frames from %llu chunks, %.3f ms\n", frames, (unsigned long long)(last - first), elapsed());
+        return 0;
+    }
+    printf("usage: --query file events type t0 t1 [lane] | vehicle id | frames t0 t1\n");
+    return 1;
+}
 
-        // 生成新车
-        if (rand() % 10 == 0)
-        {                          // 判断要不要产生新的一辆车
-            int lane = rand() % 6; // 如果有车，车辆的随机位置
+// 到达记录CSV转换为二进制格式
+int runTraceConvertCommand(const char *csvPath, const char *tracePath)
+{
+    string error;
+    if (!convertTraceCsv(csvPath, tracePath, error))
+    {
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}
 
-            // 检查新车位置是否安全
-            int newX = lane < 3 ? 0 : windowWidth;
-            int newY = laneHeight * lane + (int)(0.5 * laneHeight);
-            bool isPositionSafe = true;
-            int carwidth = RandomGenerator{normalwidth}() * scale * bridge.widthScale;
-            int carlength = RandomGenerator{normallength}() * scale;
+// 无界面回放到达记录：推进到记录全部进入桥面或达到帧数上限
+int runTraceReplayCommand(const Bridge &bridge, const char *tracePath, long long maxTicks)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.computeWindowSize(windowWidth, windowHeight, scale);
 
-            // 检查与现有车辆的距离
-            for (const auto &existingVehicle : vehicles)
-            {
-                // 只检查同一车道的车辆
-                if (existingVehicle.lane != lane)
-                    continue;
+    TraceDemand demand;
+    string error;
+    if (!demand.open(tracePath, error))
+    {
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, 1);
+    sim.params.logRelativeSpeed = false;
+    sim.spawnSource = [&demand](Simulation &s) { demand.spawnDue(s); };
 
-                // 计算两车之间的距离
-                int distance = abs(existingVehicle.x - newX) - (existingVehicle.carlength / 2 + carlength / 2);
+    auto start = chrono::steady_clock::now();
+    while (!demand.finished() && (maxTicks <= 0 || sim.tick < maxTicks))
+    {
+        sim.step();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("records: %llu  released: %lld  spawned: %lld  waiting: %zu  rejected (lane outside layout): %lld\n",
+           (unsigned long long)demand.reader.recordCount, demand.released, demand.spawned, demand.waitingCount(),
+           demand.rejected);
+    printf("deferred (read late, %zu vehicles already waiting): %lld\n", demand.maxWaiting, demand.deferred);
+    printf("ticks: %lld  simulated: %.1fs  time: %.2fs  (%.0f ticks/s)  read-ahead stalls: %lld\n",
+           sim.tick, sim.time, seconds, sim.tick / max(seconds, 1e-9), demand.reader.stalls);
+    if (demand.reader.failed)
+    {
+        printf("%s: cannot map records from %llu on, replay stopped early\n", tracePath,
+               (unsigned long long)demand.reader.position);
+        return 1;
+    }
+    return 0;
+}
 
-                // 如果距离小于安全距离，位置不安全
-                if (distance < SAFE_DISTANCE)
-                {
-                    isPositionSafe = false;
-                    break;
-                }
-            }
+// 离线导出视频帧：不按60ms的界面节奏，绘制到离屏图像后交给后台线程编码写盘
+int runExportCommand(const Bridge &bridge, const char *directory, int frames, const string &format, int threads)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.calculateWindowSize(windowWidth, windowHeight, scale);
 
-            // 只有在位置安全时才添加新车
-            if (isPositionSafe)
-            {
-                // 随机选择车辆类型：0-小轿车，1-SUV，2-大卡车
-                int vehicleType = rand() % 3;
-                if (vehicleType == 0)
-                {
-                    // 创建小轿车
-                    vehicles.push_back(Sedan(
-                        lane,
-                        carlength,
-                        carwidth,
-                        lane < 3 ? 0 : windowWidth,
-                        laneHeight * lane + (int)(0.5 * laneHeight),
-                        (int)rng.generate()));
-                }
-                else if (vehicleType == 1)
-                {
-                    // 创建SUV
-                    vehicles.push_back(SUV(
-                        lane,
-                        carlength,
-                        carwidth,
-                        lane < 3 ? 0 : windowWidth,
-                        laneHeight * lane + (int)(0.5 * laneHeight),
-                        (int)rng.generate()));
-                }
-                else
-                {
-                    // 创建大卡车
-                    vehicles.push_back(Truck(
-                        lane,
-                        carlength,
-                        carwidth,
-                        lane < 3 ? 0 : windowWidth,
-                        laneHeight * lane + (int)(0.5 * laneHeight),
-                        (int)rng.generate()));
-                }
-            }
+    FrameExportOptions options;
+    options.directory = directory;
+    options.format = format == "y4m" ? FrameFormat::Y4M : FrameFormat::PNG;
+    options.encoderThreads = threads;
+    FrameExporter exporter;
+    if (!exporter.start(options, windowWidth, windowHeight))
+    {
+        closegraph();
+        printf("cannot write to %s\n", directory);
+        return 1;
+    }
+
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, (uint64_t)time(0));
+    LodConfig lodConfig;
+    IMAGE canvas(windowWidth, windowHeight);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        sim.step();
+        SetWorkingImage(&canvas);
+        drawScene(bridge, sim, lodConfig);
+        SetWorkingImage();
+
+        Frame frame = exporter.acquire();
+        const DWORD *buffer = GetImageBuffer(&canvas);
+        copy(buffer, buffer + frame.pixels.size(), frame.pixels.begin());
+        exporter.submit(move(frame));
+    }
+    exporter.finish();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    closegraph();
+
+    const FrameExportStats &stats = exporter.stats;
+    printf("frames: %lld  bytes: %lld  time: %.2fs  (%.1f frames/s)\n",
+           stats.framesWritten, stats.bytesWritten, seconds, stats.framesWritten / max(seconds, 1e-9));
+    printf("simulation waited for encoders: %.2fs\n", stats.producerWaitSeconds);
+    return stats.failed ? 1 : 0;
+}
+
+// 对比EasyX绘制和分块软件光栅化的画面与耗时
+int runRenderCheckCommand(const Bridge &bridge, int frames, int tolerance, int threads)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.calculateWindowSize(windowWidth, windowHeight, scale);
+
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, 1);
+    sim.params.logRelativeSpeed = false;
+    LodConfig lodConfig;
+    IMAGE reference(windowWidth, windowHeight);
+    RasterCanvas canvas;
+    TileRenderer renderer(threads);
+    vector<uint32_t> pixels((size_t)windowWidth * windowHeight);
+    double easyxSeconds = 0, recordSeconds = 0, rasterSeconds = 0;
+    long long differing = 0;
+    int maxDelta = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        sim.step();
+        auto start = chrono::steady_clock::now();
+        SetWorkingImage(&reference);
+        drawScene(bridge, sim, lodConfig);
+        SetWorkingImage();
+        auto drawn = chrono::steady_clock::now();
+        canvas.reset(windowWidth, windowHeight);
+        {
+            RasterCanvasScope scope(canvas);
+            drawScene(bridge, sim, lodConfig);
         }
+        auto recorded = chrono::steady_clock::now();
+        renderer.render(canvas, pixels.data(), windowWidth);
+        auto rasterized = chrono::steady_clock::now();
+        easyxSeconds += chrono::duration<double>(drawn - start).count();
+        recordSeconds += chrono::duration<double>(recorded - drawn).count();
+        rasterSeconds += chrono::duration<double>(rasterized - recorded).count();
 
-        // 更新车辆的位置
-        int middleY = windowHeight / 2; // 桥面中心的位置
+        FrameDifference d = compareFrames((const uint32_t *)GetImageBuffer(&reference), pixels.data(), pixels.size(), tolerance);
+        differing += d.differing;
+        maxDelta = max(maxDelta, d.maxChannelDelta);
+    }
+    closegraph();
+
+    double n = max(1, frames);
+    printf("frames: %d  vehicles: %zu  threads: %d\n", frames, sim.vehicles.size(), renderer.threadCount);
+    printf("EasyX: %.2f ms/frame  software: record %.2f + raster %.2f ms/frame\n", easyxSeconds * 1000 / n,
+           recordSeconds * 1000 / n, rasterSeconds * 1000 / n);
+    printf("pixels differing by more than %d: %.3f%%  (max channel delta %d)\n", tolerance,
+           100.0 * differing / (n * windowWidth * windowHeight), maxDelta);
+    return 0;
+}
 
-        for (auto &v : vehicles)
+// 放大后裁剪与全部绘制对比：画面应完全相同，裁剪后的绘制耗时只取决于视口内的车辆
+int runViewCheckCommand(const Bridge &bridge, double zoom, int frames, int spawnPeriod)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.calculateWindowSize(windowWidth, windowHeight, scale);
+
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, 1);
+    sim.params.logRelativeSpeed = false;
+    sim.params.spawnPeriod = spawnPeriod;
+    LodConfig lodConfig;
+    SceneView culled, full;
+    culled.camera.fit(windowWidth, windowHeight, windowWidth, windowHeight);
+    culled.camera.zoomAt(windowWidth / 2, windowHeight / 2, zoom);
+    full.camera = culled.camera;
+    full.culling = false;
+    RasterCanvas canvas;
+    TileRenderer renderer;
+    vector<uint32_t> culledPixels((size_t)windowWidth * windowHeight), fullPixels(culledPixels.size());
+    double culledSeconds = 0, fullSeconds = 0;
+    long long differing = 0, culledCommands = 0, fullCommands = 0, visible = 0, total = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        sim.step();
+        auto start = chrono::steady_clock::now();
+        canvas.reset(windowWidth, windowHeight);
+        {
+            RasterCanvasScope scope(canvas);
+            drawScene(bridge, sim, lodConfig, culled);
+        }
+        culledCommands += (long long)canvas.commands.size();
+        renderer.render(canvas, culledPixels.data(), windowWidth);
+        auto middle = chrono::steady_clock::now();
+        canvas.reset(windowWidth, windowHeight);
         {
-            // 保存原始颜色（如果还没有被标记为警告）
-            COLORREF originalColor = v.color;
-            if (v.speed == 0)
+            RasterCanvasScope scope(canvas);
+            drawScene(bridge, sim, lodConfig, full);
+        }
+        fullCommands += (long long)canvas.commands.size();
+        renderer.render(canvas, fullPixels.data(), windowWidth);
+        auto end = chrono::steady_clock::now();
+        culledSeconds += chrono::duration<double>(middle - start).count();
+        fullSeconds += chrono::duration<double>(end - middle).count();
+        differing += compareFrames(culledPixels.data(), fullPixels.data(), culledPixels.size(), 0).differing;
+        visible += culled.visibleVehicles;
+        total += (long long)sim.vehicles.size();
+    }
+    closegraph();
+
+    double n = max(1, frames);
+    printf("zoom %.1fx  frames: %d  vehicles: %.0f  visible: %.0f\n", culled.camera.zoom, frames, total / n, visible / n);
+    printf("culled: %.2f ms/frame (%.0f commands)  all: %.2f ms/frame (%.0f commands)\n", culledSeconds * 1000 / n,
+           culledCommands / n, fullSeconds * 1000 / n, fullCommands / n);
+    printf("differing pixels: %lld\n", differing);
+    return differing == 0 ? 0 : 1;
+}
+
+// 帧时间调节：拥堵逐渐形成时按预算降低画质，并确认仿真结果与不绘制时完全相同
+int runGovernorCheckCommand(const Bridge &bridge, int frames, double budgetMilliseconds, int spawnPeriod)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.calculateWindowSize(windowWidth, windowHeight, scale);
+
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, 1);
+    sim.params.logRelativeSpeed = false;
+    sim.params.spawnPeriod = spawnPeriod;
+    Simulation reference = sim; // 只推进、不绘制
+    LodConfig lodConfig;
+    GovernorConfig config;
+    config.budgetMilliseconds = budgetMilliseconds;
+    FrameGovernor governor(config);
+    SceneView view;
+    view.camera.fit(windowWidth, windowHeight, windowWidth, windowHeight);
+    RasterCanvas canvas;
+    TileRenderer renderer;
+    vector<uint32_t> pixels((size_t)windowWidth * windowHeight);
+    for (int i = 0; i < frames; ++i)
+    {
+        sim.step();
+        reference.step();
+        if (!governor.shouldDraw())
+            continue;
+        auto start = chrono::steady_clock::now();
+        QualityLevel before = governor.level;
+        view.qualityLabel = before == QualityLevel::FULL ? nullptr : qualityLevelName(before);
+        canvas.reset(windowWidth, windowHeight);
+        {
+            RasterCanvasScope scope(canvas);
+            drawScene(bridge, sim, governor.apply(lodConfig), view);
+        }
+        renderer.render(canvas, pixels.data(), windowWidth);
+        if (governor.record(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()))
+        {
+            printf("tick %lld  vehicles %zu  average %.2f ms  level %d -> %d\n", sim.tick, sim.vehicles.size(),
+                   governor.averageMilliseconds, (int)before, (int)governor.level);
+        }
+    }
+    closegraph();
+
+    printGovernorReport(governor);
+    bool exact = sim.vehicles.size() == reference.vehicles.size() && sim.exitedCount == reference.exitedCount &&
+                 sim.brokenDownCount == reference.brokenDownCount;
+    for (size_t i = 0; exact && i < sim.vehicles.size(); ++i)
+    {
+        const Vehicle &a = sim.vehicles[i], &b = reference.vehicles[i];
+        exact = a.id == b.id && a.x == b.x && a.y == b.y && a.speed == b.speed && a.lane == b.lane;
+    }
+    printf("simulation %s the undrawn run\n", exact ? "matches" : "DIFFERS from");
+    return exact ? 0 : 1;
+}
+
+// 批量提交：统计每帧的状态设置和绘制调用在分组前后的数量，并确认分组后画面不变
+int runBatchCheckCommand(const Bridge &bridge, int frames, int spawnPeriod, double zoom)
+{
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.calculateWindowSize(windowWidth, windowHeight, scale);
+
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, 1);
+    sim.params.logRelativeSpeed = false;
+    sim.params.spawnPeriod = spawnPeriod;
+    LodConfig lodConfig;
+    SceneView view;
+    view.camera.fit(windowWidth, windowHeight, windowWidth, windowHeight);
+    view.camera.zoomAt(windowWidth / 2, windowHeight / 2, zoom);
+    IMAGE direct(windowWidth, windowHeight), batched(windowWidth, windowHeight);
+    RasterCanvas canvas, replayed;
+    RenderBatcher batcher;
+    TileRenderer renderer;
+    vector<uint32_t> expected((size_t)windowWidth * windowHeight), actual(expected.size());
+    RenderBatchStats total;
+    double directSeconds = 0, batchedSeconds = 0;
+    long long differing = 0, easyxDiffering = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        sim.step();
+        auto start = chrono::steady_clock::now();
+        SetWorkingImage(&direct);
+        drawScene(bridge, sim, lodConfig, view);
+        auto drawn = chrono::steady_clock::now();
+        SetWorkingImage(&batched);
+        canvas.reset(windowWidth, windowHeight);
+        {
+            RasterCanvasScope scope(canvas);
+            drawScene(bridge, sim, lodConfig, view);
+        }
+        batcher.build(canvas);
+        batcher.submit(canvas);
+        auto submitted = chrono::steady_clock::now();
+        SetWorkingImage();
+        directSeconds += chrono::duration<double>(drawn - start).count();
+        batchedSeconds += chrono::duration<double>(submitted - drawn).count();
+
+        const RenderBatchStats &s = batcher.stats;
+        total.commands += s.commands;
+        total.stateCalls += s.stateCalls;
+        total.culled += s.culled;
+        total.batches += s.batches;
+        total.stateChanges += s.stateChanges;
+        total.drawCalls += s.drawCalls;
+
+        // 分组只改变提交顺序：原顺序和提交顺序光栅化的画面必须完全相同
+        batcher.replay(canvas, replayed);
+        renderer.render(canvas, expected.data(), windowWidth);
+        renderer.render(replayed, actual.data(), windowWidth);
+        differing += compareFrames(expected.data(), actual.data(), expected.size(), 0).differing;
+        easyxDiffering += compareFrames((const uint32_t *)GetImageBuffer(&direct), (const uint32_t *)GetImageBuffer(&batched),
+                                        expected.size(), 0)
+                              .differing;
+    }
+    closegraph();
+
+    double n = max(1, frames);
+    printf("zoom %.1fx  frames: %d  vehicles: %zu\n", view.camera.zoom, frames, sim.vehicles.size());
+    printf("direct:  %.0f draw calls  %.0f state calls  %.2f ms/frame\n", total.commands / n, total.stateCalls / n,
+           directSeconds * 1000 / n);
+    printf("batched: %.0f draw calls  %.0f state calls  %.2f ms/frame  (%.0f batches, %.0f culled)\n",
+           total.drawCalls / n, total.stateChanges / n, batchedSeconds * 1000 / n, total.batches / n, total.culled / n);
+    printf("differing pixels: %lld (software raster)  %lld (EasyX, dashed lines keep their phase)\n", differing,
+           easyxDiffering);
+    return differing == 0 ? 0 : 1;
+}
+
+// 函数声明：清除指定车道的所有车辆
+int main(int argc, char *argv[])
+{
+    Bridge bridge;
+    // 输入桥梁参数
+    // cout << "请输入桥长（m）: ";
+    // cin >> bridge.bridgeLength;
+    // cout << "请输入桥宽（m）: ";
+    // cin >> bridge.bridgeWidth;
+    // cout << "请输入桥宽放大率: ";
+    // cin >> bridge.widthScale;
+    bridge.bridgeLength = 100;
+    bridge.bridgeWidth = 50;
+    bridge.widthScale = 1;
+
+    // 命令行参数 --sweep：不打开窗口，运行参数扫描
+    if (argc > 1 && string(argv[1]) == "--sweep")
+    {
+        return runSweepCommand(bridge);
+    }
+    // 命令行参数 --bench：不打开窗口，运行基准测试
+    if (argc > 1 && string(argv[1]) == "--bench")
+    {
+        return runBenchCommand(bridge);
+    }
+    // 命令行参数 --domains N [帧数]：分域多进程运行
+    if (argc > 2 && string(argv[1]) == "--domains")
+    {
+        return runDomainCommand(bridge, atoi(argv[2]), argc > 3 ? atoi(argv[3]) : 1000);
+    }
+    // 命令行参数 --hybrid [路段长度（米）] [帧数] [生成频率]：混合宏观/微观仿真
+    // 默认远场较长，全微观对照有上百辆车，才能看出远场换成元胞后省下的开销
+    if (argc > 1 && string(argv[1]) == "--hybrid")
+    {
+        return runHybridCommand(bridge, argc > 2 ? atof(argv[2]) : 3000, argc > 3 ? atoi(argv[3]) : 6000,
+                                argc > 4 ? atoi(argv[4]) : 10);
+    }
+    // 命令行参数 --events [帧数] [生成周期]：离散事件推进与逐帧推进对比
+    if (argc > 1 && string(argv[1]) == "--events")
+    {
+        return runEventsCommand(bridge, argc > 2 ? atoll(argv[2]) : 100000, argc > 3 ? atoi(argv[3]) : 200);
+    }
+    // 命令行参数 --spacetime 目录 [帧数] [生成周期]：导出时空图
+    if (argc > 2 && string(argv[1]) == "--spacetime")
+    {
+        return runSpaceTimeCommand(bridge, argv[2], argc > 3 ? atoll(argv[3]) : 6000, argc > 4 ? atoi(argv[4]) : 10);
+    }
+    // 命令行参数 --safety [帧数] [生成周期]：统计替代安全指标
+    if (argc > 1 && string(argv[1]) == "--safety")
+    {
+        return runSafetyCommand(bridge, argc > 2 ? atoll(argv[2]) : 6000, argc > 3 ? atoi(argv[3]) : 10);
+    }
+    // 命令行参数 --record 文件 [帧数] [生成周期]：记录运行并建立索引
+    if (argc > 2 && string(argv[1]) == "--record")
+    {
+        return runRecordCommand(bridge, argv[2], argc > 3 ? atoll(argv[3]) : 6000, argc > 4 ? atoi(argv[4]) : 10);
+    }
+    // 命令行参数 --query 文件 events|vehicle|frames ...：查询运行记录
+    if (argc > 3 && string(argv[1]) == "--query")
+    {
+        return runQueryCommand(argc, argv);
+    }
+    // 命令行参数 --render-check [帧数] [容差] [线程数]：对比EasyX与软件光栅化的画面
+    if (argc > 1 && string(argv[1]) == "--render-check")
+    {
+        return runRenderCheckCommand(bridge, argc > 2 ? atoi(argv[2]) : 200, argc > 3 ? atoi(argv[3]) : 16,
+                                     argc > 4 ? atoi(argv[4]) : 0);
+    }
+    // 命令行参数 --view-check [缩放倍数] [帧数] [生成周期]：放大后视口裁剪与全部绘制对比
+    if (argc > 1 && string(argv[1]) == "--view-check")
+    {
+        return runViewCheckCommand(bridge, argc > 2 ? atof(argv[2]) : 8, argc > 3 ? atoi(argv[3]) : 200,
+                                   argc > 4 ? atoi(argv[4]) : 2);
+    }
+    // 命令行参数 --governor-check [帧数] [预算毫秒] [生成周期]：拥堵形成时按帧时间预算降低画质
+    if (argc > 1 && string(argv[1]) == "--governor-check")
+    {
+        return runGovernorCheckCommand(bridge, argc > 2 ? atoi(argv[2]) : 1500, argc > 3 ? atof(argv[3]) : 4,
+                                       argc > 4 ? atoi(argv[4]) : 1);
+    }
+    // 命令行参数 --batch-check [帧数] [生成周期] [缩放倍数]：按绘图状态分组提交前后的调用次数
+    if (argc > 1 && string(argv[1]) == "--batch-check")
+    {
+        return runBatchCheckCommand(bridge, argc > 2 ? atoi(argv[2]) : 500, argc > 3 ? atoi(argv[3]) : 2,
+                                    argc > 4 ? atof(argv[4]) : 1);
+    }
+    // 命令行参数 --trace-convert 输入.csv 输出.trace：到达记录CSV转换为二进制格式
+    if (argc > 3 && string(argv[1]) == "--trace-convert")
+    {
+        return runTraceConvertCommand(argv[2], argv[3]);
+    }
+    // 命令行参数 --trace-replay 文件 [帧数]：无界面回放到达记录
+    if (argc > 2 && string(argv[1]) == "--trace-replay")
+    {
+        return runTraceReplayCommand(bridge, argv[2], argc > 3 ? atoll(argv[3]) : 0);
+    }
+    // 命令行参数 --export 目录 帧数 [png|y4m] [编码线程数]：离线导出视频帧
+    if (argc > 3 && string(argv[1]) == "--export")
+    {
+        return runExportCommand(bridge, argv[2], atoi(argv[3]), argc > 4 ? argv[4] : "png", argc > 5 ? atoi(argv[5]) : 0);
+    }
+    // 分域工作进程（由 --domains 启动器启动）
+    if (argc > 3 && string(argv[1]) == "--domain-worker")
+    {
+        return runDomainWorker(argv[2], atoi(argv[3]));
+    }
+
+    // 调用桥梁绘制函数计算窗口大小
+    int windowWidth, windowHeight;
+    double scale;
+    bridge.calculateWindowSize(windowWidth, windowHeight, scale);
+
+    // 仿真状态（车辆、随机数引擎、时钟），可保存检查点或分支推演
+    Simulation sim(windowWidth, windowHeight, scale, bridge.widthScale, (uint64_t)time(0));
+    // 交互运行的选项可以组合，例如 --trace 文件 --publish 名称 --soft-render 4：
+    //   --trace 文件：由到达记录驱动生成新车
+    //   --publish 名称：每帧把车辆状态发布到共享内存，供其他进程读取（见examples/live_reader.cpp）
+    //   --soft-render [线程数]：用分块软件光栅化绘制
+    TraceDemand demand;
+    LiveStatePublisher publisher;
+    PipelineOptions pipelineOptions;
+    unique_ptr<TileRenderer> renderer;
+    for (int i = 1; i < argc; ++i)
+    {
+        string option = argv[i];
+        if (option == "--trace" && i + 1 < argc)
+        {
+            string error;
+            if (!demand.open(argv[++i], error))
             {
-                v.handleDangerousSituation();
+                closegraph();
+                printf("%s\n", error.c_str());
+                return 1;
             }
-            // 使用前向运动函数
-            v.moveForward(middleY);
-            v.checkFrontVehicleDistance(vehicles, v.getSafeDistance()); // 检查与前车距离，使用车辆特定的安全距离
-
-            if (v.isGoing2change)
+            sim.spawnSource = [&demand](Simulation &s) { demand.spawnDue(s); };
+        }
+        else if (option == "--publish" && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+            if (!publisher.create(name, sim))
             {
-                if (v.smoothLaneChange(laneHeight, vehicles))
-                {
-                    v.haschanged = true;
-                }
+                closegraph();
+                printf("cannot create shared memory %s\n", name);
+                return 1;
             }
-
-            // 如果处于警告状态，检查是否需要恢复
-            if (v.isTooClose)
+            pipelineOptions.publisher = &publisher;
+        }
+        else if (option == "--soft-render")
+        {
+            // 线程数可省略（0表示按硬件线程数）
+            int threads = 0;
+            if (i + 1 < argc && string(argv[i + 1]).compare(0, 2, "--") != 0)
             {
-                // 检查当前是否仍然距离过近
-                bool stillTooClose = false;
-                for (const auto &other : vehicles)
-                {
-                    if (&other == &v)
-                        continue;
-                    if (other.lane != v.lane)
-                        continue;
-
-                    bool isMovingRight = (v.lane < 3);
-                    bool isFrontVehicle = isMovingRight ? (other.x > v.x) : (other.x < v.x);
-
-                    if (isFrontVehicle)
-                    {
-                        int distance = abs(other.x - v.x) - (other.carlength / 2 + v.carlength / 2);
-                        if (distance <= SAFE_DISTANCE)
-                        {
-                            stillTooClose = true;
-                            break;
-                        }
-                    }
-                }
-
-                if (!stillTooClose)
-                {
-                    // 恢复原始颜色
-                    v.color = v.originalColor;
-                    v.isTooClose = false;
-                }
+                threads = atoi(argv[++i]);
             }
+            renderer.reset(new TileRenderer(threads));
+            pipelineOptions.renderer = renderer.get();
         }
-        // 移除离开车辆
-        vehicles.erase(remove_if(vehicles.begin(), vehicles.end(),
-                                 [windowWidth](const Vehicle &v)
-                                 { return v.x < 0 || v.x > windowWidth; }),
-                       vehicles.end()); // remove_if:遍历所有车辆，将不需要删除的车辆移至前方，
-        // 将需要删除的移至后方，返回一个分界点值，erase删除从分界点到末尾的值
-
-        // 绘制车辆
-        for (const auto &v : vehicles)
+        else
         {
-            v.predictAndDrawTrajectory(laneHeight, windowHeight / 2, 30, vehicles); // 预测并绘制轨迹
-            v.draw();                                                               // 绘制车辆
+            closegraph();
+            printf("unknown option %s\n", option.c_str());
+            return 1;
         }
-
-        Sleep(60); // ms
-        time += 0.2;
     }
+    // 车辆绘制细节等级阈值，车辆越小越多绘制越简单
+    LodConfig lodConfig;
+    // 输入、仿真、绘制分别在三个线程中运行，按任意键结束
+    runPipeline(bridge, sim, lodConfig, pipelineOptions);
     closegraph();
     return 0;
 }
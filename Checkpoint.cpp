@@ -0,0 +1,277 @@
+﻿#include <vector>
+#include <memory>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+#include "Checkpoint.h"
+using namespace std;
+
+namespace
+{
+    const uint32_t CHECKPOINT_MAGIC = 0x4B435343; // "CSCK"
+    const uint32_t CHECKPOINT_VERSION = 6;
+    const size_t VEHICLE_RECORD_BYTES = 60; // 每辆车写入的字节数（见saveCheckpoint）
+    const int MAX_CHECKPOINT_LANES = 255;   // 车道号按一个字节保存
+
+    // 车辆布尔状态压缩成一个字节
+    enum VehicleFlags : uint8_t
+    {
+        FLAG_HAS_CHANGED = 1 << 0,
+        FLAG_CHANGING_LANE = 1 << 1,
+        FLAG_GOING_TO_CHANGE = 1 << 2,
+        FLAG_TOO_CLOSE = 1 << 3,
+        FLAG_BROKEN_DOWN = 1 << 4,
+        FLAG_FLASHING = 1 << 5
+    };
+
+    // 顺序写入基本类型
+    struct BlobWriter
+    {
+        vector<char> &out;
+        template <typename T>
+        void put(T value)
+        {
+            const char *p = reinterpret_cast<const char *>(&value);
+            out.insert(out.end(), p, p + sizeof(T));
+        }
+    };
+
+    // 顺序读取基本类型，越界时置失败标记
+    struct BlobReader
+    {
+        const vector<char> &in;
+        size_t pos;
+        bool ok;
+        template <typename T>
+        T get()
+        {
+            T value{};
+            if (!ok || pos + sizeof(T) > in.size())
+            {
+                ok = false;
+                return value;
+            }
+            memcpy(&value, in.data() + pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+    };
+}
+
+vector<char> saveCheckpoint(const Simulation &sim)
+{
+    vector<char> blob;
+    blob.reserve(160 + sim.vehicles.size() * VEHICLE_RECORD_BYTES);
+    BlobWriter w{blob};
+
+    w.put(CHECKPOINT_MAGIC);
+    w.put(CHECKPOINT_VERSION);
+    // 时钟和随机数引擎
+    w.put(sim.time);
+    w.put((int64_t)sim.tick);
+    w.put(sim.engine.state);
+    w.put((int32_t)sim.nextVehicleId);
+    // 桥面几何
+    w.put((int32_t)sim.windowWidth);
+    w.put((int32_t)sim.windowHeight);
+    w.put((int32_t)sim.laneCount);
+    w.put((int32_t)sim.laneHeight);
+    w.put(sim.scale);
+    w.put(sim.widthScale);
+    // 运行时参数和统计量
+    w.put((int32_t)sim.params.safeDistance);
+    w.put((int32_t)sim.params.crashDistance);
+    w.put((int32_t)sim.params.wait);
+    w.put((int32_t)sim.params.crash);
+    w.put(sim.params.sedanSafeFactor);
+    w.put(sim.params.suvSafeFactor);
+    w.put(sim.params.truckSafeFactor);
+    w.put((int32_t)sim.params.spawnPeriod);
+    w.put((int32_t)sim.params.maxPredictionSteps);
+    w.put((int32_t)sim.params.minPredictionSteps);
+    w.put(sim.params.brakingDeceleration);
+    w.put((uint8_t)sim.params.logRelativeSpeed);
+    w.put((int64_t)sim.exitedCount);
+    w.put((int64_t)sim.brokenDownCount);
+
+    // 车辆
+    w.put((uint32_t)sim.vehicles.size());
+    for (const auto &v : sim.vehicles)
+    {
+        uint8_t flags = 0;
+        if (v.haschanged) flags |= FLAG_HAS_CHANGED;
+        if (v.isChangingLane) flags |= FLAG_CHANGING_LANE;
+        if (v.isGoing2change) flags |= FLAG_GOING_TO_CHANGE;
+        if (v.isTooClose) flags |= FLAG_TOO_CLOSE;
+        if (v.isBrokenDown) flags |= FLAG_BROKEN_DOWN;
+        if (v.isFlashing) flags |= FLAG_FLASHING;
+
+        w.put((int32_t)v.id);
+        w.put(v.rng.state);
+        w.put((uint8_t)v.type);
+        w.put((uint8_t)v.lane);
+        w.put((uint8_t)v.targetLane);
+        w.put(flags);
+        w.put((int16_t)v.carlength);
+        w.put((int16_t)v.carwidth);
+        w.put((int32_t)v.x);
+        w.put((int32_t)v.y);
+        w.put((int32_t)v.speed);
+        w.put((uint32_t)v.color);
+        w.put((uint32_t)v.originalColor);
+        w.put(v.changeProgress);
+        w.put((int32_t)v.startX);
+        w.put((int32_t)v.startY);
+        w.put((int32_t)v.endX);
+        w.put((int32_t)v.endY);
+    }
+    return blob;
+}
+
+bool restoreCheckpoint(Simulation &sim, const vector<char> &blob)
+{
+    BlobReader r{blob, 0, true};
+    if (r.get<uint32_t>() != CHECKPOINT_MAGIC || r.get<uint32_t>() != CHECKPOINT_VERSION)
+        return false;
+
+    Simulation restored;
+    restored.time = r.get<double>();
+    restored.tick = r.get<int64_t>();
+    restored.engine.state = r.get<uint64_t>();
+    restored.nextVehicleId = r.get<int32_t>();
+    restored.windowWidth = r.get<int32_t>();
+    restored.windowHeight = r.get<int32_t>();
+    int laneCount = r.get<int32_t>();
+    if (laneCount < 1 || laneCount > MAX_CHECKPOINT_LANES)
+        return false;
+    restored.setLaneCount(laneCount);
+    restored.laneHeight = r.get<int32_t>();
+    restored.scale = r.get<double>();
+    restored.widthScale = r.get<double>();
+    restored.params.safeDistance = r.get<int32_t>();
+    restored.params.crashDistance = r.get<int32_t>();
+    restored.params.wait = r.get<int32_t>();
+    restored.params.crash = r.get<int32_t>();
+    restored.params.sedanSafeFactor = r.get<double>();
+    restored.params.suvSafeFactor = r.get<double>();
+    restored.params.truckSafeFactor = r.get<double>();
+    restored.params.spawnPeriod = r.get<int32_t>();
+    restored.params.maxPredictionSteps = r.get<int32_t>();
+    restored.params.minPredictionSteps = r.get<int32_t>();
+    restored.params.brakingDeceleration = r.get<double>();
+    restored.params.logRelativeSpeed = r.get<uint8_t>() != 0;
+    restored.exitedCount = r.get<int64_t>();
+    restored.brokenDownCount = r.get<int64_t>();
+
+    // 车辆数来自数据本身，先确认剩余字节足够再分配
+    uint32_t count = r.get<uint32_t>();
+    if (!r.ok || count > (blob.size() - r.pos) / VEHICLE_RECORD_BYTES)
+        return false;
+    restored.vehicles.reserve(count);
+    for (uint32_t i = 0; i < count && r.ok; ++i)
+    {
+        Vehicle v;
+        v.id = r.get<int32_t>();
+        v.rng.state = r.get<uint64_t>();
+        v.type = (VehicleType)r.get<uint8_t>();
+        v.lane = r.get<uint8_t>();
+        v.targetLane = r.get<uint8_t>();
+        uint8_t flags = r.get<uint8_t>();
+        v.carlength = r.get<int16_t>();
+        v.carwidth = r.get<int16_t>();
+        v.x = r.get<int32_t>();
+        v.y = r.get<int32_t>();
+        v.speed = r.get<int32_t>();
+        v.color = r.get<uint32_t>();
+        v.originalColor = r.get<uint32_t>();
+        v.changeProgress = r.get<float>();
+        v.startX = r.get<int32_t>();
+        v.startY = r.get<int32_t>();
+        v.endX = r.get<int32_t>();
+        v.endY = r.get<int32_t>();
+
+        v.haschanged = (flags & FLAG_HAS_CHANGED) != 0;
+        v.isChangingLane = (flags & FLAG_CHANGING_LANE) != 0;
+        v.isGoing2change = (flags & FLAG_GOING_TO_CHANGE) != 0;
+        v.isTooClose = (flags & FLAG_TOO_CLOSE) != 0;
+        v.isBrokenDown = (flags & FLAG_BROKEN_DOWN) != 0;
+        v.isFlashing = (flags & FLAG_FLASHING) != 0;
+        if (v.lane >= laneCount || v.targetLane >= laneCount || (int)v.type > (int)VehicleType::TRUCK)
+            return false;
+        restored.vehicles.push_back(v);
+    }
+    if (!r.ok || r.pos != blob.size())
+        return false;
+
+    sim = move(restored);
+    return true;
+}
+
+bool saveCheckpointFile(const Simulation &sim, const char *path)
+{
+    vector<char> blob = saveCheckpoint(sim);
+    ofstream out(path, ios::binary);
+    out.write(blob.data(), blob.size());
+    return (bool)out;
+}
+
+bool loadCheckpointFile(Simulation &sim, const char *path)
+{
+    ifstream in(path, ios::binary);
+    if (!in)
+        return false;
+    vector<char> blob((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    return restoreCheckpoint(sim, blob);
+}
+
+Simulation &SimulationFork::mutate()
+{
+    if (!own)
+    {
+        own.reset(new Simulation(*shared));
+    }
+    return *own;
+}
+
+void SimulationFork::run(int steps)
+{
+    Simulation &sim = mutate();
+    for (int i = 0; i < steps; ++i)
+    {
+        sim.step();
+    }
+}
+
+vector<Simulation> runWhatIf(const Simulation &prefix, const vector<function<void(Simulation &)>> &edits, int steps)
+{
+    // 所有分支共享同一个前缀，各自在自己的线程里复制快照（复制也并行）并推进
+    shared_ptr<const Simulation> shared = make_shared<Simulation>(prefix);
+    vector<SimulationFork> forks;
+    for (size_t i = 0; i < edits.size(); ++i)
+    {
+        forks.emplace_back(shared);
+    }
+
+    vector<thread> workers;
+    for (size_t i = 0; i < forks.size(); ++i)
+    {
+        workers.emplace_back([&forks, &edits, i, steps]()
+                             {
+                                 edits[i](forks[i].mutate());
+                                 forks[i].run(steps);
+                             });
+    }
+    for (auto &t : workers)
+    {
+        t.join();
+    }
+
+    vector<Simulation> results;
+    for (auto &f : forks)
+    {
+        results.push_back(f.view());
+    }
+    return results;
+}
@@ -0,0 +1,36 @@
+﻿#include <vector>
+#include <memory>
+#include <functional>
+#include "Simulation.h"
+using namespace std;
+
+// 将完整仿真状态（车辆含变道进度和抛锚标记、随机数引擎、时钟）序列化为紧凑的二进制数据
+vector<char> saveCheckpoint(const Simulation &sim);
+// 从二进制数据精确恢复仿真状态，数据无效时返回false且不修改sim
+bool restoreCheckpoint(Simulation &sim, const vector<char> &blob);
+// 检查点读写文件
+bool saveCheckpointFile(const Simulation &sim, const char *path);
+bool loadCheckpointFile(Simulation &sim, const char *path);
+
+// 仿真分支（快照复制）：与其他分支共享同一个只读前缀状态，第一次取可写状态时把整个前缀复制一份。
+// 复制的粒度是整个Simulation，不按车辆或字段共享：推进一帧会改写所有车辆，只读的分支才不付复制的代价
+struct SimulationFork
+{
+    shared_ptr<const Simulation> shared; // 共享的前缀状态
+    unique_ptr<Simulation> own;          // 本分支的快照副本（第一次修改前为空）
+
+    explicit SimulationFork(shared_ptr<const Simulation> prefix) : shared(prefix) {}
+
+    // 只读访问当前状态
+    const Simulation &view() const { return own ? *own : *shared; }
+    // 可写访问：第一次调用时复制整个共享状态
+    Simulation &mutate();
+    // 推进若干帧
+    void run(int steps);
+};
+
+// 从同一个前缀状态分出多个假设分支，每个分支在自己的线程中复制前缀快照、执行自己的修改（例如清空某车道），
+// 再并行推进steps帧，返回各分支的最终状态
+vector<Simulation> runWhatIf(const Simulation &prefix, const vector<function<void(Simulation &)>> &edits, int steps);
+
+#pragma once
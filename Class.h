@@ -1,12 +1,22 @@
-﻿#include <graphics.h>
-#include <vector>
-#include <ctime>
+﻿#ifndef CAR_SIM_HEADLESS
+#include <graphics.h>
 #include <conio.h> // 需要包含此头文件_kbhit()函数需要
 #include <Windows.h>
+#else
+// 无图形界面构建（共享库）：只保留仿真用到的颜色类型
+typedef unsigned long COLORREF;
+#define RGB(r, g, b) ((COLORREF)(((unsigned char)(r) | ((unsigned short)((unsigned char)(g)) << 8)) | (((unsigned long)(unsigned char)(b)) << 16)))
+#endif
+#include <vector>
+#include <ctime>
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <iostream>
 #include "Define.h"
+#include "SimParams.h"
+#include "LaneTopology.h"
+#include "Random.h"
 using namespace std;
 // 车辆类型枚举
 enum class VehicleType {
@@ -15,6 +25,38 @@ enum class VehicleType {
     TRUCK   // 大卡车
 };
 
+// 车辆绘制细节等级（LOD）
+enum class LodLevel {
+    FULL,   // 完整细节：阴影、车窗、车轮、轮毂等
+    SIMPLE, // 简化车身：只画车身轮廓
+    BOX     // 单个实心矩形
+};
+
+// LOD阈值配置：根据车辆在屏幕上的像素长度和当前车辆总数选择细节等级
+struct LodConfig
+{
+    int fullMinLength = 40;       // 车长（像素）不小于此值才绘制完整细节
+    int simpleMinLength = 12;     // 车长不小于此值才绘制简化车身，否则画实心矩形
+    int fullMaxVehicles = 150;    // 车辆总数超过此值时不再绘制完整细节
+    int simpleMaxVehicles = 600;  // 车辆总数超过此值时全部画成实心矩形
+    int labelMinLength = 30;      // 车长小于此值时不显示速度标签
+    int labelMaxVehicles = 200;   // 车辆总数超过此值时不显示速度标签
+    int trajectoryMinLength = 20; // 车长小于此值时不绘制预测轨迹
+    int trajectoryMaxVehicles = 300; // 车辆总数超过此值时不绘制预测轨迹
+};
+
+struct VirtualVehicle;
+
+// 一段预测轨迹上所有车身位置的外接矩形（包含边界），用于粗略排除不可能相交的车辆
+struct TrajectoryBox
+{
+    int left, top, right, bottom;
+
+    bool intersects(const TrajectoryBox &o) const
+    {
+        return !(left > o.right || right < o.left || top > o.bottom || bottom < o.top);
+    }
+};
 
 // 定义车辆的类
 struct Vehicle
@@ -26,10 +68,12 @@ struct Vehicle
     // 默认构造函数
 Vehicle(int l = 0, int cl = 0, int cw = 0, int x = 0, int y = 0, int s = 0, bool hc = false, COLORREF c = RGB(255, 255, 255),
         bool icl = false, bool igc = false, int tl = 0, float cp = 0.0f,
-        int sx = 0, int sy = 0, int ex = 0, int ey = 0, bool itc = false, COLORREF oc = RGB(255, 255, 255), bool ibd = false)
+        int sx = 0, int sy = 0, int ex = 0, int ey = 0, bool itc = false, COLORREF oc = RGB(255, 255, 255), bool ibd = false,
+        VehicleType t = VehicleType::SEDAN)
     : lane(l), carlength(cl), carwidth(cw), x(x), y(y), speed(s), haschanged(hc), color(c),
       isChangingLane(icl), isGoing2change(igc), targetLane(tl), changeProgress(cp),
-      startX(sx), startY(sy), endX(ex), endY(ey), isTooClose(itc), originalColor(oc), isBrokenDown(ibd) {}
+      startX(sx), startY(sy), endX(ex), endY(ey), isTooClose(itc), originalColor(oc), isBrokenDown(ibd),
+      isFlashing(false), type(t), id(0), rng(0) {}
 
     // 新增成员变量用于变道
     bool isChangingLane;  // 是否正在变道
@@ -47,29 +91,74 @@ Vehicle(int l = 0, int cl = 0, int cw = 0, int x = 0, int y = 0, int s = 0, bool
 
     // 抛锚状态
     bool isBrokenDown; // 车辆是否抛锚
-    virtual void draw() const;
-    // 预测并绘制轨迹
-    void predictAndDrawTrajectory(int laneHeight, int middleY, int predictionSteps = 30, const vector<Vehicle> &allVehicles = vector<Vehicle>()) const;
+    // 本帧是否需要显示橘色警告线框（每帧开始时清除）
+    bool isFlashing;
+
+    // 车型标记：车型相关的行为按此标记在编译期分派（见VehicleTypes.h），
+    // 车辆按值存放在vector<Vehicle>中也不会丢失车型行为
+    VehicleType type;
+
+    int id;        // 车辆编号，按生成顺序递增
+    SimRandom rng; // 车辆自己的随机数引擎（变道方向选择），与其他车辆和更新顺序无关
+
+    // 按细节等级绘制车辆，showLabel控制是否显示速度标签
+    void draw(LodLevel lod = LodLevel::FULL, bool showLabel = true) const;
+    // 简化绘制（SIMPLE/BOX等级），各车型共用
+    void drawSimplified(LodLevel lod) const;
+    // 绘制抛锚车辆（灰色+红色X）
+    void drawBrokenDown() const;
+    // 在车辆上方显示速度
+    void drawSpeedLabel() const;
+    // 预测并绘制轨迹，predictionSteps为0时使用predictionHorizon()
+    void predictAndDrawTrajectory(int predictionSteps = 0, const vector<Vehicle> &allVehicles = vector<Vehicle>()) const;
 
     // 检查变道是否安全
     bool isLaneChangeSafe(int laneHeight, const vector<Vehicle> &allVehicles) const;
 
-    // 检查与前车距离
-    void checkFrontVehicleDistance(vector<Vehicle> &allVehicles, int safeDistance);
+    // 检查与前车距离（allVehicles为只读快照），被撞的前车编号追加到crashedIds
+    void checkFrontVehicleDistance(const vector<Vehicle> &allVehicles, int safeDistance, vector<int> &crashedIds);
+    // 对距离为distance的前车做出反应：减速、准备变道，或者撞上前车
+    void reactToFrontVehicle(const Vehicle &front, int distance, int safeDistance, vector<int> &crashedIds);
 
-    // 显示闪烁的橘色线框
+    // 标记本帧显示闪烁的橘色线框
     void showFlashingFrame();
+    // 绘制橘色线框
+    void drawFlashingFrame() const;
     // 处理危险情况
     void handleDangerousSituation();
+    // 行驶方向：1向右，-1向左（按当前仿真的车道布局）
+    int direction() const
+    {
+        return currentLaneKernels().topology.direction(lane);
+    }
     // 前向运动函数
-    void moveForward(int middleY)
+    void moveForward()
     {
-        x += (y < middleY) ? speed : -speed;
+        x += direction() * speed;
     }
     // 平滑变道函数
-    virtual bool smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicles);
-    // 获取安全距离（可被子类重写）
-    virtual int getSafeDistance() const { return SAFE_DISTANCE; }
+    bool smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicles);
+    // 推进正在进行的变道，完成时返回true
+    bool advanceLaneChange();
+    // 确定目标车道（中间车道消耗一次随机数），不能变道时返回-1
+    int chooseTargetLane();
+    // 预览chooseTargetLane的结果，不改变随机数状态
+    int previewTargetLane() const;
+    // 预测帧数：按当前速度制动到停下再加上安全距离所需的帧数，不短于完成一次变道所需的帧数，
+    // 限制在[minPredictionSteps, maxPredictionSteps]内（见SimParams）。慢车和远处的车预测得短
+    int predictionHorizon() const;
+    // 变道到target的预测轨迹（当前位置 + steps步）
+    VirtualVehicle laneChangePath(int target, int laneHeight, int steps) const;
+    // 按当前状态（直行或正在变道）行驶的预测轨迹（steps步，不含当前位置）
+    VirtualVehicle predictedPath(int steps) const;
+    // predictedPath(steps)的外接矩形，不生成轨迹点
+    TrajectoryBox predictedBox(int steps) const;
+    // 开始变道到target
+    void startLaneChange(int target, int laneHeight);
+    // 获取安全距离（按车型）
+    int getSafeDistance() const;
+    // 每帧的变道进度增量（按车型）
+    float laneChangeRate() const;
 };
 
 // 虚拟车辆类，用于轨迹预测和相交检测
@@ -88,6 +177,8 @@ struct VirtualVehicle
         trajectory.push_back(make_pair(pointX, pointY));
     }
 
+    // 所有轨迹点上车身的外接矩形
+    TrajectoryBox bounds() const;
     // 绘制轨迹（根据安全情况使用不同颜色）
     void drawTrajectory(bool isSafe) const;
     // 检查与另一车辆的轨迹是否相交
@@ -101,7 +192,18 @@ struct Bridge
     // 采用此函数计算适合屏幕的窗口尺寸和缩放比例，准备绘制桥梁、车道
     // 根据屏幕分辨率调整窗口大小
     void calculateWindowSize(int &windowWidth, int &windowHeight, double &scale) const;
+    // 只计算窗口尺寸和缩放比例，不创建窗口（用于无界面的批量运行）
+    void computeWindowSize(int &windowWidth, int &windowHeight, double &scale) const;
 };
+// 粗到细检查预测轨迹path（外接矩形为box）与other按当前状态行驶的前steps步是否相交：
+// 先比较整段轨迹的外接矩形，不相交时只需这一次比较，相交时才生成other的轨迹逐帧比较
+bool trajectoryConflicts(const VirtualVehicle &path, const TrajectoryBox &box, const Vehicle &other, int steps);
 void clearLane(vector<Vehicle>& vehicles, int lane);
+// 根据屏幕上的车长和车辆总数选择细节等级
+LodLevel chooseLod(const LodConfig &config, int onScreenLength, int vehicleCount);
+// 是否显示速度标签
+bool shouldShowLabel(const LodConfig &config, int onScreenLength, int vehicleCount);
+// 是否绘制预测轨迹
+bool shouldShowTrajectory(const LodConfig &config, int onScreenLength, int vehicleCount);
 
 #pragma once
@@ -0,0 +1,880 @@
+﻿#include <vector>
+#include <deque>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <cstdio>
+#include <new>
+
+#include "Domain.h"
+#include "SharedMemory.h"
+#include "WarmStart.h"
+#include "LaneChange.h"
+#include "VehicleTypes.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+namespace
+{
+    static_assert(is_trivially_copyable<Vehicle>::value, "Vehicle必须可以按字节复制到共享内存");
+    static_assert(ATOMIC_INT_LOCK_FREE == 2, "跨进程邮箱需要无锁原子整数");
+
+    const uint32_t DOMAIN_MAGIC = 0x4D4F4443; // "CDOM"
+    const int MAX_DOMAINS = 16;
+    const uint32_t MAILBOX_CAPACITY = 4096;   // 每个邮箱的消息槽数（2的幂）
+    const int MAX_RESULT_VEHICLES = 1 << 15;  // 每个分域回传的最大车辆数
+    const chrono::seconds ABORT_GRACE(5);      // 置中止标记后等待工作进程自行退出的时间，超过后强制结束
+
+    // 消息类型
+    enum MessageKind : int32_t
+    {
+        MSG_CRASH = 1,         // 被撞的影子车辆编号，发给它的所属分域
+        MSG_END_CRASH = 2,     // 本帧碰撞消息结束，value和reserved为本分域车辆的最大速度和车长
+        MSG_MIGRATE = 3,       // 驶入对方范围的车辆，所有权转移
+        MSG_GHOST = 4,         // 对方需要的影子车辆（只读副本），value为其所属分域
+        MSG_END_STATE = 5,     // 本帧车辆消息结束
+        MSG_CANDIDATE = 6,     // 本分域的变道候选车辆，value为目标车道
+        MSG_END_CANDIDATES = 7,
+        MSG_SAFETY = 8,        // 候选车辆的轨迹与本分域车辆是否相交，value为编号，reserved为1表示不相交
+        MSG_END_SAFETY = 9
+    };
+
+    struct DomainMessage
+    {
+        int32_t kind;
+        int32_t tick;
+        int32_t value;
+        int32_t reserved;
+        Vehicle vehicle;
+    };
+
+    // 单生产者单消费者无锁环形邮箱：生产者只写head，消费者只写tail
+    struct Mailbox
+    {
+        alignas(64) atomic<uint32_t> head;
+        alignas(64) atomic<uint32_t> tail;
+        DomainMessage slots[MAILBOX_CAPACITY];
+
+        bool tryPush(const DomainMessage &message)
+        {
+            uint32_t h = head.load(memory_order_relaxed);
+            if (h - tail.load(memory_order_acquire) >= MAILBOX_CAPACITY)
+                return false;
+            slots[h % MAILBOX_CAPACITY] = message;
+            head.store(h + 1, memory_order_release);
+            return true;
+        }
+
+        bool tryPop(DomainMessage &message)
+        {
+            uint32_t t = tail.load(memory_order_relaxed);
+            if (t == head.load(memory_order_acquire))
+                return false;
+            message = slots[t % MAILBOX_CAPACITY];
+            tail.store(t + 1, memory_order_release);
+            return true;
+        }
+    };
+
+    // 每个分域回传的结果
+    struct DomainResultSlot
+    {
+        int32_t count;
+        int32_t ok;
+        int64_t exitedCount;
+        int64_t brokenDownCount;
+        double seconds;
+        Vehicle vehicles[MAX_RESULT_VEHICLES];
+    };
+
+    // 共享内存头部
+    struct DomainHeader
+    {
+        uint32_t magic;
+        DomainConfig config;
+        atomic<int32_t> ready; // 已完成初始化的分域数，全部就绪后同时开始计时
+        atomic<int32_t> abort; // 启动失败或任一进程失败时置1，其他进程在等待中看到后退出
+    };
+
+    // 工作进程在等待其他分域时发现中止标记
+    struct DomainAborted
+    {
+    };
+
+    // 共享内存布局：头部、domains×domains个邮箱（from→to）、domains个结果槽
+    struct DomainLayout
+    {
+        char *base;
+        int domains;
+
+        static size_t mailboxOffset() { return (sizeof(DomainHeader) + 63) / 64 * 64; }
+        static size_t totalSize(int domains)
+        {
+            return mailboxOffset() + sizeof(Mailbox) * domains * domains + sizeof(DomainResultSlot) * domains;
+        }
+        DomainHeader *header() const { return reinterpret_cast<DomainHeader *>(base); }
+        Mailbox *mailbox(int from, int to) const
+        {
+            return reinterpret_cast<Mailbox *>(base + mailboxOffset()) + from * domains + to;
+        }
+        DomainResultSlot *result(int index) const
+        {
+            return reinterpret_cast<DomainResultSlot *>(base + mailboxOffset() + sizeof(Mailbox) * domains * domains) + index;
+        }
+    };
+
+    // 走廊按x坐标等分：x所属的分域
+    int domainOf(int x, int width, int domains)
+    {
+        long long k = (long long)x * domains / width;
+        return (int)max(0LL, min((long long)domains - 1, k));
+    }
+
+    // 分域k覆盖的x范围[lo, hi]
+    void domainRange(int k, int width, int domains, int &lo, int &hi)
+    {
+        lo = (int)(((long long)k * width + domains - 1) / domains);
+        hi = k == domains - 1 ? width : (int)(((long long)(k + 1) * width + domains - 1) / domains) - 1;
+    }
+
+    bool byId(const Vehicle &a, const Vehicle &b) { return a.id < b.id; }
+
+    // 跟车、警告恢复、生成新车和同一间隙判断用到的最大距离（不含车长）
+    int maxSafeDistance(const SimParams &params)
+    {
+        SafeDistanceTable table(params);
+        int distance = max(params.safeDistance, params.crashDistance);
+        for (int d : table.distance)
+        {
+            distance = max(distance, d);
+        }
+        return distance;
+    }
+
+    // 按相同配置建立初始状态（单进程和各分域完全一致）
+    Simulation makeInitialState(const DomainConfig &config)
+    {
+        Simulation sim(config.corridorWidth, config.windowHeight, config.scale, config.widthScale, config.seed);
+        sim.params.logRelativeSpeed = false;
+        WarmStartConfig warm;
+        for (auto &lane : warm.lanes)
+        {
+            lane.density = config.density;
+        }
+        warmStart(sim, warm);
+        return sim;
+    }
+
+    // 比较两辆车的全部仿真状态
+    bool sameVehicleState(const Vehicle &a, const Vehicle &b)
+    {
+        return a.id == b.id && a.lane == b.lane && a.carlength == b.carlength && a.carwidth == b.carwidth &&
+               a.x == b.x && a.y == b.y && a.speed == b.speed && a.haschanged == b.haschanged &&
+               a.color == b.color && a.isChangingLane == b.isChangingLane && a.isGoing2change == b.isGoing2change &&
+               a.targetLane == b.targetLane && a.changeProgress == b.changeProgress &&
+               a.startX == b.startX && a.startY == b.startY && a.endX == b.endX && a.endY == b.endY &&
+               a.isTooClose == b.isTooClose && a.originalColor == b.originalColor &&
+               a.isBrokenDown == b.isBrokenDown && a.type == b.type && a.rng.state == b.rng.state;
+    }
+
+    // 单个分域的仿真进程
+    struct DomainWorker
+    {
+        DomainLayout layout;
+        DomainConfig config;
+        int index;
+        int lo, hi;                    // 本分域的x范围
+        Simulation sim;                // sim.vehicles为本分域拥有的车辆
+        vector<Vehicle> ghosts;        // 相邻分域的影子车辆（只读副本）
+        vector<int> ghostOwner;        // 每辆影子车辆的所属分域
+        vector<deque<DomainMessage>> backlog; // 发送时为腾出邮箱空间提前取出的消息
+        int maxSpeed, maxLength;       // 所有分域车辆的最大速度和车长（上一帧结束时交换）
+        int safeDistance;              // maxSafeDistance(sim.params)
+        int ghostWidth;                // 本帧使用的影子车辆区宽度
+
+        DomainWorker(const DomainLayout &l, int k)
+            : layout(l), config(l.header()->config), index(k), sim(makeInitialState(config)),
+              backlog(config.domains), maxSpeed(0), maxLength(0), safeDistance(maxSafeDistance(sim.params))
+        {
+            domainRange(index, config.corridorWidth, config.domains, lo, hi);
+            // 初始状态各进程相同，直接按位置划分拥有的车辆和影子车辆
+            vector<Vehicle> all;
+            all.swap(sim.vehicles);
+            for (const auto &v : all)
+            {
+                maxSpeed = max(maxSpeed, abs(v.speed));
+                maxLength = max(maxLength, v.carlength);
+            }
+            updateGhostWidth();
+            for (const auto &v : all)
+            {
+                int owner = domainOf(v.x, config.corridorWidth, config.domains);
+                if (owner == index)
+                {
+                    sim.vehicles.push_back(v);
+                }
+                else if (isGhostFor(v.x, index))
+                {
+                    ghosts.push_back(v);
+                    ghostOwner.push_back(owner);
+                }
+            }
+        }
+
+        void updateGhostWidth()
+        {
+            ghostWidth = config.ghostWidth > 0 ? config.ghostWidth : defaultGhostWidth(sim.params, maxSpeed, maxLength);
+        }
+
+        // x处的车辆是否需要作为影子车辆发给分域k
+        bool isGhostFor(int x, int k) const
+        {
+            int klo, khi;
+            domainRange(k, config.corridorWidth, config.domains, klo, khi);
+            return x >= klo - ghostWidth && x <= khi + ghostWidth;
+        }
+
+        // 分域k的车辆（包括候选车辆）是否可能与候选车辆v接触，需要参与v的轨迹检查和第二遍判断：
+        // 本帧前进后，k的车辆最多越出k的范围maxSpeed。预测帧数取上限，
+        // 覆盖其他候选车辆按自己的预测帧数比较轨迹的距离；只依赖车辆状态和全局上界，各分域算出的范围一致
+        bool candidateReaches(const Vehicle &v, const LaneIndex &laneIndex, int k) const
+        {
+            int klo, khi;
+            domainRange(k, config.corridorWidth, config.domains, klo, khi);
+            int reach = max(laneIndex.reach(v, sim.params.maxPredictionSteps), (v.carlength + maxLength) / 2 + safeDistance);
+            return v.x + reach >= klo - maxSpeed && v.x - reach <= khi + maxSpeed;
+        }
+
+        // 取出所有邮箱中已到达的消息暂存，避免互相等待对方腾出空间
+        void drainInboxes()
+        {
+            DomainMessage message;
+            for (int from = 0; from < config.domains; ++from)
+            {
+                if (from == index)
+                    continue;
+                while (layout.mailbox(from, index)->tryPop(message))
+                {
+                    backlog[from].push_back(message);
+                }
+            }
+        }
+
+        // 对方进程失败后不会再收发消息，等待中检查中止标记
+        void checkAbort() const
+        {
+            if (layout.header()->abort.load(memory_order_relaxed) != 0)
+                throw DomainAborted();
+        }
+
+        void send(int to, DomainMessage &message)
+        {
+            message.tick = (int32_t)sim.tick;
+            while (!layout.mailbox(index, to)->tryPush(message))
+            {
+                drainInboxes();
+                checkAbort();
+                this_thread::yield();
+            }
+        }
+
+        void send(int to, int32_t kind, int32_t value, const Vehicle *vehicle)
+        {
+            DomainMessage message;
+            message.kind = kind;
+            message.value = value;
+            message.reserved = 0;
+            if (vehicle != nullptr)
+                message.vehicle = *vehicle;
+            send(to, message);
+        }
+
+        void broadcastEnd(int32_t kind, int32_t value = 0, int32_t reserved = 0)
+        {
+            DomainMessage message;
+            message.kind = kind;
+            message.value = value;
+            message.reserved = reserved;
+            for (int to = 0; to < config.domains; ++to)
+            {
+                if (to != index)
+                    send(to, message);
+            }
+        }
+
+        // 轮流读取各分域的消息直到收齐所有分域的结束标记，onEnd处理结束标记带的数据
+        template <typename Handler>
+        void receiveUntil(int32_t endKind, Handler handle)
+        {
+            receiveUntil(endKind, handle, [](const DomainMessage &) {});
+        }
+
+        template <typename Handler, typename EndHandler>
+        void receiveUntil(int32_t endKind, Handler handle, EndHandler onEnd)
+        {
+            vector<bool> done(config.domains, false);
+            done[index] = true;
+            int remaining = config.domains - 1;
+            while (remaining > 0)
+            {
+                bool progressed = false;
+                for (int from = 0; from < config.domains; ++from)
+                {
+                    if (done[from])
+                        continue;
+                    DomainMessage message;
+                    bool got = false;
+                    if (!backlog[from].empty())
+                    {
+                        message = backlog[from].front();
+                        backlog[from].pop_front();
+                        got = true;
+                    }
+                    else
+                    {
+                        got = layout.mailbox(from, index)->tryPop(message);
+                    }
+                    if (!got)
+                        continue;
+                    progressed = true;
+                    if (message.kind == endKind)
+                    {
+                        onEnd(message);
+                        done[from] = true;
+                        --remaining;
+                    }
+                    else
+                    {
+                        handle(from, message);
+                    }
+                }
+                if (!progressed)
+                {
+                    checkAbort();
+                    this_thread::yield();
+                }
+            }
+        }
+
+        // 推进一帧，与Simulation::step的结果一致
+        void step()
+        {
+            SimulationScope scope(sim);
+            vector<Vehicle> &owned = sim.vehicles;
+            int width = config.corridorWidth;
+
+            for (auto &v : owned)
+            {
+                v.isFlashing = false;
+            }
+
+            // 生成新车：所有分域消耗相同的随机数，只有入口所在的分域真正放置车辆
+            SpawnAttempt attempt;
+            if (sim.sampleSpawn(attempt))
+            {
+                int entryX = sim.laneKernels.topology.direction(attempt.lane) > 0 ? 0 : width;
+                if (domainOf(entryX, width, config.domains) == index &&
+                    sim.isSpawnSafe(attempt, owned) && sim.isSpawnSafe(attempt, ghosts))
+                {
+                    owned.push_back(sim.makeVehicle(attempt));
+                }
+                // 新车可能出现在快照中
+                maxSpeed = max(maxSpeed, attempt.speed);
+                maxLength = max(maxLength, attempt.carlength);
+            }
+            size_t brokenBefore = countBrokenDown(owned);
+
+            // 第一阶段：前进（影子车辆也按同样规则前进，与所属分域一致）
+            sim.moveVehicles(owned);
+            sim.moveVehicles(ghosts);
+
+            // 第二阶段：基于本地车辆和影子车辆合并的快照（按编号排序，与单进程遍历顺序一致）
+            vector<Vehicle> snapshot;
+            snapshot.reserve(owned.size() + ghosts.size());
+            merge(owned.begin(), owned.end(), ghosts.begin(), ghosts.end(), back_inserter(snapshot), byId);
+            vector<int> crashedIds;
+            sim.followVehicles(owned, snapshot, crashedIds);
+            sim.advanceLaneChanges(owned);
+            resolveLaneChanges(snapshot);
+            sim.recoverVehicles(owned, snapshot);
+
+            // 被撞的车辆：自己的直接处理，影子车辆通知所属分域
+            sort(crashedIds.begin(), crashedIds.end());
+            crashedIds.erase(unique(crashedIds.begin(), crashedIds.end()), crashedIds.end());
+            for (int id : crashedIds)
+            {
+                auto it = lower_bound(owned.begin(), owned.end(), id, [](const Vehicle &v, int value) { return v.id < value; });
+                if (it != owned.end() && it->id == id)
+                {
+                    it->handleDangerousSituation();
+                    continue;
+                }
+                for (size_t g = 0; g < ghosts.size(); ++g)
+                {
+                    if (ghosts[g].id == id)
+                    {
+                        send(ghostOwner[g], MSG_CRASH, id, nullptr);
+                        break;
+                    }
+                }
+            }
+            // 结束标记同时带上本分域车辆的最大速度和车长，决定下一帧的影子车辆区和候选车辆的发送范围
+            int ownSpeed = 0, ownLength = 0;
+            for (const auto &v : owned)
+            {
+                ownSpeed = max(ownSpeed, abs(v.speed));
+                ownLength = max(ownLength, v.carlength);
+            }
+            maxSpeed = ownSpeed;
+            maxLength = ownLength;
+            broadcastEnd(MSG_END_CRASH, ownSpeed, ownLength);
+            receiveUntil(MSG_END_CRASH, [&](int, const DomainMessage &message)
+                         {
+                             auto it = lower_bound(owned.begin(), owned.end(), message.value,
+                                                   [](const Vehicle &v, int value) { return v.id < value; });
+                             if (it != owned.end() && it->id == message.value)
+                                 it->handleDangerousSituation();
+                         },
+                         [&](const DomainMessage &end)
+                         {
+                             maxSpeed = max(maxSpeed, (int)end.value);
+                             maxLength = max(maxLength, (int)end.reserved);
+                         });
+            sim.brokenDownCount += (long long)(countBrokenDown(owned) - brokenBefore);
+            updateGhostWidth();
+
+            // 移除离开走廊的车辆，驶入其他分域的车辆转交所有权；
+            // 同时按新的所属分域把车辆作为影子车辆发给需要它的分域（转交的车辆也要发，
+            // 否则新所属分域要到下一帧才会转发，相邻分域会缺少这辆车一帧）
+            ghosts.clear();
+            ghostOwner.clear();
+            vector<pair<Vehicle, int>> nextGhosts;
+            vector<Vehicle> kept;
+            kept.reserve(owned.size());
+            for (const auto &v : owned)
+            {
+                if (v.x < 0 || v.x > width)
+                {
+                    ++sim.exitedCount;
+                    continue;
+                }
+                int owner = domainOf(v.x, width, config.domains);
+                for (int to = 0; to < config.domains; ++to)
+                {
+                    if (to == index)
+                        continue;
+                    if (to == owner)
+                        send(to, MSG_MIGRATE, owner, &v);
+                    else if (isGhostFor(v.x, to))
+                        send(to, MSG_GHOST, owner, &v);
+                }
+                if (owner == index)
+                    kept.push_back(v);
+                else if (isGhostFor(v.x, index))
+                    nextGhosts.push_back(make_pair(v, owner));
+            }
+            owned.swap(kept);
+            broadcastEnd(MSG_END_STATE);
+
+            receiveUntil(MSG_END_STATE, [&](int, const DomainMessage &message)
+                         {
+                             if (message.kind == MSG_MIGRATE)
+                                 owned.push_back(message.vehicle);
+                             else if (message.kind == MSG_GHOST)
+                                 nextGhosts.push_back(make_pair(message.vehicle, (int)message.value));
+                         });
+            sort(owned.begin(), owned.end(), byId);
+            sort(nextGhosts.begin(), nextGhosts.end(), [](const pair<Vehicle, int> &a, const pair<Vehicle, int> &b)
+                 { return a.first.id < b.first.id; });
+            for (const auto &g : nextGhosts)
+            {
+                ghosts.push_back(g.first);
+                ghostOwner.push_back(g.second);
+            }
+
+            sim.time += 0.2;
+            ++sim.tick;
+        }
+
+        // 批量变道判断（与单进程的resolveLaneChanges结果相同）：
+        // 1. 本分域的候选车辆发给可能与它接触的分域，收到其他分域的候选车辆
+        // 2. 各分域用本地快照检查已知候选车辆的轨迹，把结果发给同样知道这辆车的其他分域，取与后得到完整结果
+        // 3. 用完整结果对本分域的候选车辆做第二遍判断
+        // 影子车辆区只需覆盖跟车距离：轨迹检查范围内的远处车辆由它们的所属分域检查
+        void resolveLaneChanges(const vector<Vehicle> &snapshot)
+        {
+            LaneChangeBatch batch;
+            batch.collect(sim.vehicles, sim.laneCount);
+            vector<int> candidateOwner(batch.candidates.size(), index);
+
+            // 快照统计用所有分域的上界，各分域算出的接触范围一致
+            LaneIndex laneIndex(snapshot, sim.laneCount);
+            laneIndex.maxSpeed = maxSpeed;
+            laneIndex.maxLength = maxLength;
+
+            for (size_t i = 0; i < batch.candidates.size(); ++i)
+            {
+                for (int to = 0; to < config.domains; ++to)
+                {
+                    if (to != index && candidateReaches(batch.states[i], laneIndex, to))
+                        send(to, MSG_CANDIDATE, batch.candidates[i].target, &batch.states[i]);
+                }
+            }
+            broadcastEnd(MSG_END_CANDIDATES);
+            receiveUntil(MSG_END_CANDIDATES, [&](int from, const DomainMessage &message)
+                         {
+                             batch.addRemote(message.vehicle, message.value);
+                             candidateOwner.push_back(from);
+                         });
+            if (batch.candidates.empty())
+            {
+                // 其他分域同样没有发来需要本分域检查的候选车辆，但仍要参与这一轮交换
+                broadcastEnd(MSG_END_SAFETY);
+                receiveUntil(MSG_END_SAFETY, [](int, const DomainMessage &) {});
+                return;
+            }
+
+            batch.checkPaths(laneIndex, sim.laneHeight);
+            vector<pair<int, int>> byCandidateId; // (编号, 下标)
+            for (int i = 0; i < (int)batch.candidates.size(); ++i)
+            {
+                const LaneChangeCandidate &c = batch.candidates[i];
+                byCandidateId.push_back(make_pair(c.id, i));
+                for (int to = 0; to < config.domains; ++to)
+                {
+                    if (to != index && (to == candidateOwner[i] || candidateReaches(batch.states[i], laneIndex, to)))
+                    {
+                        DomainMessage message;
+                        message.kind = MSG_SAFETY;
+                        message.value = c.id;
+                        message.reserved = c.safe ? 1 : 0;
+                        send(to, message);
+                    }
+                }
+            }
+            sort(byCandidateId.begin(), byCandidateId.end());
+            broadcastEnd(MSG_END_SAFETY);
+            receiveUntil(MSG_END_SAFETY, [&](int, const DomainMessage &message)
+                         {
+                             auto it = lower_bound(byCandidateId.begin(), byCandidateId.end(), make_pair((int)message.value, -1));
+                             if (it != byCandidateId.end() && it->first == message.value && message.reserved == 0)
+                                 batch.candidates[it->second].safe = false;
+                         });
+
+            batch.grant(laneIndex, sim.laneCount);
+            batch.apply(sim.laneHeight);
+        }
+    };
+
+#ifdef _WIN32
+    // 等待所有工作进程退出：任一进程失败时置中止标记，其余进程在等待中看到后退出，超过宽限时间仍未退出的强制结束
+    bool reapWorkers(DomainHeader *header, vector<PROCESS_INFORMATION> &processes, bool ok)
+    {
+        if (!ok)
+            header->abort.store(1);
+        auto abortedAt = chrono::steady_clock::now();
+        while (!processes.empty())
+        {
+            vector<HANDLE> handles;
+            for (auto &process : processes)
+            {
+                handles.push_back(process.hProcess);
+            }
+            DWORD wait = WaitForMultipleObjects((DWORD)handles.size(), handles.data(), FALSE, 10);
+            if (wait >= WAIT_OBJECT_0 && wait < WAIT_OBJECT_0 + handles.size())
+            {
+                PROCESS_INFORMATION &process = processes[wait - WAIT_OBJECT_0];
+                DWORD exitCode = 1;
+                GetExitCodeProcess(process.hProcess, &exitCode);
+                if (exitCode != 0 && ok)
+                {
+                    ok = false;
+                    header->abort.store(1);
+                    abortedAt = chrono::steady_clock::now();
+                }
+                CloseHandle(process.hThread);
+                CloseHandle(process.hProcess);
+                processes.erase(processes.begin() + (wait - WAIT_OBJECT_0));
+            }
+            else if (!ok && chrono::steady_clock::now() - abortedAt > ABORT_GRACE)
+            {
+                for (auto &process : processes)
+                {
+                    TerminateProcess(process.hProcess, 1);
+                }
+            }
+        }
+        return ok;
+    }
+
+    // 以 --domain-worker 参数重新启动本程序作为工作进程
+    bool launchWorkers(const string &regionName, DomainHeader *header, int domains)
+    {
+        char path[MAX_PATH];
+        GetModuleFileNameA(NULL, path, MAX_PATH);
+        vector<PROCESS_INFORMATION> processes;
+        bool launched = true;
+        for (int k = 0; k < domains && launched; ++k)
+        {
+            string commandLine = "\"" + string(path) + "\" --domain-worker " + regionName + " " + to_string(k);
+            vector<char> buffer(commandLine.begin(), commandLine.end());
+            buffer.push_back('\0');
+            STARTUPINFOA startup;
+            ZeroMemory(&startup, sizeof(startup));
+            startup.cb = sizeof(startup);
+            PROCESS_INFORMATION process;
+            launched = CreateProcessA(path, buffer.data(), NULL, NULL, FALSE, 0, NULL, NULL, &startup, &process) != 0;
+            if (launched)
+                processes.push_back(process);
+        }
+        return reapWorkers(header, processes, launched);
+    }
+#else
+    // 等待所有子进程退出：任一子进程失败（非零退出或被信号终止）时置中止标记，其余子进程在等待中看到后退出，
+    // 超过宽限时间仍未退出的强制结束
+    bool reapWorkers(DomainHeader *header, vector<pid_t> &children, bool ok)
+    {
+        if (!ok)
+            header->abort.store(1);
+        auto abortedAt = chrono::steady_clock::now();
+        while (!children.empty())
+        {
+            bool reaped = false;
+            for (size_t i = 0; i < children.size();)
+            {
+                int status = 0;
+                pid_t pid = waitpid(children[i], &status, WNOHANG);
+                if (pid == 0)
+                {
+                    ++i;
+                    continue;
+                }
+                if ((pid < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) && ok)
+                {
+                    ok = false;
+                    header->abort.store(1);
+                    abortedAt = chrono::steady_clock::now();
+                }
+                children.erase(children.begin() + i);
+                reaped = true;
+            }
+            if (!ok && chrono::steady_clock::now() - abortedAt > ABORT_GRACE)
+            {
+                for (pid_t pid : children)
+                {
+                    kill(pid, SIGKILL);
+                }
+            }
+            if (!reaped && !children.empty())
+                this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        return ok;
+    }
+
+    // 派生子进程直接运行工作进程入口
+    bool launchWorkers(const string &regionName, DomainHeader *header, int domains)
+    {
+        vector<pid_t> children;
+        bool launched = true;
+        for (int k = 0; k < domains && launched; ++k)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                _exit(runDomainWorker(regionName, k));
+            }
+            launched = pid > 0;
+            if (launched)
+                children.push_back(pid);
+        }
+        return reapWorkers(header, children, launched);
+    }
+#endif
+}
+
+int defaultGhostWidth(const SimParams &params, int maxSpeed, int maxLength)
+{
+    // 车辆前进后最多越出所属分域maxSpeed，影子车辆同样最多移动maxSpeed，
+    // 跟车、警告恢复、生成新车检查和同一间隙判断的两车中心距离不超过最大安全距离加车长
+    return 2 * maxSpeed + maxSafeDistance(params) + maxLength + 1;
+}
+
+DomainRunResult runSingleDomain(const DomainConfig &config)
+{
+    Simulation sim = makeInitialState(config);
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < config.ticks; ++i)
+    {
+        sim.step();
+    }
+    DomainRunResult result;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.vehicles = sim.vehicles;
+    result.exitedCount = sim.exitedCount;
+    result.brokenDownCount = sim.brokenDownCount;
+    return result;
+}
+
+int runDomainWorker(const string &regionName, int index)
+{
+    SharedMemory region;
+    // 先只映射头部读出分域数，再映射整个区域
+    if (!region.open(regionName, sizeof(DomainHeader)))
+        return 1;
+    int domains = reinterpret_cast<DomainHeader *>(region.data)->config.domains;
+    if (!region.open(regionName, DomainLayout::totalSize(domains)))
+        return 1;
+    DomainLayout layout = {static_cast<char *>(region.data), domains};
+    if (layout.header()->magic != DOMAIN_MAGIC || index < 0 || index >= domains)
+        return 1;
+
+    DomainWorker worker(layout, index);
+
+    double seconds = 0;
+    try
+    {
+        // 所有分域初始化完成后同时开始
+        layout.header()->ready.fetch_add(1);
+        while (layout.header()->ready.load() < domains)
+        {
+            worker.checkAbort();
+            this_thread::yield();
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < worker.config.ticks; ++i)
+        {
+            worker.step();
+        }
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    catch (const DomainAborted &)
+    {
+        return 1;
+    }
+
+    DomainResultSlot *slot = layout.result(index);
+    if ((int)worker.sim.vehicles.size() > MAX_RESULT_VEHICLES)
+    {
+        layout.header()->abort.store(1);
+        return 1;
+    }
+    slot->count = (int32_t)worker.sim.vehicles.size();
+    copy(worker.sim.vehicles.begin(), worker.sim.vehicles.end(), slot->vehicles);
+    slot->exitedCount = worker.sim.exitedCount;
+    slot->brokenDownCount = worker.sim.brokenDownCount;
+    slot->seconds = seconds;
+    slot->ok = 1;
+    return 0;
+}
+
+bool runDomainProcesses(const DomainConfig &config, DomainRunResult &result)
+{
+    if (config.domains < 1 || config.domains > MAX_DOMAINS)
+        return false;
+
+    char regionName[64];
+    snprintf(regionName, sizeof(regionName), "CarSimDomains_%u_%d", (unsigned)chrono::steady_clock::now().time_since_epoch().count(), config.domains);
+    SharedMemory region;
+    if (!region.create(regionName, DomainLayout::totalSize(config.domains)))
+        return false;
+
+    DomainLayout layout = {static_cast<char *>(region.data), config.domains};
+    DomainHeader *header = new (layout.header()) DomainHeader;
+    header->config = config;
+    header->ready.store(0);
+    header->abort.store(0);
+    for (int from = 0; from < config.domains; ++from)
+    {
+        for (int to = 0; to < config.domains; ++to)
+        {
+            Mailbox *mailbox = layout.mailbox(from, to);
+            new (&mailbox->head) atomic<uint32_t>(0);
+            new (&mailbox->tail) atomic<uint32_t>(0);
+        }
+    }
+    header->magic = DOMAIN_MAGIC;
+
+    if (!launchWorkers(regionName, header, config.domains))
+        return false;
+
+    result = DomainRunResult();
+    for (int k = 0; k < config.domains; ++k)
+    {
+        DomainResultSlot *slot = layout.result(k);
+        if (!slot->ok)
+            return false;
+        result.vehicles.insert(result.vehicles.end(), slot->vehicles, slot->vehicles + slot->count);
+        result.exitedCount += slot->exitedCount;
+        result.brokenDownCount += slot->brokenDownCount;
+        result.seconds = max(result.seconds, slot->seconds);
+    }
+    sort(result.vehicles.begin(), result.vehicles.end(), byId);
+    return true;
+}
+
+int runDomainLauncher(const DomainConfig &config)
+{
+    DomainConfig base = config;
+    if (base.ghostWidth > 0)
+    {
+        printf("corridor: %d px  ticks: %d  ghost width: %d px\n", base.corridorWidth, base.ticks, base.ghostWidth);
+    }
+    else
+    {
+        // 影子车辆区每帧按所有车辆的最大速度和车长计算，这里显示初始值
+        Simulation initial = makeInitialState(base);
+        int maxSpeed = 0, maxLength = 0;
+        for (const auto &v : initial.vehicles)
+        {
+            maxSpeed = max(maxSpeed, abs(v.speed));
+            maxLength = max(maxLength, v.carlength);
+        }
+        printf("corridor: %d px  ticks: %d  ghost width: %d px (initial, per tick)\n", base.corridorWidth, base.ticks,
+               defaultGhostWidth(initial.params, maxSpeed, maxLength));
+    }
+
+    DomainRunResult reference = runSingleDomain(base);
+    printf("%8s %10s %10s %10s %10s %8s %6s\n", "domains", "vehicles", "exited", "broken", "time(s)", "speedup", "match");
+    printf("%8s %10d %10lld %10lld %10.3f %8s %6s\n", "single", (int)reference.vehicles.size(),
+           reference.exitedCount, reference.brokenDownCount, reference.seconds, "1.00", "-");
+
+    // 依次以1、2、4……个进程运行，最后一次使用请求的分域数
+    vector<int> counts;
+    for (int n = 1; n < base.domains; n *= 2)
+    {
+        counts.push_back(n);
+    }
+    counts.push_back(base.domains);
+
+    bool allMatch = true;
+    for (int n : counts)
+    {
+        DomainConfig run = base;
+        run.domains = n;
+        DomainRunResult result;
+        if (!runDomainProcesses(run, result))
+        {
+            printf("%8d  failed to run domain processes\n", n);
+            return 1;
+        }
+        bool match = result.exitedCount == reference.exitedCount &&
+                     result.brokenDownCount == reference.brokenDownCount &&
+                     result.vehicles.size() == reference.vehicles.size() &&
+                     equal(result.vehicles.begin(), result.vehicles.end(), reference.vehicles.begin(), sameVehicleState);
+        allMatch = allMatch && match;
+        printf("%8d %10d %10lld %10lld %10.3f %8.2f %6s\n", n, (int)result.vehicles.size(), result.exitedCount,
+               result.brokenDownCount, result.seconds, reference.seconds / max(result.seconds, 1e-9), match ? "yes" : "NO");
+    }
+    return allMatch ? 0 : 1;
+}
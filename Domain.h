@@ -0,0 +1,42 @@
+﻿#include <vector>
+#include <string>
+#include "Simulation.h"
+using namespace std;
+
+// 分域运行配置：走廊按x范围等分成若干段，每段由一个进程仿真
+struct DomainConfig
+{
+    int domains = 2;           // 分域（进程）数
+    int ticks = 1000;          // 推进的帧数
+    uint64_t seed = 1;         // 随机种子（与单进程对照运行相同）
+    double density = 6;        // 热启动密度（辆/100米/车道）
+    int corridorWidth = 0;     // 走廊长度（像素）
+    int windowHeight = 0;      // 桥面宽度（像素）
+    double scale = 1, widthScale = 1;
+    int ghostWidth = 0;        // 影子车辆区宽度（像素），0表示每帧按当前最大速度和车长自动计算
+};
+
+// 单个分域（或单进程对照）的运行结果
+struct DomainRunResult
+{
+    vector<Vehicle> vehicles;  // 最终车辆状态（按编号排列）
+    long long exitedCount = 0;
+    long long brokenDownCount = 0;
+    double seconds = 0;        // 推进所用时间（不含初始化）
+};
+
+// 影子车辆区宽度：一帧内双方的前进距离加上跟车（和同一间隙内变道）的最大安全距离和车长。
+// 变道轨迹预测的范围远大于此，但不需要影子车辆：候选车辆本身发给预测范围内的分域，
+// 各分域用自己的车辆检查它的轨迹，交换结果（见DomainWorker::step）
+int defaultGhostWidth(const SimParams &params, int maxSpeed, int maxLength);
+
+// 单进程对照运行：与分域运行使用相同的初始状态和随机种子
+DomainRunResult runSingleDomain(const DomainConfig &config);
+// 启动config.domains个本地进程分域运行，通过共享内存交换边界车辆，汇总结果
+bool runDomainProcesses(const DomainConfig &config, DomainRunResult &result);
+// 分域工作进程入口（由启动器以 --domain-worker <共享内存名> <序号> 启动）
+int runDomainWorker(const string &regionName, int index);
+// 启动器：依次以1、2、4……个进程运行，与单进程结果逐车比较并输出耗时和加速比
+int runDomainLauncher(const DomainConfig &config);
+
+#pragma once
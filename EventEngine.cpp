@@ -0,0 +1,394 @@
+﻿#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "EventEngine.h"
+#include "VehicleTypes.h"
+using namespace std;
+
+namespace
+{
+    // 正整数的向上取整除法
+    long long ceilDiv(long long a, long long b)
+    {
+        return (a + b - 1) / b;
+    }
+
+    // 每帧的位移（与Vehicle::moveForward一致）
+    long long displacement(const Vehicle &v)
+    {
+        return v.direction() * v.speed;
+    }
+
+    // 正在进行的变道每帧都在推进
+    bool isAdvancingLaneChange(const Vehicle &v)
+    {
+        return v.isGoing2change && v.isChangingLane && !v.isBrokenDown;
+    }
+
+    // 下一帧需要逐帧处理的车辆：等待变道（每帧都要判断并消耗随机数）、
+    // 速度降为0但尚未抛锚（下一帧前进时抛锚）、处于距离警告状态
+    bool needsFullStep(const Vehicle &v)
+    {
+        return (v.isGoing2change && !v.isChangingLane && !v.isBrokenDown) ||
+               (v.speed == 0 && !v.isBrokenDown) || v.isTooClose;
+    }
+
+    // 两次推进的最终状态是否一致（isFlashing只用于绘制，不比较）
+    bool sameState(const Simulation &a, const Simulation &b)
+    {
+        if (a.tick != b.tick || a.time != b.time || a.engine.state != b.engine.state ||
+            a.nextVehicleId != b.nextVehicleId || a.exitedCount != b.exitedCount ||
+            a.brokenDownCount != b.brokenDownCount || a.vehicles.size() != b.vehicles.size())
+            return false;
+        for (size_t i = 0; i < a.vehicles.size(); ++i)
+        {
+            const Vehicle &u = a.vehicles[i];
+            const Vehicle &v = b.vehicles[i];
+            if (u.id != v.id || u.lane != v.lane || u.x != v.x || u.y != v.y || u.speed != v.speed ||
+                u.carlength != v.carlength || u.carwidth != v.carwidth || u.type != v.type ||
+                u.haschanged != v.haschanged || u.isChangingLane != v.isChangingLane ||
+                u.isGoing2change != v.isGoing2change || u.targetLane != v.targetLane ||
+                u.changeProgress != v.changeProgress || u.isBrokenDown != v.isBrokenDown ||
+                u.isTooClose != v.isTooClose || u.rng.state != v.rng.state)
+                return false;
+        }
+        return true;
+    }
+
+    bool eventOrder(const TrafficEvent &a, const TrafficEvent &b)
+    {
+        if (a.kind != b.kind)
+            return a.kind < b.kind;
+        if (a.vehicleId != b.vehicleId)
+            return a.vehicleId < b.vehicleId;
+        return a.tick < b.tick;
+    }
+}
+
+void EventEngine::push(long long tick, SimEventKind kind, int vehicleId, int otherId)
+{
+    SimEvent event;
+    event.tick = tick;
+    event.kind = kind;
+    event.vehicleId = vehicleId;
+    event.otherId = otherId;
+    queue.push(event);
+}
+
+long long EventEngine::followTick(const Vehicle &follower, const Vehicle &leader, int threshold)
+{
+    // 沿行驶方向的间距u(t) = u0 + w*t，leader在前方且间距不超过H时checkFrontVehicleDistance会处理
+    long long direction = follower.direction();
+    long long u0 = direction * (leader.x - follower.x);
+    long long w = direction * (displacement(leader) - displacement(follower));
+    long long H = threshold + (leader.carlength / 2 + follower.carlength / 2);
+    if (H < 1)
+        return -1;
+
+    if (w == 0)
+        return (u0 > 0 && u0 <= H) ? 1 : -1;
+    if (w < 0)
+    {
+        // 间距缩小：第一次不超过H的帧，此时前车必须还在前方
+        long long t = u0 > H ? ceilDiv(u0 - H, -w) : 1;
+        return u0 + w * t >= 1 ? t : -1;
+    }
+    // 间距增大：第一次成为前车的帧，此时间距必须还不超过H
+    long long t = u0 <= 0 ? -u0 / w + 1 : 1;
+    return u0 + w * t <= H ? t : -1;
+}
+
+long long EventEngine::exitTick(const Vehicle &v) const
+{
+    long long dx = displacement(v);
+    if (dx > 0)
+        return max(0LL, (long long)sim.windowWidth - v.x) / dx + 1;
+    if (dx < 0)
+        return max(0LL, (long long)v.x) / -dx + 1;
+    return -1;
+}
+
+long long EventEngine::laneChangeTick(const Vehicle &v)
+{
+    // 按advanceLaneChange的单精度累加方式计算，保证与逐帧推进在同一帧完成
+    float progress = v.changeProgress;
+    float rate = v.laneChangeRate();
+    long long t = 0;
+    do
+    {
+        progress += rate;
+        ++t;
+    } while (progress < 1.0f);
+    return t;
+}
+
+void EventEngine::schedule(long long horizon)
+{
+    queue = priority_queue<SimEvent, vector<SimEvent>, greater<SimEvent>>();
+    ++stats.schedules;
+
+    long long now = sim.tick;
+    // 外部需求来源的生成时刻未知，只能逐帧推进
+    if (sim.spawnSource)
+    {
+        push(now + 1, SimEventKind::ARRIVAL, 0);
+        return;
+    }
+
+    long long earliest = horizon; // 已知最早事件，更晚的事件不必入队
+    auto add = [&](long long dt, SimEventKind kind, int vehicleId, int otherId)
+    {
+        if (dt < 1 || now + dt > earliest)
+            return;
+        earliest = now + dt;
+        push(now + dt, kind, vehicleId, otherId);
+    };
+
+    // 单车事件：逐帧状态、变道完成、驶离桥面
+    vector<vector<const Vehicle *>> lanes(sim.laneCount);
+    for (const auto &v : sim.vehicles)
+    {
+        if (needsFullStep(v))
+            add(1, SimEventKind::ACTIVE, v.id, 0);
+        if (isAdvancingLaneChange(v))
+            add(laneChangeTick(v), SimEventKind::LANE_CHANGE, v.id, 0);
+        add(exitTick(v), SimEventKind::EXIT, v.id, 0);
+        if (v.lane >= 0 && v.lane < sim.laneCount)
+            lanes[v.lane].push_back(&v);
+    }
+
+    // 车对事件：同车道的每一对车辆，后车进入安全距离或碰撞距离（取两者中较大的）
+    // 两车都已停止且后车已抛锚时，跟车判断不会改变任何状态，不作为事件
+    SafeDistanceTable safeDistances(sim.params);
+    for (const auto &lane : lanes)
+    {
+        for (const Vehicle *follower : lane)
+        {
+            int threshold = max(safeDistances[follower->type], sim.params.crashDistance);
+            for (const Vehicle *leader : lane)
+            {
+                if (leader == follower)
+                    continue;
+                if (follower->speed == 0 && follower->isBrokenDown && leader->speed == 0)
+                    continue;
+                add(followTick(*follower, *leader, threshold), SimEventKind::FOLLOW, follower->id, leader->id);
+            }
+        }
+    }
+
+    // 到达事件：生成判定只消耗随机数、与车辆状态无关，用引擎副本向前看到最早的事件为止
+    SimRandom lookahead = sim.engine;
+    uint64_t period = (uint64_t)max(1, sim.params.spawnPeriod);
+    for (long long dt = 1; now + dt <= earliest; ++dt)
+    {
+        if (lookahead() % period == 0)
+        {
+            add(dt, SimEventKind::ARRIVAL, 0, 0);
+            break;
+        }
+    }
+}
+
+void EventEngine::coast(long long n)
+{
+    if (n <= 0)
+        return;
+
+    for (auto &v : sim.vehicles)
+    {
+        v.isFlashing = false;
+        if (isAdvancingLaneChange(v))
+        {
+            // 变道中的车辆y随进度变化，逐帧推进（不会在滑行期间完成）
+            for (long long k = 0; k < n; ++k)
+            {
+                v.moveForward();
+                v.advanceLaneChange();
+            }
+        }
+        else
+        {
+            v.x += (int)(displacement(v) * n);
+        }
+    }
+
+    // 每个滑行帧的生成判定都只消耗一个随机数
+    sim.engine.discard((unsigned long long)n);
+    for (long long k = 0; k < n; ++k)
+    {
+        sim.time += 0.2; // 与逐帧累加保持相同的舍入
+    }
+    sim.tick += n;
+    stats.coastedTicks += n;
+}
+
+void EventEngine::fullStep()
+{
+    vector<Vehicle> before;
+    if (onStep)
+        before = sim.vehicles;
+    sim.step();
+    ++stats.fullSteps;
+    if (onStep)
+        onStep(before, sim);
+}
+
+void EventEngine::advanceTo(long long targetTick)
+{
+    SimulationScope scope(sim);
+    while (sim.tick < targetTick)
+    {
+        schedule(targetTick);
+        if (queue.empty())
+        {
+            coast(targetTick - sim.tick);
+            break;
+        }
+
+        // 同一帧的事件一起处理：滑行到事件前一帧，事件帧逐帧推进
+        long long next = queue.top().tick;
+        while (!queue.empty() && queue.top().tick == next)
+        {
+            ++stats.eventCounts[(int)queue.top().kind];
+            queue.pop();
+        }
+        coast(next - sim.tick - 1);
+        fullStep();
+    }
+}
+
+void recordTrafficEvents(const vector<Vehicle> &before, const vector<Vehicle> &after, long long tick,
+                         vector<TrafficEvent> &log)
+{
+    size_t i = 0, j = 0;
+    while (i < before.size() || j < after.size())
+    {
+        if (j == after.size() || (i < before.size() && before[i].id < after[j].id))
+        {
+            log.push_back({tick, TrafficEventKind::EXITED, before[i].id});
+            ++i;
+        }
+        else if (i == before.size() || after[j].id < before[i].id)
+        {
+            log.push_back({tick, TrafficEventKind::ENTERED, after[j].id});
+            ++j;
+        }
+        else
+        {
+            const Vehicle &b = before[i];
+            const Vehicle &a = after[j];
+            if (a.isBrokenDown && !b.isBrokenDown)
+                log.push_back({tick, TrafficEventKind::BROKE_DOWN, a.id});
+            if (a.lane != b.lane)
+                log.push_back({tick, TrafficEventKind::CHANGED_LANE, a.id});
+            if (a.speed != b.speed)
+                log.push_back({tick, TrafficEventKind::SPEED_CHANGED, a.id});
+            ++i;
+            ++j;
+        }
+    }
+}
+
+EventComparison runEventComparison(int windowWidth, int windowHeight, double scale, double widthScale,
+                                   int spawnPeriod, long long ticks, uint64_t seed, long long tickTolerance)
+{
+    auto makeSim = [&]()
+    {
+        Simulation s(windowWidth, windowHeight, scale, widthScale, seed);
+        s.params.logRelativeSpeed = false;
+        s.params.spawnPeriod = spawnPeriod;
+        return s;
+    };
+
+    EventComparison report;
+    report.ticks = ticks;
+    report.spawnPeriod = spawnPeriod;
+
+    // 记录两种推进方式的交通事件
+    Simulation fixed = makeSim();
+    vector<TrafficEvent> fixedLog;
+    double vehicleSum = 0;
+    while (fixed.tick < ticks)
+    {
+        vector<Vehicle> before = fixed.vehicles;
+        fixed.step();
+        recordTrafficEvents(before, fixed.vehicles, fixed.tick, fixedLog);
+        vehicleSum += fixed.vehicles.size();
+    }
+    report.averageVehicles = vehicleSum / max(1LL, ticks);
+
+    Simulation evented = makeSim();
+    vector<TrafficEvent> eventLog;
+    EventEngine engine(evented);
+    engine.onStep = [&eventLog](const vector<Vehicle> &before, const Simulation &after)
+    { recordTrafficEvents(before, after.vehicles, after.tick, eventLog); };
+    engine.advanceTo(ticks);
+    report.stats = engine.stats;
+    report.identicalState = sameState(fixed, evented);
+
+    // 按（类型，车辆）分组，组内按顺序一一对应
+    sort(fixedLog.begin(), fixedLog.end(), eventOrder);
+    sort(eventLog.begin(), eventLog.end(), eventOrder);
+    report.fixedEvents = fixedLog.size();
+    report.eventEvents = eventLog.size();
+    report.matched = 0;
+    report.maxTickError = 0;
+    size_t i = 0, j = 0;
+    while (i < fixedLog.size() && j < eventLog.size())
+    {
+        const TrafficEvent &a = fixedLog[i];
+        const TrafficEvent &b = eventLog[j];
+        if (a.kind != b.kind || a.vehicleId != b.vehicleId)
+        {
+            if (a.kind < b.kind || (a.kind == b.kind && a.vehicleId < b.vehicleId))
+                ++i;
+            else
+                ++j;
+            continue;
+        }
+        long long error = a.tick > b.tick ? a.tick - b.tick : b.tick - a.tick;
+        if (error <= tickTolerance)
+        {
+            ++report.matched;
+            report.maxTickError = max(report.maxTickError, error);
+        }
+        ++i;
+        ++j;
+    }
+
+    // 不记录事件时的耗时
+    Simulation fixedTimed = makeSim();
+    auto start = chrono::steady_clock::now();
+    while (fixedTimed.tick < ticks)
+    {
+        fixedTimed.step();
+    }
+    report.fixedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    Simulation eventTimed = makeSim();
+    EventEngine timedEngine(eventTimed);
+    start = chrono::steady_clock::now();
+    timedEngine.advanceTo(ticks);
+    report.eventSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+void printEventComparison(const EventComparison &report)
+{
+    static const char *kindNames[] = {"arrival", "follow", "exit", "lane change", "active"};
+    printf("ticks: %lld  spawn period: %d  avg vehicles: %.1f\n", report.ticks, report.spawnPeriod, report.averageVehicles);
+    printf("events: fixed %zu  event-driven %zu  matched %zu  max tick error %lld  final state %s\n",
+           report.fixedEvents, report.eventEvents, report.matched, report.maxTickError,
+           report.identicalState ? "identical" : "DIFFERENT");
+    printf("full steps: %lld  coasted ticks: %lld  schedules: %lld\n",
+           report.stats.fullSteps, report.stats.coastedTicks, report.stats.schedules);
+    for (int k = 0; k < (int)SimEventKind::COUNT; ++k)
+    {
+        printf("  %-12s %lld\n", kindNames[k], report.stats.eventCounts[k]);
+    }
+    printf("fixed step:   %.3fs  (%.2f us/tick)\n", report.fixedSeconds, report.fixedSeconds * 1e6 / max(1LL, report.ticks));
+    printf("event driven: %.3fs  (%.2f us/tick)  speedup %.1fx\n", report.eventSeconds,
+           report.eventSeconds * 1e6 / max(1LL, report.ticks), report.fixedSeconds / max(report.eventSeconds, 1e-9));
+}
@@ -0,0 +1,111 @@
+﻿#include <vector>
+#include <queue>
+#include <functional>
+#include "Simulation.h"
+using namespace std;
+
+// 离散事件推进：稀疏交通下大多数帧里车辆只是匀速前进，逐帧的跟车和变道检查都没有结果。
+// 事件引擎计算下一个"有事发生"的帧，中间的帧只做匀速运动（滑行），
+// 事件发生的那一帧照常调用Simulation::step，因此结果与逐帧推进完全一致。
+
+// 调度事件类型
+enum class SimEventKind
+{
+    ARRIVAL,     // 随机数判定本帧生成新车
+    FOLLOW,      // 后车进入前车的安全距离或碰撞距离
+    EXIT,        // 车辆驶离桥面
+    LANE_CHANGE, // 正在进行的变道完成
+    ACTIVE,      // 有车辆处于需要逐帧处理的状态（准备变道、速度刚降为0等）
+    COUNT
+};
+
+// 调度事件：在tick帧（推进后的帧号）发生
+struct SimEvent
+{
+    long long tick;
+    SimEventKind kind;
+    int vehicleId; // 相关车辆（到达事件为0）
+    int otherId;   // 跟车事件的前车
+
+    bool operator>(const SimEvent &other) const { return tick > other.tick; }
+};
+
+// 事件引擎的统计量
+struct EventStats
+{
+    long long eventCounts[(int)SimEventKind::COUNT] = {}; // 触发逐帧推进的各类事件数
+    long long fullSteps = 0;                               // 逐帧推进（Simulation::step）的帧数
+    long long coastedTicks = 0;                            // 只做匀速运动的帧数
+    long long schedules = 0;                               // 重新计算事件队列的次数
+};
+
+struct EventEngine
+{
+    Simulation &sim;
+    EventStats stats;
+    priority_queue<SimEvent, vector<SimEvent>, greater<SimEvent>> queue; // 本次调度的事件，按帧号排列
+    // 每次逐帧推进后调用（用于和逐帧推进的结果对比），可为空
+    function<void(const vector<Vehicle> &before, const Simulation &after)> onStep;
+
+    explicit EventEngine(Simulation &sim) : sim(sim) {}
+
+    // 推进到第targetTick帧
+    void advanceTo(long long targetTick);
+    // 重新计算事件队列，只保留horizon帧之前的事件
+    void schedule(long long horizon);
+    // 匀速运动n帧：车辆前进、正在进行的变道推进，生成新车的随机数跳过n个
+    void coast(long long n);
+    // 逐帧推进一帧
+    void fullStep();
+
+private:
+    void push(long long tick, SimEventKind kind, int vehicleId, int otherId = 0);
+    // 后车follower在第几帧（相对当前）第一次进入前车leader的threshold距离内，不会进入时返回-1
+    static long long followTick(const Vehicle &follower, const Vehicle &leader, int threshold);
+    // 车辆在第几帧驶离桥面，不会驶离时返回-1
+    long long exitTick(const Vehicle &v) const;
+    // 正在进行的变道在第几帧完成
+    static long long laneChangeTick(const Vehicle &v);
+};
+
+// 可观测的交通事件，用于比较两种推进方式
+enum class TrafficEventKind
+{
+    ENTERED,     // 车辆进入桥面
+    EXITED,      // 车辆驶离桥面
+    BROKE_DOWN,  // 车辆抛锚
+    CHANGED_LANE, // 车辆完成变道
+    SPEED_CHANGED // 车辆速度改变
+};
+
+struct TrafficEvent
+{
+    long long tick;
+    TrafficEventKind kind;
+    int vehicleId;
+};
+
+// 比较一帧前后的车辆（都按编号递增排列），把发生的交通事件追加到log
+void recordTrafficEvents(const vector<Vehicle> &before, const vector<Vehicle> &after, long long tick,
+                         vector<TrafficEvent> &log);
+
+// 事件引擎与逐帧推进的对比结果
+struct EventComparison
+{
+    long long ticks;
+    int spawnPeriod;
+    size_t fixedEvents, eventEvents; // 两种推进方式记录的交通事件数
+    size_t matched;                   // 在容差内对应上的事件数
+    long long maxTickError;           // 对应事件的最大帧号差
+    bool identicalState;              // 最终车辆状态、统计量和随机数状态是否完全一致
+    double fixedSeconds, eventSeconds; // 不记录事件时两种推进方式的耗时
+    double averageVehicles;           // 桥上的平均车辆数
+    EventStats stats;
+};
+
+// 以spawnPeriod的生成频率推进ticks帧，比较事件引擎和逐帧推进
+EventComparison runEventComparison(int windowWidth, int windowHeight, double scale, double widthScale,
+                                   int spawnPeriod, long long ticks, uint64_t seed, long long tickTolerance = 1);
+void printEventComparison(const EventComparison &report);
+
+#pragma once
@@ -0,0 +1,406 @@
+﻿#include <chrono>
+#include <algorithm>
+#include <cstdio>
+
+#include "FrameExport.h"
+using namespace std;
+
+namespace
+{
+    // 按位写入（deflate的位序：先写低位）
+    struct BitWriter
+    {
+        vector<uint8_t> &out;
+        uint32_t bits;
+        int count;
+
+        explicit BitWriter(vector<uint8_t> &output) : out(output), bits(0), count(0) {}
+
+        void put(uint32_t value, int length)
+        {
+            bits |= value << count;
+            count += length;
+            while (count >= 8)
+            {
+                out.push_back((uint8_t)(bits & 0xFF));
+                bits >>= 8;
+                count -= 8;
+            }
+        }
+        // 哈夫曼码从高位开始写
+        void putCode(uint32_t code, int length)
+        {
+            uint32_t reversed = 0;
+            for (int i = 0; i < length; ++i)
+            {
+                reversed = (reversed << 1) | ((code >> i) & 1);
+            }
+            put(reversed, length);
+        }
+        void flush()
+        {
+            if (count > 0)
+            {
+                out.push_back((uint8_t)(bits & 0xFF));
+            }
+            bits = 0;
+            count = 0;
+        }
+    };
+
+    const int lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    const int lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    const int distanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    const int distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    // 固定哈夫曼表中的字面量/长度符号
+    void putSymbol(BitWriter &writer, int symbol)
+    {
+        if (symbol < 144)
+            writer.putCode(0x30 + symbol, 8);
+        else if (symbol < 256)
+            writer.putCode(0x190 + symbol - 144, 9);
+        else if (symbol < 280)
+            writer.putCode(symbol - 256, 7);
+        else
+            writer.putCode(0xC0 + symbol - 280, 8);
+    }
+
+    void putMatch(BitWriter &writer, int length, int distance)
+    {
+        int i = 28;
+        while (lengthBase[i] > length)
+            --i;
+        putSymbol(writer, 257 + i);
+        writer.put(length - lengthBase[i], lengthExtra[i]);
+        int j = 29;
+        while (distanceBase[j] > distance)
+            --j;
+        writer.putCode(j, 5);
+        writer.put(distance - distanceBase[j], distanceExtra[j]);
+    }
+
+    // zlib数据流：只在左侧像素（距离3）和上一行（距离stride）处找重复，
+    // 仿真画面大部分是纯色背景和纯色车身，这样已经能压缩到原始大小的很小一部分
+    vector<uint8_t> zlibCompress(const vector<uint8_t> &data, int stride)
+    {
+        vector<uint8_t> out;
+        out.reserve(data.size() / 8 + 64);
+        out.push_back(0x78);
+        out.push_back(0x01);
+        BitWriter writer(out);
+        writer.put(1, 1); // 最后一个块
+        writer.put(1, 2); // 固定哈夫曼表
+        const int n = (int)data.size();
+        const int candidates[2] = {3, stride};
+        int i = 0;
+        while (i < n)
+        {
+            int bestLength = 0, bestDistance = 0;
+            for (int distance : candidates)
+            {
+                if (distance > i || distance > 32768)
+                    continue;
+                int length = 0;
+                int limit = min(258, n - i);
+                while (length < limit && data[i + length] == data[i + length - distance])
+                    ++length;
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    bestDistance = distance;
+                }
+            }
+            if (bestLength >= 3)
+            {
+                putMatch(writer, bestLength, bestDistance);
+                i += bestLength;
+            }
+            else
+            {
+                putSymbol(writer, data[i]);
+                ++i;
+            }
+        }
+        putSymbol(writer, 256); // 块结束
+        writer.flush();
+
+        uint32_t a = 1, b = 0;
+        for (int k = 0; k < n; ++k)
+        {
+            a = (a + data[k]) % 65521;
+            b = (b + a) % 65521;
+        }
+        uint32_t adler = (b << 16) | a;
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back((uint8_t)(adler >> shift));
+        return out;
+    }
+
+    uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+    {
+        static uint32_t table[256];
+        static bool initialized = [] {
+            for (uint32_t n = 0; n < 256; ++n)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+            return true;
+        }();
+        (void)initialized;
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void putBigEndian(vector<uint8_t> &out, uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+            out.push_back((uint8_t)(value >> shift));
+    }
+
+    void putChunk(vector<uint8_t> &out, const char *type, const vector<uint8_t> &payload)
+    {
+        putBigEndian(out, (uint32_t)payload.size());
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), payload.begin(), payload.end());
+        putBigEndian(out, crc32(&out[start], out.size() - start));
+    }
+
+    uint8_t clampByte(int value)
+    {
+        return (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+    }
+}
+
+vector<uint8_t> encodePng(const Frame &frame)
+{
+    // 每行前加一个过滤类型字节（0：不过滤）
+    int stride = frame.width * 3 + 1;
+    vector<uint8_t> raw((size_t)stride * frame.height);
+    for (int y = 0; y < frame.height; ++y)
+    {
+        uint8_t *row = &raw[(size_t)y * stride];
+        row[0] = 0;
+        const uint32_t *pixel = &frame.pixels[(size_t)y * frame.width];
+        for (int x = 0; x < frame.width; ++x)
+        {
+            row[1 + x * 3] = (uint8_t)(pixel[x] >> 16);
+            row[2 + x * 3] = (uint8_t)(pixel[x] >> 8);
+            row[3 + x * 3] = (uint8_t)pixel[x];
+        }
+    }
+
+    vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    vector<uint8_t> header;
+    putBigEndian(header, (uint32_t)frame.width);
+    putBigEndian(header, (uint32_t)frame.height);
+    header.push_back(8); // 位深
+    header.push_back(2); // RGB
+    header.push_back(0); // 压缩方式
+    header.push_back(0); // 过滤方式
+    header.push_back(0); // 不隔行
+    putChunk(png, "IHDR", header);
+    putChunk(png, "IDAT", zlibCompress(raw, stride));
+    putChunk(png, "IEND", vector<uint8_t>());
+    return png;
+}
+
+vector<uint8_t> encodeY4mFrame(const Frame &frame)
+{
+    static const char marker[] = "FRAME\n";
+    int w = frame.width, h = frame.height;
+    int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    vector<uint8_t> out(6 + (size_t)w * h + 2 * (size_t)cw * ch);
+    copy(marker, marker + 6, out.begin());
+    uint8_t *planeY = &out[6];
+    uint8_t *planeU = planeY + (size_t)w * h;
+    uint8_t *planeV = planeU + (size_t)cw * ch;
+
+    for (int y = 0; y < h; ++y)
+    {
+        const uint32_t *pixel = &frame.pixels[(size_t)y * w];
+        for (int x = 0; x < w; ++x)
+        {
+            int r = (pixel[x] >> 16) & 0xFF, g = (pixel[x] >> 8) & 0xFF, b = pixel[x] & 0xFF;
+            planeY[(size_t)y * w + x] = clampByte((77 * r + 150 * g + 29 * b + 128) >> 8);
+        }
+    }
+    // 色度取2x2像素的平均值（右边和下边的奇数行列只取存在的像素）
+    for (int cy = 0; cy < ch; ++cy)
+    {
+        for (int cx = 0; cx < cw; ++cx)
+        {
+            int r = 0, g = 0, b = 0, count = 0;
+            for (int y = cy * 2; y < min(h, cy * 2 + 2); ++y)
+            {
+                for (int x = cx * 2; x < min(w, cx * 2 + 2); ++x)
+                {
+                    uint32_t pixel = frame.pixels[(size_t)y * w + x];
+                    r += (pixel >> 16) & 0xFF;
+                    g += (pixel >> 8) & 0xFF;
+                    b += pixel & 0xFF;
+                    ++count;
+                }
+            }
+            r /= count;
+            g /= count;
+            b /= count;
+            planeU[(size_t)cy * cw + cx] = clampByte((-43 * r - 85 * g + 128 * b + (128 << 8) + 128) >> 8);
+            planeV[(size_t)cy * cw + cx] = clampByte((128 * r - 107 * g - 21 * b + (128 << 8) + 128) >> 8);
+        }
+    }
+    return out;
+}
+
+bool FrameExporter::start(const FrameExportOptions &exportOptions, int frameWidth, int frameHeight)
+{
+    options = exportOptions;
+    width = frameWidth;
+    height = frameHeight;
+    stats = FrameExportStats();
+    nextIndex = 0;
+    nextWrite = 0;
+    finishing = false;
+    if (options.queueCapacity < 1)
+        options.queueCapacity = 1;
+
+    if (options.format == FrameFormat::Y4M)
+    {
+        string path = options.directory + "/frames.y4m";
+        video.open(path, ios::binary);
+        if (!video)
+            return false;
+        char header[128];
+        int length = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, options.fps);
+        video.write(header, length);
+        stats.bytesWritten += length;
+    }
+
+    int threadCount = options.encoderThreads > 0 ? options.encoderThreads : max(1, (int)thread::hardware_concurrency());
+    for (int t = 0; t < threadCount; ++t)
+    {
+        encoders.emplace_back(&FrameExporter::encoderLoop, this);
+    }
+    return true;
+}
+
+Frame FrameExporter::acquire()
+{
+    Frame frame;
+    frame.index = -1;
+    frame.width = width;
+    frame.height = height;
+    {
+        lock_guard<mutex> guard(lock);
+        if (!freeBuffers.empty())
+        {
+            frame.pixels = move(freeBuffers.back());
+            freeBuffers.pop_back();
+        }
+    }
+    frame.pixels.resize((size_t)width * height);
+    return frame;
+}
+
+void FrameExporter::submit(Frame &&frame)
+{
+    unique_lock<mutex> guard(lock);
+    if ((int)queue.size() >= options.queueCapacity)
+    {
+        auto start = chrono::steady_clock::now();
+        queueChanged.wait(guard, [this] { return (int)queue.size() < options.queueCapacity; });
+        stats.producerWaitSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    frame.index = nextIndex++;
+    queue.push_back(move(frame));
+    queueChanged.notify_all();
+}
+
+void FrameExporter::finish()
+{
+    if (encoders.empty())
+        return;
+    {
+        lock_guard<mutex> guard(lock);
+        finishing = true;
+    }
+    queueChanged.notify_all();
+    for (auto &encoder : encoders)
+    {
+        encoder.join();
+    }
+    encoders.clear();
+    if (video.is_open())
+    {
+        video.close();
+        if (!video)
+            stats.failed = true;
+    }
+}
+
+void FrameExporter::encoderLoop()
+{
+    while (true)
+    {
+        Frame frame;
+        {
+            unique_lock<mutex> guard(lock);
+            queueChanged.wait(guard, [this] { return !queue.empty() || finishing; });
+            if (queue.empty())
+                return;
+            frame = move(queue.front());
+            queue.pop_front();
+        }
+        queueChanged.notify_all(); // 队列有空位，唤醒等待的仿真线程
+
+        long long bytes = encode(frame);
+
+        lock_guard<mutex> guard(lock);
+        if (bytes < 0)
+        {
+            stats.failed = true;
+        }
+        else
+        {
+            ++stats.framesWritten;
+            stats.bytesWritten += bytes;
+        }
+        freeBuffers.push_back(move(frame.pixels));
+    }
+}
+
+long long FrameExporter::encode(const Frame &frame)
+{
+    if (options.format == FrameFormat::PNG)
+    {
+        vector<uint8_t> data = encodePng(frame);
+        char name[32];
+        snprintf(name, sizeof(name), "/frame_%06lld.png", frame.index);
+        string path = options.directory + name;
+        ofstream file(path, ios::binary);
+        file.write((const char *)data.data(), data.size());
+        file.close();
+        return file ? (long long)data.size() : -1;
+    }
+
+    // Y4M：各线程并行转换颜色，再按帧序号依次写入同一个文件
+    vector<uint8_t> data = encodeY4mFrame(frame);
+    {
+        unique_lock<mutex> guard(lock);
+        writeTurn.wait(guard, [this, &frame] { return nextWrite == frame.index; });
+    }
+    video.write((const char *)data.data(), data.size());
+    bool ok = !video.fail();
+    {
+        lock_guard<mutex> guard(lock);
+        ++nextWrite;
+    }
+    writeTurn.notify_all();
+    return ok ? (long long)data.size() : -1;
+}
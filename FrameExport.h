@@ -0,0 +1,89 @@
+﻿#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <cstdint>
+#include <fstream>
+using namespace std;
+
+// 导出文件格式
+enum class FrameFormat
+{
+    PNG, // 每帧一个PNG文件：frame_000000.png, frame_000001.png, ...
+    Y4M  // 所有帧写入一个原始YUV4MPEG2视频文件 frames.y4m（4:2:0）
+};
+
+// 一帧画面：像素按行存放，每个像素为0x00RRGGBB（与EasyX的GetImageBuffer相同）
+struct Frame
+{
+    long long index; // 帧序号（从0开始）
+    int width, height;
+    vector<uint32_t> pixels;
+};
+
+// 导出选项
+struct FrameExportOptions
+{
+    string directory = "frames";      // 输出目录（需已存在）
+    FrameFormat format = FrameFormat::PNG;
+    int encoderThreads = 0;           // 编码线程数，0表示使用全部CPU核
+    int queueCapacity = 8;            // 等待编码的帧数上限，队列满时仿真才等待
+    int fps = 16;                     // Y4M文件头中的帧率（原界面每帧60ms）
+};
+
+// 导出统计
+struct FrameExportStats
+{
+    long long framesWritten = 0;  // 已写入磁盘的帧数
+    long long bytesWritten = 0;   // 已写入的字节数
+    double producerWaitSeconds = 0; // 仿真因队列满而等待的总时间
+    bool failed = false;          // 是否有文件写入失败
+};
+
+// 异步帧导出：仿真和绘制线程把画面放入有界队列，后台编码线程把画面编码为PNG序列或Y4M视频。
+// 仿真只在队列满时等待，导出速度取决于编码线程而不是界面的帧间隔
+//
+// 用法：start() -> 循环 acquire() 取得空帧、填充像素后 submit() -> finish()
+struct FrameExporter
+{
+    FrameExportOptions options;
+    FrameExportStats stats;
+    int width, height;
+
+    mutex lock;
+    condition_variable queueChanged;  // 队列有新帧、有空位或导出结束
+    condition_variable writeTurn;     // Y4M按帧序号顺序写入
+    deque<Frame> queue;               // 等待编码的帧
+    vector<vector<uint32_t>> freeBuffers; // 编码完成后回收的像素缓冲区，避免每帧重新分配
+    long long nextIndex;              // 下一帧的序号
+    long long nextWrite;              // Y4M下一个应写入的帧序号
+    bool finishing;
+    ofstream video;                   // Y4M输出文件
+    vector<thread> encoders;
+
+    FrameExporter() : width(0), height(0), nextIndex(0), nextWrite(0), finishing(false) {}
+    ~FrameExporter() { finish(); }
+
+    // 启动编码线程，Y4M格式同时写入文件头；无法创建输出文件时返回false
+    bool start(const FrameExportOptions &exportOptions, int frameWidth, int frameHeight);
+    // 取得一个空帧（像素缓冲区尽量复用已编码完成的帧）
+    Frame acquire();
+    // 提交一帧，队列满时等待编码线程腾出空位
+    void submit(Frame &&frame);
+    // 等待队列中的帧全部写完并结束编码线程
+    void finish();
+
+    // 编码线程主循环
+    void encoderLoop();
+    // 编码并写入一帧，返回写入的字节数（失败返回-1）
+    long long encode(const Frame &frame);
+};
+
+// PNG编码（RGB 8位，zlib固定哈夫曼压缩，匹配左侧像素和上一行）
+vector<uint8_t> encodePng(const Frame &frame);
+// 转换为Y4M的一帧（"FRAME\n" + Y、U、V三个平面，BT.601全范围）
+vector<uint8_t> encodeY4mFrame(const Frame &frame);
+
+#pragma once
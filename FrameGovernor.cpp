@@ -0,0 +1,87 @@
+﻿#include <cstdio>
+#include <algorithm>
+
+#include "FrameGovernor.h"
+using namespace std;
+
+const wchar_t *qualityLevelName(QualityLevel level)
+{
+    switch (level)
+    {
+    case QualityLevel::NO_TRAJECTORIES:
+        return L"画质：无轨迹";
+    case QualityLevel::NO_LABELS:
+        return L"画质：无轨迹和标签";
+    case QualityLevel::SIMPLE_SPRITES:
+        return L"画质：简化车身";
+    case QualityLevel::REDUCED_RATE:
+        return L"画质：降低帧率";
+    default:
+        return L"画质：完整";
+    }
+}
+
+bool FrameGovernor::shouldDraw()
+{
+    if (level != QualityLevel::REDUCED_RATE || ++skippedInRow >= max(1, config.reducedRateDivisor))
+    {
+        skippedInRow = 0;
+        return true;
+    }
+    ++skipped;
+    return false;
+}
+
+bool FrameGovernor::record(double milliseconds)
+{
+    ++frames;
+    ++framesAt[(int)level];
+    averageMilliseconds = levelFrames++ == 0 ? milliseconds
+                                             : averageMilliseconds + config.smoothing * (milliseconds - averageMilliseconds);
+    if (config.budgetMilliseconds <= 0)
+        return false;
+
+    overBudget = averageMilliseconds > config.budgetMilliseconds ? overBudget + 1 : 0;
+    underBudget = averageMilliseconds < config.budgetMilliseconds * config.restoreFraction ? underBudget + 1 : 0;
+
+    int next = (int)level;
+    if (overBudget >= config.degradeFrames && next < QUALITY_LEVEL_COUNT - 1)
+        ++next;
+    else if (underBudget >= config.restoreFrames && next > 0)
+        --next;
+    if (next == (int)level)
+        return false;
+
+    // 新等级的耗时重新计数
+    level = (QualityLevel)next;
+    levelFrames = 0;
+    overBudget = underBudget = 0;
+    skippedInRow = 0;
+    ++levelChanges;
+    return true;
+}
+
+LodConfig FrameGovernor::apply(const LodConfig &base) const
+{
+    LodConfig config = base;
+    // 车辆数阈值设为-1后对应的工作在任何车辆数下都不做
+    if (level >= QualityLevel::NO_TRAJECTORIES)
+        config.trajectoryMaxVehicles = -1;
+    if (level >= QualityLevel::NO_LABELS)
+        config.labelMaxVehicles = -1;
+    if (level >= QualityLevel::SIMPLE_SPRITES)
+        config.fullMaxVehicles = -1;
+    return config;
+}
+
+void printGovernorReport(const FrameGovernor &governor)
+{
+    printf("frames drawn: %lld  skipped: %lld  level changes: %lld  budget %.1f ms  average %.2f ms\n",
+           governor.frames, governor.skipped, governor.levelChanges, governor.config.budgetMilliseconds,
+           governor.averageMilliseconds);
+    const char *names[QUALITY_LEVEL_COUNT] = {"full", "no trajectories", "no labels", "simple sprites", "reduced rate"};
+    for (int i = 0; i < QUALITY_LEVEL_COUNT; ++i)
+    {
+        printf("  %-16s %8lld frames\n", names[i], governor.framesAt[i]);
+    }
+}
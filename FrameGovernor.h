@@ -0,0 +1,64 @@
+﻿#include "Class.h"
+
+// 帧时间调节：跟踪绘制线程每帧的耗时，超出预算时按顺序放弃可选的绘制工作，
+// 负载下降后逐级恢复。只改变绘制（细节阈值和绘制频率），仿真本身不受影响。
+//
+// 每帧耗时在当前等级内做指数平均（换级后重新开始，只反映新等级的开销）；平均值连续degradeFrames帧
+// 超出预算时降一级，连续restoreFrames帧低于预算的restoreFraction时升一级（留出余量，避免在两级之间来回切换）
+
+// 画质等级，越往后放弃的工作越多
+enum class QualityLevel
+{
+    FULL,            // 完整画质（按LodConfig的阈值）
+    NO_TRAJECTORIES, // 不绘制预测轨迹
+    NO_LABELS,       // 不绘制预测轨迹和速度标签
+    SIMPLE_SPRITES,  // 另外车辆只画简化车身
+    REDUCED_RATE     // 另外新快照每reducedRateDivisor帧才绘制一次
+};
+
+const int QUALITY_LEVEL_COUNT = 5;
+
+// 画质等级的显示名称
+const wchar_t *qualityLevelName(QualityLevel level);
+
+struct GovernorConfig
+{
+    double budgetMilliseconds = 60; // 每帧绘制的时间预算（默认与仿真节拍相同），不大于0时不调节
+    double smoothing = 0.2;         // 指数平均中本帧耗时的权重
+    int degradeFrames = 5;          // 平均耗时连续超出预算多少帧后降一级
+    double restoreFraction = 0.5;   // 平均耗时低于预算的这一比例才算有余量
+    int restoreFrames = 30;         // 连续有余量多少帧后升一级
+    int reducedRateDivisor = 2;     // REDUCED_RATE时每几帧新快照绘制一帧
+};
+
+struct FrameGovernor
+{
+    GovernorConfig config;
+    QualityLevel level = QualityLevel::FULL;
+    double averageMilliseconds = 0; // 当前等级下每帧耗时的指数平均
+    int levelFrames = 0;            // 当前等级下已绘制的帧数
+    int overBudget = 0;             // 平均耗时连续超出预算的帧数
+    int underBudget = 0;            // 平均耗时连续有余量的帧数
+    int skippedInRow = 0;           // REDUCED_RATE时连续跳过的新快照数
+
+    // 统计
+    long long frames = 0;                          // 已绘制的帧数
+    long long skipped = 0;                         // 因降低绘制频率跳过的新快照数
+    long long levelChanges = 0;                    // 等级变化次数
+    long long framesAt[QUALITY_LEVEL_COUNT] = {}; // 各等级下绘制的帧数
+
+    FrameGovernor() = default;
+    explicit FrameGovernor(const GovernorConfig &config) : config(config) {}
+
+    // 有新快照时是否绘制（只有REDUCED_RATE会跳过）
+    bool shouldDraw();
+    // 记录一帧绘制的耗时，等级改变时返回true
+    bool record(double milliseconds);
+    // 当前等级下实际使用的细节阈值
+    LodConfig apply(const LodConfig &base) const;
+};
+
+// 输出各等级的帧数和平均耗时
+void printGovernorReport(const FrameGovernor &governor);
+
+#pragma once
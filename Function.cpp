@@ -1,14 +1,20 @@
-﻿#include <graphics.h>
+﻿#ifndef CAR_SIM_HEADLESS
+#include <graphics.h>
+#endif
 #include <vector>
 #include <ctime>
+#ifndef CAR_SIM_HEADLESS
 #include <conio.h> // 需要包含此头文件_kbhit()函数需要
 #include <Windows.h>
+#endif
 #include <sstream>
 #include <string>
 #include <iostream>
 
 #include "Random.h"
 #include "Class.h"
+#include "Render.h"
+#include "AllocProfiler.h"
 using namespace std;
 void clearLane(vector<Vehicle>& vehicles, int lane)
 {
@@ -41,7 +47,7 @@ void drawDashedLine(int x1, int y1, int x2, int y2)
         if (endX > x2 || endY > y2)
             break; // 防止超出终点
 
-        line(startX, startY, endX, endY); // 绘制虚线段
+        render::line(startX, startY, endX, endY); // 绘制虚线段
     }
 }
 
@@ -52,22 +58,40 @@ void VirtualVehicle::drawTrajectory(bool isSafe) const
         return;
 
     // 根据安全情况设置颜色：安全使用蓝色，不安全使用红色
-    setlinecolor(isSafe ? BLUE : RED);
-    setlinestyle(PS_DASH, 1);
+    render::setlinecolor(isSafe ? BLUE : RED);
+    render::setlinestyle(PS_DASH, 1);
 
     for (size_t i = 1; i < trajectory.size(); ++i)
     {
-        line(trajectory[i - 1].first, trajectory[i - 1].second,
+        render::line(trajectory[i - 1].first, trajectory[i - 1].second,
              trajectory[i].first, trajectory[i].second);
     }
 
-    setlinestyle(PS_SOLID, 1);
+    render::setlinestyle(PS_SOLID, 1);
 }
+// 所有轨迹点上车身的外接矩形
+TrajectoryBox VirtualVehicle::bounds() const
+{
+    TrajectoryBox box = {x, y, x, y};
+    for (const auto &p : trajectory)
+    {
+        box.left = min(box.left, p.first);
+        box.right = max(box.right, p.first);
+        box.top = min(box.top, p.second);
+        box.bottom = max(box.bottom, p.second);
+    }
+    box.left -= carlength / 2;
+    box.right += carlength / 2;
+    box.top -= carwidth / 2;
+    box.bottom += carwidth / 2;
+    return box;
+}
+
 // 检查与另一车辆的轨迹是否相交
 bool VirtualVehicle::isTrajectoryIntersecting(const VirtualVehicle &other, int futureSteps) const
 {
     // 检查当前和未来几个时间点的位置
-    size_t checkSteps = min(futureSteps, min(trajectory.size(), other.trajectory.size()));
+    size_t checkSteps = min((size_t)futureSteps, min(trajectory.size(), other.trajectory.size()));
 
     for (size_t i = 0; i < checkSteps; ++i)
     {
@@ -101,9 +125,10 @@ bool VirtualVehicle::isTrajectoryIntersecting(const VirtualVehicle &other, int f
     return false; // 轨迹不相交
 }
 
+#ifndef CAR_SIM_HEADLESS
 // 根据屏幕分辨率调整窗口大小
 
-void Bridge::calculateWindowSize(int &windowWidth, int &windowHeight, double &scale) const
+void Bridge::computeWindowSize(int &windowWidth, int &windowHeight, double &scale) const
 {
     int margin = 100; // 边缘留白
     // 获取屏幕分辨率
@@ -120,42 +145,85 @@ void Bridge::calculateWindowSize(int &windowWidth, int &windowHeight, double &sc
     scale = finalScaleFactor;
     windowWidth = int(windowWidth * finalScaleFactor);
     windowHeight = int(windowHeight * finalScaleFactor);
+}
 
+void Bridge::calculateWindowSize(int &windowWidth, int &windowHeight, double &scale) const
+{
+    computeWindowSize(windowWidth, windowHeight, scale);
     initgraph(windowWidth, windowHeight);
 }
-void Vehicle::draw() const
+#endif
+// 根据屏幕上的车长和车辆总数选择细节等级
+LodLevel chooseLod(const LodConfig &config, int onScreenLength, int vehicleCount)
+{
+    if (onScreenLength < config.simpleMinLength || vehicleCount > config.simpleMaxVehicles)
+        return LodLevel::BOX;
+    if (onScreenLength < config.fullMinLength || vehicleCount > config.fullMaxVehicles)
+        return LodLevel::SIMPLE;
+    return LodLevel::FULL;
+}
+
+// 是否显示速度标签
+bool shouldShowLabel(const LodConfig &config, int onScreenLength, int vehicleCount)
+{
+    return onScreenLength >= config.labelMinLength && vehicleCount <= config.labelMaxVehicles;
+}
+
+// 是否绘制预测轨迹
+bool shouldShowTrajectory(const LodConfig &config, int onScreenLength, int vehicleCount)
+{
+    return onScreenLength >= config.trajectoryMinLength && vehicleCount <= config.trajectoryMaxVehicles;
+}
+
+// 绘制抛锚车辆：灰色+红色X
+void Vehicle::drawBrokenDown() const
 {
     int left = x - carlength / 2;
     int right = x + carlength / 2;
     int top = y - carwidth / 2;
     int bottom = y + carwidth / 2;
 
-    if (isBrokenDown)
-    {
-        // 抛锚车辆：灰色+红色X
-        setfillcolor(RGB(100, 100, 100));
-        setlinecolor(RGB(50, 50, 50));
-        fillroundrect(left, top, right, bottom, 8, 8);
-
-        setlinecolor(RED);
-        setlinestyle(PS_SOLID, 3);
-        line(x - carlength / 4, y - carwidth / 4, x + carlength / 4, y + carwidth / 4);
-        line(x - carlength / 4, y + carwidth / 4, x + carlength / 4, y - carwidth / 4);
-        setlinestyle(PS_SOLID, 1);
-    }
-    else
+    render::setfillcolor(RGB(100, 100, 100));
+    render::setlinecolor(RGB(50, 50, 50));
+    render::fillroundrect(left, top, right, bottom, 8, 8);
+
+    render::setlinecolor(RED);
+    render::setlinestyle(PS_SOLID, 3);
+    render::line(x - carlength / 4, y - carwidth / 4, x + carlength / 4, y + carwidth / 4);
+    render::line(x - carlength / 4, y + carwidth / 4, x + carlength / 4, y - carwidth / 4);
+    render::setlinestyle(PS_SOLID, 1);
+}
+
+// 简化绘制：SIMPLE只画车身轮廓，BOX只画一个实心矩形
+void Vehicle::drawSimplified(LodLevel lod) const
+{
+    int left = x - carlength / 2;
+    int right = x + carlength / 2;
+    int top = y - carwidth / 2;
+    int bottom = y + carwidth / 2;
+    // 抛锚车辆在简化等级下只用灰色区分
+    COLORREF bodyColor = isBrokenDown ? RGB(100, 100, 100) : color;
+
+    if (lod == LodLevel::BOX)
     {
-        // 默认车辆（基类Vehicle）
-        setfillcolor(color); // 设置填充颜色
-        setlinecolor(color); // 让边框也是同色
-        fillrectangle(left, top, right, bottom);
+        render::setfillcolor(bodyColor);
+        render::solidrectangle(left, top, right, bottom);
+        return;
     }
 
-    // 在车辆上方显示速度
+    render::setfillcolor(bodyColor);
+    render::setlinecolor(isBrokenDown ? RED : RGB(30, 30, 30));
+    render::fillrectangle(left, top, right, bottom);
+}
+
+// 在车辆上方显示速度
+void Vehicle::drawSpeedLabel() const
+{
+    ALLOC_SCOPE("label"); // 软件光栅化时文字命令追加到画布
     wchar_t speedText[16];
     swprintf(speedText, 16, L"%d", speed);
-    setbkmode(TRANSPARENT);
-    settextcolor(WHITE);
-    settextstyle(20, 0, L"Arial");
-    outtextxy(x - 10, y - carwidth / 2 - 25, speedText);
+    render::setbkmode(TRANSPARENT);
+    render::settextcolor(WHITE);
+    render::settextstyle(20, 0, L"Arial");
+    render::outtextxy(x - 10, y - carwidth / 2 - 25, speedText);
 }
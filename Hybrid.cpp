@@ -0,0 +1,238 @@
+﻿#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "Hybrid.h"
+#include "AllocProfiler.h"
+using namespace std;
+
+HybridSimulation::HybridSimulation(int windowWidth, int windowHeight, double scale, double widthScale, uint64_t seed,
+                                   const MesoConfig &mesoConfig)
+    : micro(windowWidth, windowHeight, scale, widthScale, seed), config(mesoConfig),
+      upstream(micro.laneCount), downstream(micro.laneCount), arrived(0), departed(0), converted(0)
+{
+    // 基本图参数由微观模型的车长和距离阈值推出，使两种模型的通行能力大致一致
+    double meanLength = 6 * scale; // 平均车长（像素）
+    config.cellTicks = max(1, config.cellTicks);
+    cellLength = config.freeSpeed * config.cellTicks;
+    laneCapacity = config.capacity > 0 ? config.capacity : config.freeSpeed / (meanLength + micro.params.safeDistance);
+    cellCapacity = laneCapacity * config.cellTicks;
+    double jamSpacing = config.jamSpacing > 0 ? config.jamSpacing : meanLength + micro.params.crashDistance;
+    cellJam = max(cellLength / jamSpacing, 2 * cellCapacity);
+    waveRatio = min(1.0, cellCapacity / (cellJam - cellCapacity)); // 拥堵波每次推进不超过一个元胞
+
+    int upstreamCells = max(1, (int)ceil(config.upstreamLength * scale / cellLength));
+    int downstreamCells = max(1, (int)ceil(config.downstreamLength * scale / cellLength));
+    for (auto &lane : upstream)
+    {
+        lane.cells.assign(upstreamCells, 0);
+    }
+    for (auto &lane : downstream)
+    {
+        lane.cells.assign(downstreamCells, 0);
+    }
+    if (config.demand.empty())
+    {
+        config.demand.assign(micro.laneCount, 1.0 / (max(1, config.spawnPeriod) * micro.laneCount));
+    }
+    config.demand.resize(micro.laneCount, 0);
+}
+
+void HybridSimulation::step()
+{
+    SimulationScope scope(micro);
+
+    for (auto &v : micro.vehicles)
+    {
+        v.isFlashing = false;
+    }
+
+    for (int lane = 0; lane < micro.laneCount; ++lane)
+    {
+        advanceUpstream(lane);
+    }
+    micro.updateVehicles();
+    transferExits();
+    for (int lane = 0; lane < micro.laneCount; ++lane)
+    {
+        advanceDownstream(lane);
+    }
+
+    micro.time += 0.2;
+    ++micro.tick;
+}
+
+namespace
+{
+    // CTM一帧的元胞间流量：flows[i]为从元胞i-1流入元胞i的车辆数（i >= 1），
+    // 取上游元胞的发送量与下游元胞的接收量中的较小值
+    void cellFlows(const vector<double> &cells, double capacity, double jam, double waveRatio, vector<double> &flows)
+    {
+        flows.assign(cells.size() + 1, 0);
+        for (size_t i = 1; i < cells.size(); ++i)
+        {
+            double sending = min(cells[i - 1], capacity);
+            double receiving = min(capacity, waveRatio * (jam - cells[i]));
+            flows[i] = max(0.0, min(sending, receiving));
+        }
+    }
+}
+
+double HybridSimulation::cellSpeed(double vehicles) const
+{
+    if (vehicles <= 1e-9)
+        return config.freeSpeed;
+    double flow = min(min(vehicles, cellCapacity), waveRatio * (cellJam - vehicles));
+    return max(0.0, flow) / vehicles * cellLength / config.cellTicks;
+}
+
+void HybridSimulation::advanceUpstream(int lane)
+{
+    MesoLane &meso = upstream[lane];
+    vector<double> &cells = meso.cells;
+
+    // 需求先进入入口排队，再按第一个元胞的接收能力进入路段
+    meso.queue += config.demand[lane];
+    arrived += config.demand[lane];
+
+    if (micro.tick % config.cellTicks == 0)
+    {
+        cellFlows(cells, cellCapacity, cellJam, waveRatio, flows);
+        flows[0] = max(0.0, min(meso.queue, min(cellCapacity, waveRatio * (cellJam - cells[0]))));
+        meso.queue -= flows[0];
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            cells[i] += flows[i] - flows[i + 1];
+        }
+    }
+
+    // 末端元胞逐帧流入桥面入口的缓冲区，缓冲区最多容纳1辆车，等待的车辆进不了桥面时拥堵向上游传播
+    double inflow = max(0.0, min(min(cells.back(), laneCapacity), 1 - meso.outflowCredit));
+    cells.back() -= inflow;
+    meso.outflowCredit += inflow;
+
+    // 桥面入口：可流出量满1辆时采样一辆车，等入口处有安全距离时转换为微观车辆
+    if (!meso.hasPending && meso.outflowCredit >= 1 - 1e-9)
+    {
+        meso.pending.lane = lane;
+        micro.sampleVehicle(meso.pending);
+        // 上游拥堵时车辆以元胞的平均速度进入桥面
+        double speed = cellSpeed(cells.back());
+        if (speed < config.freeSpeed)
+        {
+            meso.pending.speed = max(20, min(meso.pending.speed, (int)speed));
+        }
+        meso.hasPending = true;
+    }
+    if (meso.hasPending && micro.isSpawnSafe(meso.pending, micro.vehicles))
+    {
+        meso.pending.id = micro.nextVehicleId++; // 进入时才分配编号，保持车辆按编号递增排列
+        ALLOC_SCOPE("vehicles");
+        micro.vehicles.push_back(micro.makeVehicle(meso.pending));
+        meso.outflowCredit = max(0.0, meso.outflowCredit - 1);
+        meso.hasPending = false;
+        ++converted;
+    }
+}
+
+void HybridSimulation::transferExits()
+{
+    for (const auto &v : micro.vehicles)
+    {
+        if (v.x < 0 || v.x > micro.windowWidth)
+        {
+            downstream[v.lane].cells[0] += 1;
+        }
+    }
+    micro.removeExited();
+}
+
+void HybridSimulation::advanceDownstream(int lane)
+{
+    if (micro.tick % config.cellTicks != 0)
+        return; // 桥面出口的车辆已逐帧加入第一个元胞
+
+    vector<double> &cells = downstream[lane].cells;
+    cellFlows(cells, cellCapacity, cellJam, waveRatio, flows);
+    // 下游末端自由流出
+    double outflow = min(cells.back(), cellCapacity);
+    flows[cells.size()] = outflow;
+    departed += outflow;
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        cells[i] += flows[i] - flows[i + 1];
+    }
+}
+
+double HybridSimulation::mesoVehicles() const
+{
+    double total = 0;
+    for (const auto *lanes : {&upstream, &downstream})
+    {
+        for (const auto &lane : *lanes)
+        {
+            total += lane.queue + lane.outflowCredit;
+            for (double n : lane.cells)
+            {
+                total += n;
+            }
+        }
+    }
+    return total;
+}
+
+double HybridSimulation::conservationError() const
+{
+    return arrived - (mesoVehicles() + (double)micro.vehicles.size() + departed);
+}
+
+HybridReport runHybridComparison(int windowWidth, int windowHeight, double scale, double widthScale,
+                                 const MesoConfig &config, int ticks, uint64_t seed)
+{
+    HybridReport report = {ticks, config.spawnPeriod, max(1, config.cellTicks), 0, 0, 0, 0, 0, 0, 0};
+
+    HybridSimulation hybrid(windowWidth, windowHeight, scale, widthScale, seed, config);
+    hybrid.micro.params.logRelativeSpeed = false;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i)
+    {
+        hybrid.step();
+        report.hybridMicroVehicles += (double)hybrid.micro.vehicles.size();
+    }
+    report.hybridSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report.hybridDeparted = hybrid.departed;
+    report.conservationError = hybrid.conservationError();
+
+    // 全微观：走廊长度为上游 + 桥面 + 下游，车辆仍按原来的随机方式在两端生成
+    int corridorWidth = windowWidth + (int)((config.upstreamLength + config.downstreamLength) * scale);
+    Simulation micro(corridorWidth, windowHeight, scale, widthScale, seed);
+    micro.params.logRelativeSpeed = false;
+    micro.params.spawnPeriod = config.spawnPeriod;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i)
+    {
+        micro.step();
+        report.microVehicles += (double)micro.vehicles.size();
+    }
+    report.microSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report.microExited = micro.exitedCount;
+
+    if (ticks > 0)
+    {
+        report.hybridMicroVehicles /= ticks;
+        report.microVehicles /= ticks;
+    }
+    return report;
+}
+
+void printHybridReport(const HybridReport &report)
+{
+    printf("ticks: %d  spawn period: %d  far-field update every %d ticks\n", report.ticks, report.spawnPeriod, report.cellTicks);
+    printf("hybrid:     %.3fs  (%.1f us/tick)  avg micro vehicles %.1f  departed %.1f  conservation error %.2e\n",
+           report.hybridSeconds, report.hybridSeconds * 1e6 / max(1, report.ticks), report.hybridMicroVehicles,
+           report.hybridDeparted, report.conservationError);
+    printf("full micro: %.3fs  (%.1f us/tick)  avg vehicles %.1f  exited %lld\n",
+           report.microSeconds, report.microSeconds * 1e6 / max(1, report.ticks), report.microVehicles, report.microExited);
+}
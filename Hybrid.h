@@ -0,0 +1,91 @@
+﻿#include <vector>
+#include "Simulation.h"
+using namespace std;
+
+// 宏观路段参数（元胞传输模型CTM，三角形基本图）
+// 远场每cellTicks帧推进一次，元胞长度取cellTicks帧的自由流行驶距离，保证每次推进车辆最多前进一个元胞。
+// 元胞越粗、推进越少，远场的开销越小（远场不需要桥面的逐帧精度），桥面入口和出口仍然逐帧交换车辆
+struct MesoConfig
+{
+    int cellTicks = 10;             // 远场每多少帧推进一次
+    double upstreamLength = 1000;   // 桥面上游路段长度（米），两个方向各一段
+    double downstreamLength = 1000; // 桥面下游路段长度（米）
+    double freeSpeed = 70;          // 自由流速度（像素/帧），与生成速度[20, 120]的均值相同
+    double capacity = 0;            // 每车道每帧最大通过车辆数，0表示自由流速度/（平均车长+安全距离）
+    double jamSpacing = 0;          // 堵塞时每辆车占用的长度（像素），0表示平均车长+碰撞距离
+    int spawnPeriod = 10;           // 全微观对照的生成频率（SimParams::spawnPeriod）
+    vector<double> demand;          // 各车道上游端每帧到达的车辆数，为空时与spawnPeriod的平均生成频率相同
+};
+
+// 一条车道上的一段宏观路段：按行驶方向排列的元胞，每个元胞记录车辆数（可为小数）
+struct MesoLane
+{
+    vector<double> cells;   // 各元胞中的车辆数
+    double queue = 0;       // 上游路段入口处等待进入的车辆数（点排队）
+    double outflowCredit = 0; // 已流出上游路段末端、在桥面入口缓冲区中的车辆数，满1辆时转换为一辆微观车辆
+    bool hasPending = false;  // 是否已采样好一辆等待进入桥面的车辆
+    SpawnAttempt pending;     // 等待桥面入口腾出安全距离的车辆
+};
+
+// 混合仿真：桥面（Simulation的窗口范围）用微观模型逐车推进，
+// 两个方向的上下游远场路段用CTM只推进元胞密度和流量。
+// 车辆在桥面入口由上游元胞转换为Vehicle，在出口转换回下游元胞的车辆数，
+// 车辆总数在转换时守恒（见conservationError）
+struct HybridSimulation
+{
+    Simulation micro;           // 桥面微观仿真（不再随机生成新车，车辆来自上游路段）
+    MesoConfig config;
+    vector<MesoLane> upstream;   // 各车道的上游路段
+    vector<MesoLane> downstream; // 各车道的下游路段
+    double cellLength;           // 元胞长度（像素）
+    double laneCapacity;         // 每车道每帧最大流量（辆），用于逐帧的桥面入口
+    double cellCapacity;         // 每元胞每次推进（cellTicks帧）最大流量（辆）
+    double cellJam;              // 每元胞最大车辆数（辆）
+    double waveRatio;            // 拥堵波速与自由流速度之比
+
+    // 统计量（辆，可为小数）
+    double arrived;      // 进入上游路段的车辆总数
+    double departed;     // 离开下游路段末端的车辆总数
+    long long converted; // 在桥面入口转换为微观车辆的数量
+
+    HybridSimulation(int windowWidth, int windowHeight, double scale, double widthScale, uint64_t seed,
+                     const MesoConfig &mesoConfig = MesoConfig());
+
+    // 推进一帧：上游元胞、桥面入口转换、微观车辆、桥面出口转换、下游元胞
+    void step();
+    // 上游路段推进一帧（元胞每cellTicks帧推进一次），并在桥面入口生成车辆
+    void advanceUpstream(int lane);
+    // 下游路段推进一帧（元胞每cellTicks帧推进一次）
+    void advanceDownstream(int lane);
+    // 离开桥面的车辆转换为下游元胞中的车辆
+    void transferExits();
+
+    // 各部分车辆总数
+    double mesoVehicles() const;
+    // 车辆守恒误差：到达 - （排队 + 元胞 + 入口缓冲区 + 桥面 + 已离开），应接近0
+    double conservationError() const;
+    // 元胞的平均速度（像素/帧）
+    double cellSpeed(double vehicles) const;
+
+    vector<double> flows; // 元胞间流量（各车道复用，避免每帧分配）
+};
+
+// 混合仿真与同样长度的全微观仿真的对比结果
+struct HybridReport
+{
+    int ticks;
+    int spawnPeriod, cellTicks;            // 交通密度（SimParams::spawnPeriod）和远场推进间隔
+    double hybridSeconds, microSeconds;   // 两种仿真的总耗时
+    double hybridDeparted;                 // 混合仿真离开下游末端的车辆数
+    long long microExited;                 // 全微观仿真驶离走廊的车辆数
+    double hybridMicroVehicles;            // 混合仿真桥面上的平均车辆数
+    double microVehicles;                  // 全微观仿真走廊上的平均车辆数
+    double conservationError;              // 混合仿真的车辆守恒误差
+};
+
+// 推进ticks帧，比较混合仿真与把上下游路段也逐车仿真时的耗时和通过量（两者都按config.spawnPeriod的密度）
+HybridReport runHybridComparison(int windowWidth, int windowHeight, double scale, double widthScale,
+                                 const MesoConfig &config, int ticks, uint64_t seed);
+void printHybridReport(const HybridReport &report);
+
+#pragma once
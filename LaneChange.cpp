@@ -0,0 +1,227 @@
+﻿#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <climits>
+
+#include "LaneChange.h"
+#include "VehicleTypes.h"
+#include "PerfCounters.h"
+#include "AllocProfiler.h"
+using namespace std;
+
+LaneIndex::LaneIndex(const vector<Vehicle> &vehicles, int laneCount)
+    : snapshot(&vehicles), lanes(laneCount), maxSpeed(0), maxLength(0), maxWidth(0)
+{
+    for (int i = 0; i < (int)vehicles.size(); ++i)
+    {
+        const Vehicle &v = vehicles[i];
+        maxSpeed = max(maxSpeed, abs(v.speed));
+        maxLength = max(maxLength, v.carlength);
+        maxWidth = max(maxWidth, v.carwidth);
+        if (v.lane >= 0 && v.lane < laneCount)
+        {
+            lanes[v.lane].push_back(i);
+        }
+    }
+    for (auto &lane : lanes)
+    {
+        sort(lane.begin(), lane.end(), [&vehicles](int a, int b) {
+            return vehicles[a].x != vehicles[b].x ? vehicles[a].x < vehicles[b].x : a < b;
+        });
+    }
+}
+
+void LaneIndex::range(int lane, int xLo, int xHi, size_t &first, size_t &last) const
+{
+    const vector<int> &indices = lanes[lane];
+    const vector<Vehicle> &vehicles = *snapshot;
+    first = lower_bound(indices.begin(), indices.end(), xLo,
+                        [&vehicles](int i, int value) { return vehicles[i].x < value; }) - indices.begin();
+    last = upper_bound(indices.begin(), indices.end(), xHi,
+                       [&vehicles](int value, int i) { return value < vehicles[i].x; }) - indices.begin();
+}
+
+int LaneIndex::reach(const Vehicle &v, int steps) const
+{
+    // 两条预测轨迹最多相差steps + 1步（另一车辆的轨迹不含当前位置），每步相对位移不超过两车速度之和
+    return (steps + 1) * (abs(v.speed) + maxSpeed) + (v.carlength + maxLength) / 2 + 1;
+}
+
+namespace
+{
+    // 车道lane中心线的y坐标
+    int laneCenter(int lane, int laneHeight)
+    {
+        return laneHeight * lane + (int)(0.5 * laneHeight);
+    }
+
+    // 快照中与候选车辆变道轨迹相交的车辆，只检查y和x范围内可能接触的车辆
+    bool isPathSafe(const Vehicle &v, const VirtualVehicle &path, const TrajectoryBox &box, int target, int steps,
+                    const LaneIndex &index, int laneHeight)
+    {
+        const vector<Vehicle> &snapshot = *index.snapshot;
+        int pathTop = min(v.y, laneCenter(target, laneHeight)) - v.carwidth / 2;
+        int pathBottom = max(v.y, laneCenter(target, laneHeight)) + v.carwidth / 2;
+        int reach = index.reach(v, steps);
+        for (int lane = 0; lane < (int)index.lanes.size(); ++lane)
+        {
+            // lane字段为该车道的车辆（可能正在变道到相邻车道）的y在相邻两条车道中心线之间
+            int laneTop = laneCenter(lane - 1, laneHeight) - index.maxWidth / 2;
+            int laneBottom = laneCenter(lane + 1, laneHeight) + index.maxWidth / 2;
+            if (laneBottom < pathTop || laneTop > pathBottom)
+                continue;
+
+            size_t first, last;
+            index.range(lane, v.x - reach, v.x + reach, first, last);
+            for (size_t k = first; k < last; ++k)
+            {
+                const Vehicle &other = snapshot[index.lanes[lane][k]];
+                if (other.id == v.id)
+                    continue; // 跳过自己
+                if (trajectoryConflicts(path, box, other, steps))
+                    return false; // 轨迹相交，变道不安全
+            }
+        }
+        return true;
+    }
+}
+
+void LaneChangeBatch::collect(vector<Vehicle> &movers, int laneCount)
+{
+    // 准备变道、未抛锚、尚未开始变道的车辆
+    for (auto &v : movers)
+    {
+        if (!v.isGoing2change || v.isBrokenDown || v.isChangingLane)
+            continue;
+        int target = v.chooseTargetLane();
+        if (target < 0 || target >= laneCount)
+            continue;
+        addRemote(v, target);
+        candidates.back().mover = &v;
+    }
+}
+
+void LaneChangeBatch::addRemote(const Vehicle &v, int target)
+{
+    LaneChangeCandidate c;
+    c.id = v.id;
+    c.lane = v.lane;
+    c.target = target;
+    c.x = v.x;
+    c.length = v.carlength;
+    c.safeDistance = v.getSafeDistance();
+    c.steps = 0;
+    c.reach = 0;
+    c.gap = 0;
+    c.safe = true;
+    c.granted = false;
+    c.mover = nullptr;
+    candidates.push_back(c);
+    states.push_back(v);
+}
+
+void LaneChangeBatch::checkPaths(const LaneIndex &index, int laneHeight)
+{
+    ALLOC_SCOPE("trajectory");
+    PERF_SCOPE("trajectory"); // 轨迹预测和安全检查
+    paths.clear();
+    boxes.clear();
+    paths.reserve(candidates.size());
+    boxes.reserve(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        LaneChangeCandidate &c = candidates[i];
+        const Vehicle &v = states[i];
+        c.steps = v.predictionHorizon();
+        paths.push_back(v.laneChangePath(c.target, laneHeight, c.steps));
+        boxes.push_back(paths.back().bounds());
+        c.reach = index.reach(v, c.steps);
+        c.safe = c.safe && isPathSafe(v, paths.back(), boxes.back(), c.target, c.steps, index, laneHeight);
+        size_t first, last;
+        index.range(c.target, INT_MIN, c.x - 1, first, last);
+        c.gap = (int)last;
+    }
+}
+
+void LaneChangeBatch::grant(const LaneIndex &index, int laneCount)
+{
+    // 间隙预约表：按目标车道分组，组内按x排序
+    vector<vector<int>> table(laneCount);
+    for (int i = 0; i < (int)candidates.size(); ++i)
+    {
+        if (candidates[i].safe)
+            table[candidates[i].target].push_back(i);
+    }
+    for (auto &entries : table)
+    {
+        sort(entries.begin(), entries.end(), [this](int a, int b) {
+            return candidates[a].x != candidates[b].x ? candidates[a].x < candidates[b].x : candidates[a].id < candidates[b].id;
+        });
+    }
+
+    int maxSafeDistance = 0;
+    for (const auto &c : candidates)
+    {
+        maxSafeDistance = max(maxSafeDistance, c.safeDistance);
+    }
+
+    // 与附近编号更小的安全候选车辆冲突时不允许变道（互不依赖）
+    for (int i = 0; i < (int)candidates.size(); ++i)
+    {
+        LaneChangeCandidate &c = candidates[i];
+        if (!c.safe || !c.mover)
+            continue;
+        c.granted = true;
+        // 查找范围同时覆盖轨迹可能相交的距离和同一间隙内的安全距离
+        int window = max(c.reach, (c.length + index.maxLength) / 2 + maxSafeDistance);
+        // 目标车道相同的候选车辆，以及要驶入本车当前车道的候选车辆
+        for (int tableLane : {c.target, c.lane})
+        {
+            const vector<int> &entries = table[tableLane];
+            auto first = lower_bound(entries.begin(), entries.end(), c.x - window,
+                                     [this](int k, int value) { return candidates[k].x < value; });
+            for (auto it = first; it != entries.end() && candidates[*it].x <= c.x + window && c.granted; ++it)
+            {
+                const LaneChangeCandidate &d = candidates[*it];
+                if (d.id >= c.id)
+                    continue;
+                bool sameSlot = d.target == c.target && d.gap == c.gap &&
+                                abs(d.x - c.x) < (d.length + c.length) / 2 + max(d.safeDistance, c.safeDistance);
+                bool crossing = boxes[i].intersects(boxes[*it]) &&
+                                paths[i].isTrajectoryIntersecting(paths[*it], c.steps + 1); // 外接矩形相交时才逐帧比较
+                if (sameSlot || crossing)
+                    c.granted = false;
+            }
+        }
+    }
+}
+
+void LaneChangeBatch::apply(int laneHeight)
+{
+    for (auto &c : candidates)
+    {
+        if (!c.mover)
+            continue;
+        if (c.granted)
+        {
+            c.mover->startLaneChange(c.target, laneHeight); // 变道安全，开始变道
+        }
+        else
+        {
+            c.mover->isGoing2change = false; // 取消准备变道状态
+        }
+    }
+}
+
+void resolveLaneChanges(vector<Vehicle> &movers, const vector<Vehicle> &snapshot, int laneHeight, int laneCount)
+{
+    LaneChangeBatch batch;
+    batch.collect(movers, laneCount);
+    if (batch.candidates.empty())
+        return;
+
+    LaneIndex index(snapshot, laneCount);
+    batch.checkPaths(index, laneHeight);
+    batch.grant(index, laneCount);
+    batch.apply(laneHeight);
+}
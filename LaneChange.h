@@ -0,0 +1,74 @@
+﻿#include <vector>
+#include "Class.h"
+using namespace std;
+
+// 按车道分组、按x排序的快照索引，用于只检查附近的车辆
+struct LaneIndex
+{
+    const vector<Vehicle> *snapshot;
+    vector<vector<int>> lanes; // 每条车道上（按lane字段）车辆在快照中的下标，按x递增
+    int maxSpeed;              // 快照中的最大速度
+    int maxLength;             // 快照中的最大车长
+    int maxWidth;              // 快照中的最大车宽
+
+    LaneIndex(const vector<Vehicle> &vehicles, int laneCount);
+
+    // 车道lane中x在[xLo, xHi]范围内的车辆下标区间 [first, last)
+    void range(int lane, int xLo, int xHi, size_t &first, size_t &last) const;
+    // 车辆v在steps步轨迹预测中可能接触到的其他车辆与它的最大x距离
+    int reach(const Vehicle &v, int steps) const;
+};
+
+// 一个变道意图：本帧准备变道、尚未开始变道的车辆
+struct LaneChangeCandidate
+{
+    int id;          // 车辆编号（编号小的优先）
+    int lane;        // 当前车道
+    int target;      // 目标车道
+    int x;           // 当前位置
+    int length;      // 车长
+    int safeDistance; // 车型的安全距离
+    int steps;       // 预测帧数（Vehicle::predictionHorizon）
+    int reach;       // 与其他车辆可能接触的最大x距离
+    int gap;         // 目标车道上的间隙序号（目标车道上x小于本车的车辆数）
+    bool safe;       // 轨迹与快照中所有车辆都不相交
+    bool granted;    // 批量判断后允许变道
+    Vehicle *mover;  // 需要更新的车辆（只用于比较的车辆为nullptr）
+};
+
+// 批量变道判断：收集本帧所有变道意图，按目标车道建立间隙预约表，一次确定性地判断
+//
+// 1. 每个候选车辆的变道轨迹只与快照中附近车道、附近x范围内的车辆比较（LaneIndex），
+//    预测帧数按车速自适应，先比较整段轨迹的外接矩形，相交时才逐帧比较
+// 2. 同一目标车道的同一间隙内，相距不足安全距离的安全候选车辆只允许编号最小的一辆进入，
+//    同一段空间不会被预约两次；
+//    轨迹互相相交的两个安全候选车辆（包括互换车道）也只允许编号小的一辆
+// 3. 每个候选车辆的结果只取决于快照和附近候选车辆的安全性，与车辆顺序无关，
+//    各候选车辆之间互不写入，可以并行判断
+//
+// 两遍判断都只在真正可能接触的范围内查找，结果与快照中多出的远处车辆无关。分域运行（见Domain.h）
+// 据此把判断拆开：各分域只用自己的车辆检查候选车辆的轨迹（checkPaths），交换结果后取与，
+// 再用附近分域发来的候选车辆做第二遍（grant）
+struct LaneChangeBatch
+{
+    vector<LaneChangeCandidate> candidates;
+    vector<Vehicle> states;       // 候选车辆判断时的状态
+    vector<VirtualVehicle> paths; // 变道轨迹
+    vector<TrajectoryBox> boxes;  // 轨迹的外接矩形
+
+    // 加入movers中准备变道的车辆（消耗各自的随机数选择目标车道）
+    void collect(vector<Vehicle> &movers, int laneCount);
+    // 加入只参与比较的候选车辆（其他分域的车辆，target为其所属分域选定的目标车道）
+    void addRemote(const Vehicle &v, int target);
+    // 第一遍：预测轨迹，与index中的车辆比较（safe与之前的结果取与），并计算reach和间隙序号
+    void checkPaths(const LaneIndex &index, int laneHeight);
+    // 第二遍：间隙预约和轨迹交叉，只判断需要更新的候选车辆
+    void grant(const LaneIndex &index, int laneCount);
+    // 按结果开始变道或取消准备状态
+    void apply(int laneHeight);
+};
+
+// 单进程的批量变道判断：movers中准备变道的车辆与快照比较，按结果开始变道或取消准备状态
+void resolveLaneChanges(vector<Vehicle> &movers, const vector<Vehicle> &snapshot, int laneHeight, int laneCount);
+
+#pragma once
@@ -0,0 +1,176 @@
+﻿#include <vector>
+#include <cstdlib>
+#include <algorithm>
+
+#include "LaneTopology.h"
+#include "VehicleTypes.h"
+using namespace std;
+
+namespace
+{
+    // 编译期布局：方向和变道表都是常量
+    template <int LaneCount, int RightLanes>
+    struct FixedLanes
+    {
+        static constexpr LaneTable table = makeLaneTable(LaneCount, RightLanes);
+
+        explicit FixedLanes(const LaneTopology &) {}
+        static constexpr int direction(int lane) { return lane < RightLanes ? 1 : -1; }
+        static int target(int lane) { return (unsigned)lane < (unsigned)LANE_MAX ? table.target[lane] : LANE_RANDOM; }
+    };
+
+    template <int LaneCount, int RightLanes>
+    constexpr LaneTable FixedLanes<LaneCount, RightLanes>::table;
+
+    // 运行时布局：读取仿真的车道表
+    struct DynamicLanes
+    {
+        const LaneTopology &topology;
+
+        explicit DynamicLanes(const LaneTopology &topology) : topology(topology) {}
+        int direction(int lane) const { return topology.direction(lane); }
+        int target(int lane) const { return topology.target(lane); }
+    };
+
+    template <typename Lanes>
+    void moveVehicles(const LaneTopology &topology, vector<Vehicle> &movers)
+    {
+        Lanes lanes(topology);
+        for (auto &v : movers)
+        {
+            if (v.speed == 0)
+            {
+                v.handleDangerousSituation();
+            }
+            v.x += lanes.direction(v.lane) * v.speed;
+        }
+    }
+
+    // 快照中第一辆同车道、在前方且距离不超过threshold的车辆，找到时对它做出反应
+    template <typename Lanes>
+    void checkFront(const Lanes &lanes, Vehicle &v, const vector<Vehicle> &snapshot, int safeDistance,
+                    int threshold, vector<int> &crashedIds)
+    {
+        int direction = lanes.direction(v.lane);
+        for (const auto &other : snapshot)
+        {
+            if (other.id == v.id || other.lane != v.lane)
+                continue;
+            // 沿行驶方向x更大的车是前车
+            if (direction * (other.x - v.x) <= 0)
+                continue;
+            int distance = abs(other.x - v.x) - (other.carlength / 2 + v.carlength / 2);
+            if (distance <= threshold)
+            {
+                v.reactToFrontVehicle(other, distance, safeDistance, crashedIds);
+                return; // 找到最近的前车后即可返回
+            }
+        }
+    }
+
+    template <typename Lanes>
+    void checkFrontVehicle(const LaneTopology &topology, Vehicle &v, const vector<Vehicle> &snapshot, int safeDistance,
+                           vector<int> &crashedIds)
+    {
+        int threshold = max(safeDistance, simParams().crashDistance);
+        checkFront(Lanes(topology), v, snapshot, safeDistance, threshold, crashedIds);
+    }
+
+    template <typename Lanes>
+    void followVehicles(const LaneTopology &topology, vector<Vehicle> &movers, const vector<Vehicle> &snapshot,
+                        const SafeDistanceTable &safeDistances, vector<int> &crashedIds)
+    {
+        Lanes lanes(topology);
+        int crashDistance = simParams().crashDistance;
+        for (auto &v : movers)
+        {
+            int safeDistance = safeDistances[v.type]; // 车型的安全距离
+            checkFront(lanes, v, snapshot, safeDistance, max(safeDistance, crashDistance), crashedIds);
+        }
+    }
+
+    template <typename Lanes>
+    void recoverVehicles(const LaneTopology &topology, vector<Vehicle> &movers, const vector<Vehicle> &snapshot,
+                         int safeDistance)
+    {
+        Lanes lanes(topology);
+        for (auto &v : movers)
+        {
+            if (!v.isTooClose)
+                continue;
+            // 检查当前是否仍然距离过近
+            int direction = lanes.direction(v.lane);
+            bool stillTooClose = false;
+            for (const auto &other : snapshot)
+            {
+                if (other.id == v.id || other.lane != v.lane || direction * (other.x - v.x) <= 0)
+                    continue;
+                int distance = abs(other.x - v.x) - (other.carlength / 2 + v.carlength / 2);
+                if (distance <= safeDistance)
+                {
+                    stillTooClose = true;
+                    break;
+                }
+            }
+            if (!stillTooClose)
+            {
+                // 恢复原始颜色
+                v.color = v.originalColor;
+                v.isTooClose = false;
+            }
+        }
+    }
+
+    template <typename Lanes>
+    int chooseTarget(const LaneTopology &topology, Vehicle &v)
+    {
+        int target = Lanes(topology).target(v.lane);
+        if (target == LANE_RANDOM)
+            return v.lane + (v.rng() % 2 ? 1 : -1);
+        return target == LANE_NONE ? -1 : target;
+    }
+
+    template <typename Lanes>
+    LaneKernels makeKernels(const LaneTopology &topology, bool specialized)
+    {
+        return LaneKernels{topology, specialized, &moveVehicles<Lanes>, &followVehicles<Lanes>,
+                           &checkFrontVehicle<Lanes>, &recoverVehicles<Lanes>, &chooseTarget<Lanes>};
+    }
+
+    template <int LaneCount, int RightLanes>
+    LaneKernels makeFixedKernels(const LaneTopology &topology)
+    {
+        return makeKernels<FixedLanes<LaneCount, RightLanes>>(topology, true);
+    }
+
+    // 分派表：特化过的布局
+    struct KernelEntry
+    {
+        int laneCount, rightLanes;
+        LaneKernels (*make)(const LaneTopology &);
+    };
+
+    const KernelEntry kernelTable[] = {
+        {6, 3, &makeFixedKernels<6, 3>},
+        {4, 2, &makeFixedKernels<4, 2>},
+        {8, 4, &makeFixedKernels<8, 4>},
+        {2, 1, &makeFixedKernels<2, 1>},
+    };
+}
+
+LaneKernels selectLaneKernels(int laneCount, int rightLanes)
+{
+    LaneTopology topology(laneCount, rightLanes);
+    for (const auto &entry : kernelTable)
+    {
+        if (entry.laneCount == laneCount && entry.rightLanes == rightLanes)
+            return entry.make(topology);
+    }
+    return makeKernels<DynamicLanes>(topology, false);
+}
+
+const LaneKernels &defaultLaneKernels()
+{
+    static const LaneKernels kernels = selectLaneKernels(6, 3);
+    return kernels;
+}
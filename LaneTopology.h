@@ -0,0 +1,118 @@
+﻿#include <vector>
+#include <cstdint>
+using namespace std;
+
+// 车道布局：laneCount条车道，前rightLanes条（上方）向右行驶，其余向左行驶。
+// 行驶方向和变道目标在每帧的热点循环里对每辆车都要判断，这些循环按布局在编译期特化
+// （LaneTopology.cpp中的FixedLanes）：方向是与常量的比较，变道目标查常量表，不含分支。
+// 常见布局各有一套专用内核，其他布局使用读取运行时车道表的通用内核，两者结果相同。
+// 仿真按自己的布局选择一次内核（selectLaneKernels），之后只通过函数指针调用
+
+const int LANE_MAX = 16;    // 变道表覆盖的车道数，编号更大的车道直接按laneChangeTarget计算
+const int LANE_RANDOM = -1; // 变道表：中间车道，随机选择左右
+const int LANE_NONE = -2;   // 变道表：所在方向只有一条车道，不能变道
+
+// 车道lane的变道目标：每个方向的边车道只能向内侧变道，中间车道随机选择左右
+constexpr int laneChangeTarget(int lane, int laneCount, int rightLanes)
+{
+    int first = lane < rightLanes ? 0 : rightLanes;                // 车道所在方向的第一条车道
+    int last = lane < rightLanes ? rightLanes - 1 : laneCount - 1; // 最后一条车道
+    return (lane < 0 || lane >= laneCount) ? LANE_RANDOM
+           : first == last                 ? LANE_NONE
+           : lane == first                 ? lane + 1
+           : lane == last                  ? lane - 1
+                                           : LANE_RANDOM;
+}
+
+// 各车道的变道目标表
+struct LaneTable
+{
+    int8_t target[LANE_MAX];
+};
+
+constexpr LaneTable makeLaneTable(int laneCount, int rightLanes)
+{
+    LaneTable table = {};
+    for (int lane = 0; lane < LANE_MAX; ++lane)
+    {
+        table.target[lane] = (int8_t)laneChangeTarget(lane, laneCount, rightLanes);
+    }
+    return table;
+}
+
+// 运行时的车道布局（任意车道数）
+struct LaneTopology
+{
+    int laneCount;
+    int rightLanes; // 向右行驶的车道数
+    LaneTable table;
+
+    LaneTopology(int laneCount, int rightLanes)
+        : laneCount(laneCount), rightLanes(rightLanes), table(makeLaneTable(laneCount, rightLanes)) {}
+
+    // 行驶方向：1向右，-1向左
+    int direction(int lane) const { return lane < rightLanes ? 1 : -1; }
+    // 变道目标（车道编号、LANE_RANDOM或LANE_NONE）：表外的车道也可能是某个方向的边车道，不能当作中间车道
+    int target(int lane) const
+    {
+        return (unsigned)lane < (unsigned)LANE_MAX ? table.target[lane] : laneChangeTarget(lane, laneCount, rightLanes);
+    }
+};
+
+struct Vehicle;
+struct SafeDistanceTable;
+
+// 一种布局的热点内核（LaneTopology.cpp中按布局实例化的函数）
+struct LaneKernels
+{
+    LaneTopology topology;
+    bool specialized; // 是否为编译期特化的布局
+
+    void (*moveKernel)(const LaneTopology &, vector<Vehicle> &);
+    void (*followKernel)(const LaneTopology &, vector<Vehicle> &, const vector<Vehicle> &, const SafeDistanceTable &, vector<int> &);
+    void (*checkFrontKernel)(const LaneTopology &, Vehicle &, const vector<Vehicle> &, int, vector<int> &);
+    void (*recoverKernel)(const LaneTopology &, vector<Vehicle> &, const vector<Vehicle> &, int);
+    int (*chooseTargetKernel)(const LaneTopology &, Vehicle &);
+
+    // 车辆前进（速度为0的车辆抛锚）
+    void move(vector<Vehicle> &movers) const { moveKernel(topology, movers); }
+    // 每辆车检查同车道的前车（见Vehicle::checkFrontVehicleDistance）
+    void follow(vector<Vehicle> &movers, const vector<Vehicle> &snapshot, const SafeDistanceTable &safeDistances,
+                vector<int> &crashedIds) const
+    {
+        followKernel(topology, movers, snapshot, safeDistances, crashedIds);
+    }
+    // 一辆车的前车检查
+    void checkFront(Vehicle &v, const vector<Vehicle> &snapshot, int safeDistance, vector<int> &crashedIds) const
+    {
+        checkFrontKernel(topology, v, snapshot, safeDistance, crashedIds);
+    }
+    // 处于距离警告状态的车辆与前车拉开安全距离后恢复原色
+    void recover(vector<Vehicle> &movers, const vector<Vehicle> &snapshot, int safeDistance) const
+    {
+        recoverKernel(topology, movers, snapshot, safeDistance);
+    }
+    // 选择变道目标（中间车道消耗车辆自己的一次随机数），不能变道时返回-1
+    int chooseTarget(Vehicle &v) const { return chooseTargetKernel(topology, v); }
+};
+
+// 按布局选择内核：常见布局（6/3、4/2、8/4、2/1）使用特化内核，其他布局使用通用内核
+LaneKernels selectLaneKernels(int laneCount, int rightLanes);
+// 默认布局（6条车道，上方3条向右）的内核
+const LaneKernels &defaultLaneKernels();
+
+// 当前线程正在推进的仿真所绑定的内核（由SimulationScope设置）
+inline const LaneKernels *&boundLaneKernels()
+{
+    thread_local const LaneKernels *kernels = nullptr;
+    return kernels;
+}
+
+// 车辆逻辑使用的内核：未绑定仿真时使用默认布局
+inline const LaneKernels &currentLaneKernels()
+{
+    const LaneKernels *kernels = boundLaneKernels();
+    return kernels != nullptr ? *kernels : defaultLaneKernels();
+}
+
+#pragma once
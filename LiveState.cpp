@@ -0,0 +1,99 @@
+﻿#include <new>
+#include <algorithm>
+
+#include "LiveState.h"
+#include "Simulation.h"
+using namespace std;
+
+LiveVehicle toLiveVehicle(const Vehicle &v)
+{
+    LiveVehicle o;
+    o.id = v.id;
+    o.x = v.x;
+    o.y = v.y;
+    o.speed = (int16_t)v.speed;
+    o.length = (int16_t)v.carlength;
+    o.width = (int16_t)v.carwidth;
+    o.lane = (int8_t)v.lane;
+    o.type = (uint8_t)v.type;
+    o.flags = (uint8_t)((v.isChangingLane ? LIVE_CHANGING_LANE : 0) | (v.isBrokenDown ? LIVE_BROKEN_DOWN : 0) |
+                        (v.isFlashing ? LIVE_FLASHING : 0));
+    o.reserved[0] = o.reserved[1] = o.reserved[2] = 0;
+    return o;
+}
+
+bool LiveStatePublisher::create(const string &name, const Simulation &sim, uint32_t capacity)
+{
+    if (capacity == 0 || !region.create(name, LiveLayout::totalSize(capacity)))
+        return false;
+
+    layout = {static_cast<char *>(region.data), capacity};
+    LiveHeader *header = new (layout.header()) LiveHeader;
+    header->version = LIVE_VERSION;
+    header->capacity = capacity;
+    header->vehicleSize = sizeof(LiveVehicle);
+    header->windowWidth = sim.windowWidth;
+    header->windowHeight = sim.windowHeight;
+    header->laneCount = sim.laneCount;
+    header->laneHeight = sim.laneHeight;
+    header->published.store(0);
+    for (int i = 0; i < 2; ++i)
+    {
+        LiveFrame *frame = new (layout.slot(i)) LiveFrame;
+        frame->sequence.store(0);
+        frame->count = frame->total = 0;
+    }
+    atomic_thread_fence(memory_order_release);
+    header->magic = LIVE_MAGIC; // 读取方看到magic时布局已经完整
+    return true;
+}
+
+void LiveStatePublisher::publish(const Simulation &sim)
+{
+    if (layout.base == nullptr)
+        return;
+
+    LiveHeader *header = layout.header();
+    uint64_t published = header->published.load(memory_order_relaxed);
+    LiveFrame *frame = layout.slot((int)(published % 2)); // 写不是最近完成的那个槽
+
+    uint32_t sequence = frame->sequence.load(memory_order_relaxed);
+    frame->sequence.store(sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release); // 奇数序号先于数据可见
+
+    uint32_t count = (uint32_t)min(sim.vehicles.size(), (size_t)layout.capacity);
+    LiveVehicle *out = frame->vehicles();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        out[i] = toLiveVehicle(sim.vehicles[i]);
+    }
+    frame->count = count;
+    frame->total = (uint32_t)sim.vehicles.size();
+    frame->tick = sim.tick;
+    frame->time = sim.time;
+    frame->exitedCount = sim.exitedCount;
+    frame->brokenDownCount = sim.brokenDownCount;
+    if (count < sim.vehicles.size())
+        ++truncatedFrames;
+
+    frame->sequence.store(sequence + 2, memory_order_release);
+    header->published.store(published + 1, memory_order_release);
+}
+
+bool LiveStateReader::open(const string &name)
+{
+    // 先只映射头部读出容量，再映射整个区域
+    if (!region.open(name, sizeof(LiveHeader), true))
+        return false;
+    const LiveHeader *header = static_cast<const LiveHeader *>(region.data);
+    if (header->magic != LIVE_MAGIC || header->version != LIVE_VERSION || header->vehicleSize != sizeof(LiveVehicle))
+    {
+        region.close();
+        return false;
+    }
+    uint32_t capacity = header->capacity;
+    if (!region.open(name, LiveLayout::totalSize(capacity), true))
+        return false;
+    layout = {static_cast<char *>(region.data), capacity};
+    return true;
+}
@@ -0,0 +1,155 @@
+﻿#include <atomic>
+#include <string>
+#include <cstdint>
+#include "SharedMemory.h"
+using namespace std;
+
+// 实时状态发布：仿真线程每推进完一帧，把紧凑的车辆状态写入命名共享内存，
+// 任意数量的本地读取进程（查看器、指标采集）映射同一区域直接读取，不复制、不加锁。
+//
+// 区域里有两个帧槽，各由一个序号（seqlock）保护：写入方轮流写两个槽，写之前序号变为奇数，
+// 写完变为偶数，然后更新published。读取方读最近完成的槽，读完后序号没有变化就是一致的快照，
+// 否则重试。写入方从不等待读取方；读取方只有在一次读取跨越了整整一帧时才需要重试。
+
+const uint32_t LIVE_MAGIC = 0x564C5343; // "CSLV"
+const uint32_t LIVE_VERSION = 1;
+
+// 车辆标志位
+const uint8_t LIVE_CHANGING_LANE = 1; // 正在变道
+const uint8_t LIVE_BROKEN_DOWN = 2;   // 抛锚
+const uint8_t LIVE_FLASHING = 4;      // 本帧距离前车过近（显示橘色线框）
+
+// 一辆车的紧凑状态（24字节）
+struct LiveVehicle
+{
+    int32_t id;
+    int32_t x, y;     // 像素
+    int16_t speed;    // 像素/帧
+    int16_t length;   // 像素
+    int16_t width;    // 像素
+    int8_t lane;
+    uint8_t type;     // 0-小轿车，1-SUV，2-大卡车
+    uint8_t flags;    // LIVE_*标志位
+    uint8_t reserved[3];
+};
+
+// 一个帧槽的头部，后面紧跟capacity个LiveVehicle
+struct alignas(64) LiveFrame
+{
+    atomic<uint32_t> sequence; // 奇数表示正在写入
+    uint32_t count;            // 本槽中的车辆数（不超过capacity）
+    uint32_t total;            // 桥上的车辆总数（超过capacity时只发布前capacity辆）
+    uint32_t reserved;
+    int64_t tick;
+    double time;
+    int64_t exitedCount;
+    int64_t brokenDownCount;
+
+    const LiveVehicle *vehicles() const { return reinterpret_cast<const LiveVehicle *>(this + 1); }
+    LiveVehicle *vehicles() { return reinterpret_cast<LiveVehicle *>(this + 1); }
+};
+
+// 区域头部
+struct alignas(64) LiveHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;    // 每个帧槽最多容纳的车辆数
+    uint32_t vehicleSize; // sizeof(LiveVehicle)，读取方据此检查布局
+    int32_t windowWidth, windowHeight;
+    int32_t laneCount, laneHeight;
+    atomic<uint64_t> published; // 已发布的帧数，最近完成的槽为 (published - 1) % 2
+};
+
+static_assert(sizeof(LiveVehicle) == 24, "实时车辆状态必须是24字节");
+
+// 区域布局：头部 + 两个帧槽
+struct LiveLayout
+{
+    char *base;
+    uint32_t capacity;
+
+    static size_t slotSize(uint32_t capacity)
+    {
+        return (sizeof(LiveFrame) + sizeof(LiveVehicle) * capacity + 63) / 64 * 64;
+    }
+    static size_t totalSize(uint32_t capacity) { return sizeof(LiveHeader) + 2 * slotSize(capacity); }
+
+    LiveHeader *header() const { return reinterpret_cast<LiveHeader *>(base); }
+    LiveFrame *slot(int index) const
+    {
+        return reinterpret_cast<LiveFrame *>(base + sizeof(LiveHeader) + index * slotSize(capacity));
+    }
+};
+
+struct Simulation;
+struct Vehicle;
+
+// 车辆的紧凑状态（实时发布和运行记录共用，见Recording.h）
+LiveVehicle toLiveVehicle(const Vehicle &v);
+
+// 发布方（仿真线程）：create一次，每帧结束时publish
+struct LiveStatePublisher
+{
+    SharedMemory region;
+    LiveLayout layout = {nullptr, 0};
+    long long truncatedFrames = 0; // 车辆数超过容量、只发布了一部分的帧数
+
+    // 创建共享内存区域，capacity为每帧最多发布的车辆数
+    bool create(const string &name, const Simulation &sim, uint32_t capacity = 4096);
+    // 发布一帧（不等待、不分配内存）
+    void publish(const Simulation &sim);
+};
+
+// 一致快照的只读视图：指针直接指向共享内存
+struct LiveSnapshot
+{
+    const LiveHeader *header;
+    const LiveFrame *frame;
+    const LiveVehicle *vehicles;
+    uint32_t count;
+};
+
+// 读取方
+struct LiveStateReader
+{
+    SharedMemory region;
+    LiveLayout layout = {nullptr, 0};
+    long long retries = 0; // 因读取期间被覆盖而重试的次数
+
+    // 只读映射发布方创建的区域
+    bool open(const string &name);
+
+    // 在共享内存上直接读取最近一帧：visitor(const LiveSnapshot &)在读取区内调用，
+    // 返回后检查序号，读取期间被覆盖则丢弃结果并重新调用，因此visitor只能做计算，不能有副作用。
+    // 还没有发布任何帧或重试maxAttempts次仍不一致时返回false
+    template <typename Visitor>
+    bool read(Visitor &&visitor, int maxAttempts = 100)
+    {
+        const LiveHeader *header = layout.header();
+        for (int attempt = 0; attempt < maxAttempts; ++attempt)
+        {
+            uint64_t published = header->published.load(memory_order_acquire);
+            if (published == 0)
+                return false;
+            const LiveFrame *frame = layout.slot((int)((published - 1) % 2));
+            uint32_t before = frame->sequence.load(memory_order_acquire);
+            if (before % 2 == 0)
+            {
+                LiveSnapshot snapshot;
+                snapshot.header = header;
+                snapshot.frame = frame;
+                snapshot.vehicles = frame->vehicles();
+                snapshot.count = frame->count < layout.capacity ? frame->count : layout.capacity;
+                visitor(snapshot);
+                atomic_thread_fence(memory_order_acquire);
+                if (frame->sequence.load(memory_order_relaxed) == before)
+                    return true;
+            }
+            ++retries;
+        }
+        return false;
+    }
+};
+
+#pragma once
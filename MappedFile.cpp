@@ -0,0 +1,134 @@
+﻿#include <string>
+
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+#ifdef _WIN32
+
+bool MappedFile::open(const string &path)
+{
+    close();
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize))
+    {
+        CloseHandle(handle);
+        return false;
+    }
+    size = (uint64_t)fileSize.QuadPart;
+    file = handle;
+    if (size == 0)
+        return true; // 空文件不能创建映射对象
+    HANDLE fileMapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (fileMapping == NULL)
+    {
+        close();
+        return false;
+    }
+    mapping = fileMapping;
+    return true;
+}
+
+bool MappedFile::map(uint64_t offset, size_t length, MappedView &view) const
+{
+    if (mapping == nullptr || length == 0)
+        return false;
+    void *data = MapViewOfFile((HANDLE)mapping, FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)(offset & 0xFFFFFFFF), length);
+    if (data == NULL)
+        return false;
+    view.data = (const uint8_t *)data;
+    view.offset = offset;
+    view.length = length;
+    return true;
+}
+
+void MappedFile::unmap(MappedView &view)
+{
+    if (view.data != nullptr)
+        UnmapViewOfFile(view.data);
+    view = MappedView();
+}
+
+size_t MappedFile::granularity()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+
+void MappedFile::close()
+{
+    if (mapping != nullptr)
+        CloseHandle((HANDLE)mapping);
+    if (file != nullptr)
+        CloseHandle((HANDLE)file);
+    mapping = nullptr;
+    file = nullptr;
+    size = 0;
+}
+
+#else
+
+bool MappedFile::open(const string &path)
+{
+    close();
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    struct stat info;
+    if (fstat(descriptor, &info) != 0)
+    {
+        ::close(descriptor);
+        return false;
+    }
+    fd = descriptor;
+    size = (uint64_t)info.st_size;
+    return true;
+}
+
+bool MappedFile::map(uint64_t offset, size_t length, MappedView &view) const
+{
+    if (fd < 0 || length == 0)
+        return false;
+    void *data = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, (off_t)offset);
+    if (data == MAP_FAILED)
+        return false;
+    madvise(data, length, MADV_SEQUENTIAL); // 顺序读取，内核可以提前读入并尽早回收已读页面
+    view.data = (const uint8_t *)data;
+    view.offset = offset;
+    view.length = length;
+    return true;
+}
+
+void MappedFile::unmap(MappedView &view)
+{
+    if (view.data != nullptr)
+        munmap((void *)view.data, view.length);
+    view = MappedView();
+}
+
+size_t MappedFile::granularity()
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+
+void MappedFile::close()
+{
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+    size = 0;
+}
+
+#endif
@@ -0,0 +1,42 @@
+﻿#include <string>
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+// 只读映射文件的一段视图
+struct MappedView
+{
+    const uint8_t *data = nullptr; // 视图起始地址（对应文件中的offset）
+    uint64_t offset = 0;           // 视图在文件中的起始位置
+    size_t length = 0;             // 视图长度（字节）
+};
+
+// 只读文件映射：按窗口映射大文件的一部分，多GB的文件也不必整体读入内存或占用地址空间
+// Windows使用文件映射对象，其他平台使用mmap
+struct MappedFile
+{
+    uint64_t size = 0; // 文件大小（字节）
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    MappedFile() {}
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() { close(); }
+
+    // 打开文件（只读）
+    bool open(const string &path);
+    // 映射[offset, offset + length)，offset必须是granularity()的整数倍
+    bool map(uint64_t offset, size_t length, MappedView &view) const;
+    // 取消映射
+    static void unmap(MappedView &view);
+    // 映射起始位置的对齐粒度
+    static size_t granularity();
+    void close();
+};
+
+#pragma once
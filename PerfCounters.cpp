@@ -0,0 +1,281 @@
+﻿#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+#include "PerfCounters.h"
+using namespace std;
+
+namespace
+{
+    const char *phaseNames[PERF_MAX_PHASES] = {"untracked", "other"};
+    atomic<int> phaseCount(2);
+    atomic_flag registerLock = ATOMIC_FLAG_INIT;
+
+    const int OTHER_PHASE = 1;
+
+#ifdef __linux__
+    // 各种计数器对应的perf事件
+    const uint64_t eventConfigs[PERF_COUNTER_KINDS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                       PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+    int openEvent(uint64_t config, int groupFd)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = groupFd < 0 ? 1 : 0; // 组长先停着，整组一起启动
+        attr.exclude_kernel = 1;             // 只统计用户态，perf_event_paranoid=2时也能打开
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return (int)syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0); // 当前线程，任意CPU
+    }
+#endif
+}
+
+PerfCounterGroup::PerfCounterGroup()
+{
+    for (int k = 0; k < PERF_COUNTER_KINDS; ++k)
+    {
+        fds[k] = -1;
+        available[k] = false;
+    }
+}
+
+PerfCounterGroup::~PerfCounterGroup()
+{
+    close();
+}
+
+bool PerfCounterGroup::open(string &reason)
+{
+    close();
+#ifdef __linux__
+    fds[PERF_CYCLES] = openEvent(eventConfigs[PERF_CYCLES], -1);
+    if (fds[PERF_CYCLES] < 0)
+    {
+        reason = string("perf_event_open: ") + strerror(errno);
+        if (errno == EACCES || errno == EPERM)
+            reason += " (check /proc/sys/kernel/perf_event_paranoid)";
+        return false;
+    }
+    available[PERF_CYCLES] = true;
+    count = 1;
+    // 其余计数器加入组，个别事件不支持时跳过
+    for (int k = PERF_CYCLES + 1; k < PERF_COUNTER_KINDS; ++k)
+    {
+        fds[k] = openEvent(eventConfigs[k], fds[PERF_CYCLES]);
+        available[k] = fds[k] >= 0;
+        count += available[k] ? 1 : 0;
+    }
+    ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+#else
+    reason = "hardware counters need Linux perf_event_open";
+    return false;
+#endif
+}
+
+void PerfCounterGroup::close()
+{
+#ifdef __linux__
+    for (int k = PERF_COUNTER_KINDS - 1; k >= 0; --k)
+    {
+        if (fds[k] >= 0)
+            ::close(fds[k]);
+    }
+#endif
+    for (int k = 0; k < PERF_COUNTER_KINDS; ++k)
+    {
+        fds[k] = -1;
+        available[k] = false;
+    }
+    count = 0;
+}
+
+bool PerfCounterGroup::read(uint64_t values[PERF_COUNTER_KINDS]) const
+{
+    for (int k = 0; k < PERF_COUNTER_KINDS; ++k)
+        values[k] = 0;
+#ifdef __linux__
+    if (count == 0)
+        return false;
+    // PERF_FORMAT_GROUP：计数器个数，然后按加入组的顺序排列的值
+    uint64_t buffer[1 + PERF_COUNTER_KINDS];
+    ssize_t bytes = ::read(fds[PERF_CYCLES], buffer, sizeof(buffer));
+    if (bytes < (ssize_t)sizeof(uint64_t) || buffer[0] != (uint64_t)count)
+        return false;
+    int next = 1;
+    for (int k = 0; k < PERF_COUNTER_KINDS; ++k)
+    {
+        if (available[k])
+            values[k] = buffer[next++];
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+int registerPerfPhase(const char *name)
+{
+    while (registerLock.test_and_set(memory_order_acquire))
+    {
+    }
+    int count = phaseCount.load(memory_order_relaxed);
+    int phase = -1;
+    for (int i = 0; i < count; ++i)
+    {
+        if (strcmp(phaseNames[i], name) == 0)
+            phase = i;
+    }
+    if (phase < 0)
+    {
+        if (count < PERF_MAX_PHASES)
+        {
+            phase = count;
+            phaseNames[phase] = name;
+            phaseCount.store(count + 1, memory_order_release);
+        }
+        else
+        {
+            phase = OTHER_PHASE;
+        }
+    }
+    registerLock.clear(memory_order_release);
+    return phase;
+}
+
+PerfProfiler *&currentPerfProfiler()
+{
+    thread_local PerfProfiler *profiler = nullptr;
+    return profiler;
+}
+
+void PerfProfiler::start()
+{
+    report.unavailableReason.clear();
+    report.countersAvailable = group.open(report.unavailableReason);
+    for (int k = 0; k < PERF_COUNTER_KINDS; ++k)
+        report.supported[k] = group.available[k];
+    report.phases.assign(PERF_MAX_PHASES, PerfPhaseStats{"", 0, 0, {0, 0, 0, 0}});
+    stack.assign(1, 0);
+    stack.reserve(PERF_MAX_PHASES);
+    group.read(lastCounters);
+    lastTime = chrono::steady_clock::now();
+    running = true;
+}
+
+void PerfProfiler::stop()
+{
+    if (!running)
+        return;
+    charge();
+    running = false;
+    group.close();
+    // 能打开但从未计数（例如虚拟机或容器没有把PMU交给客户机）
+    uint64_t cycles = 0;
+    for (const auto &p : report.phases)
+        cycles += p.counters[PERF_CYCLES];
+    if (report.countersAvailable && cycles == 0)
+    {
+        report.countersAvailable = false;
+        report.unavailableReason = "counters opened but never counted (no PMU access)";
+    }
+    // 统计期间才注册的阶段也要有名字，多余的槽位去掉
+    int count = phaseCount.load(memory_order_acquire);
+    report.phases.resize(count);
+    for (int i = 0; i < count; ++i)
+        report.phases[i].name = phaseNames[i];
+}
+
+void PerfProfiler::charge()
+{
+    uint64_t now[PERF_COUNTER_KINDS];
+    group.read(now);
+    auto time = chrono::steady_clock::now();
+    PerfPhaseStats &p = report.phases[stack.empty() ? 0 : stack.back()];
+    p.seconds += chrono::duration<double>(time - lastTime).count();
+    for (int k = 0; k < PERF_COUNTER_KINDS; ++k)
+    {
+        p.counters[k] += now[k] - lastCounters[k];
+        lastCounters[k] = now[k];
+    }
+    lastTime = time;
+}
+
+void PerfProfiler::enter(int phase)
+{
+    if (!running)
+        return;
+    charge();
+    ++report.phases[phase].calls;
+    stack.push_back(phase);
+}
+
+void PerfProfiler::leave()
+{
+    if (!running)
+        return;
+    charge();
+    if (stack.size() > 1)
+        stack.pop_back();
+}
+
+void printPerfReport(const PerfReport &report, long long ticks, long long vehicleUpdates)
+{
+    double n = (double)max(1LL, ticks);
+    double vehicles = (double)max(1LL, vehicleUpdates);
+    if (report.countersAvailable)
+    {
+        printf("hardware counters per phase over %lld ticks (user mode, nested phases excluded)\n", ticks);
+        printf("  %-14s %10s %6s %12s %12s %14s %12s\n", "phase", "us/tick", "IPC", "cycles/veh", "instr/veh",
+               "cache-miss/veh", "br-miss/veh");
+    }
+    else
+    {
+        printf("hardware counters unavailable: %s\n", report.unavailableReason.c_str());
+        printf("timers per phase over %lld ticks (nested phases excluded)\n", ticks);
+        printf("  %-14s %10s %10s\n", "phase", "us/tick", "share");
+    }
+
+    double total = 0;
+    for (const auto &p : report.phases)
+        total += p.seconds;
+    for (const auto &p : report.phases)
+    {
+        if (p.calls == 0 && p.seconds == 0)
+            continue;
+        if (report.countersAvailable)
+        {
+            const uint64_t *c = p.counters;
+            double ipc = c[PERF_CYCLES] > 0 ? (double)c[PERF_INSTRUCTIONS] / c[PERF_CYCLES] : 0;
+            printf("  %-14s %10.2f %6.2f %12.1f %12.1f %14.3f %12.3f\n", p.name, p.seconds * 1e6 / n, ipc,
+                   c[PERF_CYCLES] / vehicles, c[PERF_INSTRUCTIONS] / vehicles, c[PERF_CACHE_MISSES] / vehicles,
+                   c[PERF_BRANCH_MISSES] / vehicles);
+        }
+        else
+        {
+            printf("  %-14s %10.2f %9.1f%%\n", p.name, p.seconds * 1e6 / n, total > 0 ? 100 * p.seconds / total : 0);
+        }
+    }
+    if (report.countersAvailable)
+    {
+        for (int k = 0; k < PERF_COUNTER_KINDS; ++k)
+        {
+            static const char *names[PERF_COUNTER_KINDS] = {"cycles", "instructions", "cache misses", "branch misses"};
+            if (!report.supported[k])
+                printf("  (%s not supported on this CPU, shown as 0)\n", names[k]);
+        }
+    }
+}
@@ -0,0 +1,131 @@
+﻿#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdint>
+using namespace std;
+
+// 硬件性能计数器：在帧内各阶段（生成、前进、跟车、变道规划、轨迹预测、移除）前后读取
+// CPU周期、指令数、缓存未命中和分支预测失败次数，计算IPC和每辆车的未命中数，
+// 解释某个阶段“为什么”慢。Linux下用perf_event_open打开当前线程的计数器组（只统计用户态）；
+// 没有权限、容器中没有PMU或不在Linux上时自动退化为只计时，用法不变。
+//
+// 阶段用PERF_SCOPE按作用域标记，嵌套时内层的开销不计入外层（每个阶段只统计自身的部分）。
+// 只有用PerfProfilerScope绑定了剖析器的线程才会统计，其他线程的PERF_SCOPE只多一次线程局部读。
+
+const int PERF_MAX_PHASES = 32; // 阶段数上限，超出的阶段归到"other"
+
+// 计数器种类
+enum PerfCounterKind
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_KINDS
+};
+
+// 一个阶段的累计统计
+struct PerfPhaseStats
+{
+    const char *name;
+    long long calls;                       // 进入次数
+    double seconds;                        // 自身耗时（不含嵌套阶段）
+    uint64_t counters[PERF_COUNTER_KINDS]; // 自身的计数（不含嵌套阶段）
+};
+
+// 当前线程的一组计数器（以CPU周期为组长，同时启停、一次读出）
+struct PerfCounterGroup
+{
+    int fds[PERF_COUNTER_KINDS];
+    bool available[PERF_COUNTER_KINDS]; // 该计数器是否打开成功
+    int count = 0;                      // 打开成功的计数器数
+
+    PerfCounterGroup();
+    ~PerfCounterGroup();
+    PerfCounterGroup(const PerfCounterGroup &) = delete;
+    PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+
+    // 打开并启动计数器，周期计数器都打不开时返回false，reason为原因
+    bool open(string &reason);
+    void close();
+    // 读出当前值（未打开的计数器为0），失败时返回false
+    bool read(uint64_t values[PERF_COUNTER_KINDS]) const;
+};
+
+// 注册阶段，同名阶段返回同一个编号
+int registerPerfPhase(const char *name);
+
+// 一次剖析的结果
+struct PerfReport
+{
+    bool countersAvailable = false;          // 硬件计数器是否可用
+    string unavailableReason;                // 不可用的原因
+    bool supported[PERF_COUNTER_KINDS] = {}; // 各计数器是否打开成功（CPU可能不支持个别事件）
+    vector<PerfPhaseStats> phases;           // 按阶段编号排列，0为不在任何阶段内的部分
+};
+
+// 分阶段剖析器：计数器不可用时只计时
+struct PerfProfiler
+{
+    PerfCounterGroup group;
+    PerfReport report;
+    vector<int> stack;    // 当前嵌套的阶段
+    bool running = false; // start之后、stop之前
+    uint64_t lastCounters[PERF_COUNTER_KINDS];
+    chrono::steady_clock::time_point lastTime;
+
+    // 打开计数器（失败时退化为只计时）并清零统计
+    void start();
+    // 停止统计，计数器全程没有计数时（例如虚拟机没有PMU）标记为不可用
+    void stop();
+    // 进入/离开阶段：把上一个边界以来的开销记到当前最内层的阶段（不在统计期间时忽略）
+    void enter(int phase);
+    void leave();
+
+private:
+    void charge();
+};
+
+// 当前线程绑定的剖析器（nullptr表示不统计）
+PerfProfiler *&currentPerfProfiler();
+
+// 作用域内当前线程的PERF_SCOPE记到profiler
+struct PerfProfilerScope
+{
+    PerfProfiler *previous;
+
+    explicit PerfProfilerScope(PerfProfiler &profiler) : previous(currentPerfProfiler())
+    {
+        currentPerfProfiler() = &profiler;
+    }
+    ~PerfProfilerScope() { currentPerfProfiler() = previous; }
+};
+
+// 作用域阶段
+struct PerfScope
+{
+    PerfProfiler *profiler;
+
+    explicit PerfScope(int phase) : profiler(currentPerfProfiler())
+    {
+        if (profiler != nullptr)
+            profiler->enter(phase);
+    }
+    ~PerfScope()
+    {
+        if (profiler != nullptr)
+            profiler->leave();
+    }
+};
+
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+// 在当前作用域内把开销记到阶段name（阶段编号在第一次执行时注册）
+#define PERF_SCOPE(name)                                                              \
+    static const int PERF_CONCAT(perfPhase, __LINE__) = registerPerfPhase(name);      \
+    PerfScope PERF_CONCAT(perfScope, __LINE__)(PERF_CONCAT(perfPhase, __LINE__))
+
+// 输出各阶段的统计：每帧耗时，计数器可用时还有IPC和每辆车的周期、指令、未命中数
+void printPerfReport(const PerfReport &report, long long ticks, long long vehicleUpdates);
+
+#pragma once
@@ -0,0 +1,175 @@
+﻿#include <graphics.h>
+#include <conio.h>
+#include <Windows.h>
+#include <thread>
+#include <chrono>
+#include <cmath>
+
+#include "Pipeline.h"
+using namespace std;
+
+void runPipeline(const Bridge &bridge, Simulation &sim, const LodConfig &lodConfig, const PipelineOptions &options)
+{
+    atomic<bool> running(true);
+    SpscQueue<SimCommand, 64> commands;
+    SpscQueue<ViewCommand, 256> viewCommands;
+    TripleBuffer<Simulation> snapshots;
+    int laneCount = sim.laneCount;   // 车道数量
+    int laneHeight = sim.laneHeight; // 车道像素宽度
+    int worldWidth = sim.windowWidth, worldHeight = sim.windowHeight;
+
+    // 输入线程
+    thread input([&] {
+        bool dragging = false; // 右键拖动中
+        int dragX = 0, dragY = 0;
+        while (running.load())
+        {
+            if (_kbhit())
+            {
+                running.store(false);
+                break;
+            }
+            // 检查鼠标点击
+            while (MouseHit())
+            {
+                MOUSEMSG msg = GetMouseMsg();
+                // 检查点击是否在按钮区域
+                if (msg.uMsg == WM_LBUTTONDOWN && msg.x < 45)
+                {
+                    // 计算点击所在的车道
+                    int clickedLane = msg.y / laneHeight;
+                    if (clickedLane >= 0 && clickedLane < laneCount)
+                    {
+                        commands.tryPush(SimCommand{SimCommandType::CLEAR_LANE, clickedLane}); // 队列满时丢弃这次点击
+                    }
+                }
+                else if (msg.uMsg == WM_MOUSEWHEEL)
+                {
+                    viewCommands.tryPush(ViewCommand{ViewCommandType::ZOOM, msg.x, msg.y, msg.wheel / 120});
+                }
+                else if (msg.uMsg == WM_RBUTTONDOWN)
+                {
+                    dragging = true;
+                    dragX = msg.x;
+                    dragY = msg.y;
+                }
+                else if (msg.uMsg == WM_RBUTTONUP)
+                {
+                    dragging = false;
+                }
+                else if (msg.uMsg == WM_MOUSEMOVE && dragging && msg.mkRButton)
+                {
+                    if (viewCommands.tryPush(ViewCommand{ViewCommandType::PAN, msg.x - dragX, msg.y - dragY, 0}))
+                    {
+                        dragX = msg.x; // 队列满时保留起点，下次一起移动
+                        dragY = msg.y;
+                    }
+                }
+                else if (msg.uMsg == WM_MBUTTONDOWN)
+                {
+                    viewCommands.tryPush(ViewCommand{ViewCommandType::RESET, 0, 0, 0});
+                }
+            }
+            this_thread::sleep_for(chrono::milliseconds(options.pollMilliseconds));
+        }
+    });
+
+    // 仿真线程：只在自己的节拍上等待，从不等待绘制
+    thread simulation([&] {
+        auto next = chrono::steady_clock::now();
+        while (running.load())
+        {
+            SimCommand command;
+            while (commands.tryPop(command))
+            {
+                if (command.type == SimCommandType::CLEAR_LANE)
+                {
+                    clearLane(sim.vehicles, command.lane); // 清除该车道上的所有车辆
+                }
+            }
+
+            // 推进一帧仿真：生成新车、更新位置、移除离开车辆
+            sim.step();
+            snapshots.writeBuffer() = sim; // 复制到后台缓冲区（复用已分配的vector容量）
+            snapshots.publish();
+            if (options.publisher != nullptr)
+            {
+                options.publisher->publish(sim); // 只写共享内存，不等待读取进程
+            }
+
+            next += chrono::milliseconds(options.tickMilliseconds);
+            auto now = chrono::steady_clock::now();
+            if (next < now)
+                next = now; // 落后时不追帧
+            this_thread::sleep_until(next);
+        }
+    });
+
+    // 绘制线程：有新快照或视图变化才重绘，批量绘制避免闪烁
+    RasterCanvas canvas; // 软件光栅化或批量提交时记录一帧的图元
+    RenderBatcher batcher;
+    SceneView view;
+    view.camera.fit(worldWidth, worldHeight, worldWidth, worldHeight);
+    FrameGovernor governor(options.governor);
+    bool hasFrame = false;
+    BeginBatchDraw();
+    while (running.load())
+    {
+        bool viewChanged = false;
+        ViewCommand viewCommand;
+        while (viewCommands.tryPop(viewCommand))
+        {
+            if (viewCommand.type == ViewCommandType::ZOOM)
+                view.camera.zoomAt(viewCommand.x, viewCommand.y, pow(1.25, viewCommand.amount)); // 每格放大1.25倍
+            else if (viewCommand.type == ViewCommandType::PAN)
+                view.camera.pan(viewCommand.x, viewCommand.y);
+            else
+                view.camera.fit(worldWidth, worldHeight, worldWidth, worldHeight);
+            viewChanged = true;
+        }
+
+        // 降低绘制频率时跳过部分新快照（视图变化总是立即重绘）
+        bool newFrame = snapshots.update() && governor.shouldDraw();
+        hasFrame = hasFrame || newFrame;
+        if (hasFrame && (newFrame || viewChanged))
+        {
+            auto start = chrono::steady_clock::now();
+            const Simulation &frame = snapshots.readBuffer();
+            LodConfig quality = governor.apply(lodConfig);
+            view.qualityLabel = governor.level == QualityLevel::FULL ? nullptr : qualityLevelName(governor.level);
+            if (options.renderer != nullptr)
+            {
+                canvas.reset(frame.windowWidth, frame.windowHeight);
+                {
+                    RasterCanvasScope scope(canvas);
+                    drawScene(bridge, frame, quality, view);
+                }
+                options.renderer->render(canvas, (uint32_t *)GetImageBuffer(), frame.windowWidth);
+            }
+            else if (options.batched)
+            {
+                canvas.reset(frame.windowWidth, frame.windowHeight);
+                {
+                    RasterCanvasScope scope(canvas);
+                    drawScene(bridge, frame, quality, view);
+                }
+                batcher.build(canvas);
+                batcher.submit(canvas);
+            }
+            else
+            {
+                drawScene(bridge, frame, quality, view);
+            }
+            FlushBatchDraw();
+            governor.record(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        }
+        else
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+    EndBatchDraw();
+
+    input.join();
+    simulation.join();
+}
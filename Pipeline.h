@@ -0,0 +1,124 @@
+﻿#include <atomic>
+#include <cstdint>
+#include "Class.h"
+#include "Simulation.h"
+#include "LiveState.h"
+#include "SoftRaster.h"
+#include "Scene.h"
+#include "FrameGovernor.h"
+#include "RenderBatch.h"
+using namespace std;
+
+// 单生产者单消费者无锁环形队列：生产者只写head，消费者只写tail，Capacity必须是2的幂
+template <class T, uint32_t Capacity>
+struct SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "队列容量必须是2的幂");
+
+    alignas(64) atomic<uint32_t> head;
+    alignas(64) atomic<uint32_t> tail;
+    T slots[Capacity];
+
+    SpscQueue() : head(0), tail(0) {}
+
+    bool tryPush(const T &item)
+    {
+        uint32_t h = head.load(memory_order_relaxed);
+        if (h - tail.load(memory_order_acquire) >= Capacity)
+            return false;
+        slots[h % Capacity] = item;
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &item)
+    {
+        uint32_t t = tail.load(memory_order_relaxed);
+        if (t == head.load(memory_order_acquire))
+            return false;
+        item = slots[t % Capacity];
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+};
+
+// 三缓冲：写者总在自己的后台缓冲区写入，完成后与中间缓冲区交换；
+// 读者需要时把中间缓冲区换到前台。双方都不等待对方，读者总能拿到最新完成的一份
+template <class T>
+struct TripleBuffer
+{
+    static const int FRESH = 4; // 中间缓冲区包含读者尚未取走的新数据
+
+    T slots[3];
+    atomic<int> middle; // 低两位为中间缓冲区下标，FRESH位表示有新数据
+    int back;           // 写者私有
+    int front;          // 读者私有
+
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    // 写者：当前可写的缓冲区
+    T &writeBuffer() { return slots[back]; }
+    // 写者：发布写好的缓冲区
+    void publish()
+    {
+        back = middle.exchange(back | FRESH, memory_order_acq_rel) & 3;
+    }
+    // 读者：有新数据时换到前台并返回true
+    bool update()
+    {
+        if (!(middle.load(memory_order_acquire) & FRESH))
+            return false;
+        front = middle.exchange(front, memory_order_acq_rel) & 3;
+        return true;
+    }
+    // 读者：前台缓冲区（最近一次update取到的数据）
+    const T &readBuffer() const { return slots[front]; }
+};
+
+// 输入线程发给仿真线程的命令
+enum class SimCommandType
+{
+    CLEAR_LANE // 清除指定车道的所有车辆
+};
+
+struct SimCommand
+{
+    SimCommandType type;
+    int lane;
+};
+
+// 输入线程发给绘制线程的视图命令
+enum class ViewCommandType
+{
+    ZOOM,  // 以(x, y)为中心缩放，amount为滚轮刻度（正数放大）
+    PAN,   // 视口跟随拖动移动(x, y)屏幕像素
+    RESET  // 恢复显示整座桥
+};
+
+struct ViewCommand
+{
+    ViewCommandType type;
+    int x, y;
+    int amount;
+};
+
+// 交互运行选项
+struct PipelineOptions
+{
+    int tickMilliseconds = 60; // 仿真线程每帧的间隔（与原界面Sleep(60)相同）
+    int pollMilliseconds = 5;  // 输入线程轮询鼠标和键盘的间隔
+    LiveStatePublisher *publisher = nullptr; // 不为空时仿真线程每帧把状态发布到共享内存（见LiveState.h）
+    TileRenderer *renderer = nullptr;        // 不为空时绘制线程用分块软件光栅化画每一帧（见SoftRaster.h）
+    GovernorConfig governor;                 // 绘制帧时间预算：超出时依次放弃轨迹、标签、车身细节，最后降低绘制频率
+    bool batched = true;                     // 不用软件光栅化时，先记录一帧再按绘图状态分组提交给EasyX（见RenderBatch.h）
+};
+
+// 交互运行：输入、仿真、绘制分别在三个线程中进行
+// 输入线程轮询鼠标和键盘，把清除车道命令放入无锁队列，按键时结束运行；
+// 滚轮缩放、右键拖动平移、中键恢复整桥视图，这些视图命令经另一个队列交给绘制线程；
+// 仿真线程按固定间隔执行命令并推进一帧，把状态快照写入三缓冲；
+// 绘制线程（调用线程，即创建窗口的线程）只绘制最新完成的一帧，视图变化时重绘同一帧，绘制慢不会拖慢仿真；
+// 绘制耗时超出预算时由FrameGovernor降低画质，负载下降后恢复，当前等级显示在右上角
+void runPipeline(const Bridge &bridge, Simulation &sim, const LodConfig &lodConfig, const PipelineOptions &options = PipelineOptions());
+
+#pragma once
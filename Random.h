@@ -1,7 +1,36 @@
 ﻿#include <random>
 #include <functional>
+#include <cstdint>
+#include <cstdlib>
 using namespace std;
 
+// 仿真专用随机数引擎（SplitMix64）：状态只有8字节，便于检查点精确保存和恢复
+// 满足标准库UniformRandomBitGenerator要求，可直接用于各种分布
+struct SimRandom
+{
+    typedef uint64_t result_type;
+    uint64_t state;
+
+    explicit SimRandom(uint64_t seed = 0) : state(seed) {}
+
+    static constexpr result_type (min)() { return 0; }
+    static constexpr result_type (max)() { return UINT64_MAX; }
+
+    result_type operator()()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // 跳过n个随机数（SplitMix64的状态按固定步长递增，可以直接跳过）
+    void discard(unsigned long long n)
+    {
+        state += n * 0x9E3779B97F4A7C15ULL;
+    }
+};
+
 class RandomGenerator
 {
 private:
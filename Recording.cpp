@@ -0,0 +1,366 @@
+﻿#include <algorithm>
+#include <cstring>
+
+#include "Recording.h"
+using namespace std;
+
+namespace
+{
+    const char *eventNames[RECORDED_EVENT_KINDS] = {"enter", "exit", "lanechange", "crash", "nearmiss"};
+
+    // 按id在车辆列表中查找（Simulation中的车辆按id递增排列）
+    const Vehicle *findById(const vector<Vehicle> &vehicles, int id)
+    {
+        auto it = lower_bound(vehicles.begin(), vehicles.end(), id,
+                              [](const Vehicle &v, int value) { return v.id < value; });
+        return it != vehicles.end() && it->id == id ? &*it : nullptr;
+    }
+
+    template <typename T>
+    void writeTable(ofstream &out, const vector<T> &table)
+    {
+        out.write((const char *)table.data(), table.size() * sizeof(T));
+    }
+}
+
+const char *recordedEventName(RecordedEventKind kind)
+{
+    return eventNames[(int)kind];
+}
+
+bool parseRecordedEventKind(const string &name, RecordedEventKind &kind)
+{
+    for (int i = 0; i < RECORDED_EVENT_KINDS; ++i)
+    {
+        if (name == eventNames[i])
+        {
+            kind = (RecordedEventKind)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RunRecorder::open(const string &path, const Simulation &sim, uint32_t ticksPerChunk)
+{
+    data.open(path, ios::binary);
+    if (!data)
+        return false;
+    indexPath = path + ".idx";
+
+    header = {};
+    header.magic = RECORDING_MAGIC;
+    header.version = RECORDING_VERSION;
+    header.vehicleSize = sizeof(LiveVehicle);
+    header.ticksPerChunk = max(1u, ticksPerChunk);
+    header.windowWidth = sim.windowWidth;
+    header.windowHeight = sim.windowHeight;
+    header.laneCount = sim.laneCount;
+    header.laneHeight = sim.laneHeight;
+    data.write((const char *)&header, sizeof(header));
+    offset = sizeof(header);
+
+    chunkOpen = false;
+    chunkFrames = 0;
+    chunks.clear();
+    postings.clear();
+    for (auto &list : events)
+        list.clear();
+    previous = sim.vehicles;
+    return true;
+}
+
+void RunRecorder::addEvent(RecordedEventKind kind, long long tick, double time, const Vehicle &v)
+{
+    RecordedEvent e = {};
+    e.time = time;
+    e.tick = tick;
+    e.vehicleId = v.id;
+    e.x = v.x;
+    e.lane = (int16_t)v.lane;
+    e.speed = (int16_t)v.speed;
+    e.kind = (uint8_t)kind;
+    events[(int)kind].push_back(e);
+}
+
+void RunRecorder::record(const Simulation &sim)
+{
+    if (!data.is_open())
+        return;
+    // Simulation::step之后tick已加1，本帧记为tick-1
+    long long tick = sim.tick - 1;
+
+    if (!chunkOpen)
+    {
+        chunk = {};
+        chunk.firstTick = tick;
+        chunk.firstTime = sim.time;
+        chunk.offset = offset;
+        chunkOpen = true;
+        chunkFrames = 0;
+    }
+    uint32_t chunkIndex = (uint32_t)chunks.size();
+
+    // 写入一帧
+    RecordedFrame frame = {tick, sim.time, (uint32_t)sim.vehicles.size(), 0};
+    size_t bytes = sizeof(RecordedFrame) + sim.vehicles.size() * sizeof(LiveVehicle);
+    buffer.resize(bytes);
+    memcpy(buffer.data(), &frame, sizeof(frame));
+    LiveVehicle *out = (LiveVehicle *)(buffer.data() + sizeof(frame));
+    for (size_t i = 0; i < sim.vehicles.size(); ++i)
+    {
+        const Vehicle &v = sim.vehicles[i];
+        out[i] = toLiveVehicle(v);
+        Postings &p = postings[v.id];
+        if (p.chunks.empty())
+            p.firstTick = tick;
+        if (p.chunks.empty() || p.chunks.back() != chunkIndex)
+            p.chunks.push_back(chunkIndex);
+        p.lastTick = tick;
+    }
+    data.write(buffer.data(), bytes);
+    offset += bytes;
+    chunk.lastTick = tick;
+    chunk.lastTime = sim.time;
+
+    // 与上一帧比较得到事件
+    traffic.clear();
+    recordTrafficEvents(previous, sim.vehicles, tick, traffic);
+    for (const TrafficEvent &e : traffic)
+    {
+        if (e.kind == TrafficEventKind::EXITED)
+        {
+            addEvent(RecordedEventKind::EXIT, tick, sim.time, *findById(previous, e.vehicleId));
+            continue;
+        }
+        RecordedEventKind kind;
+        if (e.kind == TrafficEventKind::ENTERED)
+            kind = RecordedEventKind::ENTER;
+        else if (e.kind == TrafficEventKind::CHANGED_LANE)
+            kind = RecordedEventKind::LANE_CHANGE;
+        else if (e.kind == TrafficEventKind::BROKE_DOWN)
+            kind = RecordedEventKind::CRASH;
+        else
+            continue;
+        addEvent(kind, tick, sim.time, *findById(sim.vehicles, e.vehicleId));
+    }
+    for (const Vehicle &v : sim.vehicles)
+    {
+        if (!v.isFlashing || v.isBrokenDown)
+            continue;
+        const Vehicle *before = findById(previous, v.id);
+        if (before == nullptr || !before->isFlashing)
+            addEvent(RecordedEventKind::NEAR_MISS, tick, sim.time, v);
+    }
+    previous = sim.vehicles;
+
+    ++header.frameCount;
+    if (++chunkFrames == header.ticksPerChunk)
+        finishChunk();
+}
+
+void RunRecorder::finishChunk()
+{
+    if (!chunkOpen)
+        return;
+    chunk.length = offset - chunk.offset;
+    chunks.push_back(chunk);
+    chunkOpen = false;
+}
+
+bool RunRecorder::close()
+{
+    if (!data.is_open())
+        return false;
+    finishChunk();
+    data.seekp(0);
+    data.write((const char *)&header, sizeof(header));
+    data.close();
+    bool ok = !data.fail();
+
+    // 车辆目录按id排序，倒排表按目录顺序拼接
+    vector<int> ids;
+    ids.reserve(postings.size());
+    for (const auto &entry : postings)
+        ids.push_back(entry.first);
+    sort(ids.begin(), ids.end());
+    vector<IndexVehicle> directory;
+    vector<uint32_t> postingList;
+    directory.reserve(ids.size());
+    for (int id : ids)
+    {
+        const Postings &p = postings[id];
+        directory.push_back({id, (uint32_t)p.chunks.size(), (uint64_t)postingList.size(), p.firstTick, p.lastTick});
+        postingList.insert(postingList.end(), p.chunks.begin(), p.chunks.end());
+    }
+
+    IndexHeader index = {};
+    index.magic = RECORDING_INDEX_MAGIC;
+    index.version = RECORDING_VERSION;
+    index.eventKinds = RECORDED_EVENT_KINDS;
+    index.chunkCount = chunks.size();
+    index.vehicleCount = directory.size();
+    index.postingCount = postingList.size();
+    // 各表按8字节对齐依次排列
+    uint64_t position = sizeof(IndexHeader);
+    index.chunkOffset = position;
+    position += chunks.size() * sizeof(IndexChunk);
+    index.vehicleOffset = position;
+    position += directory.size() * sizeof(IndexVehicle);
+    index.postingOffset = position;
+    position += (postingList.size() * sizeof(uint32_t) + 7) / 8 * 8;
+    for (int k = 0; k < RECORDED_EVENT_KINDS; ++k)
+    {
+        index.eventCount[k] = events[k].size();
+        index.eventOffset[k] = position;
+        position += events[k].size() * sizeof(RecordedEvent);
+    }
+
+    ofstream out(indexPath, ios::binary);
+    out.write((const char *)&index, sizeof(index));
+    writeTable(out, chunks);
+    writeTable(out, directory);
+    writeTable(out, postingList);
+    if (postingList.size() % 2 != 0)
+    {
+        uint32_t padding = 0;
+        out.write((const char *)&padding, sizeof(padding));
+    }
+    for (const auto &list : events)
+        writeTable(out, list);
+    out.close();
+    ok = !out.fail() && ok;
+
+    chunks.clear();
+    postings.clear();
+    for (auto &list : events)
+        list.clear();
+    previous.clear();
+    return ok;
+}
+
+bool RunIndex::open(const string &indexPath, string &error)
+{
+    MappedFile::unmap(view);
+    header = nullptr;
+    if (!file.open(indexPath))
+    {
+        error = "cannot open " + indexPath;
+        return false;
+    }
+    if (file.size < sizeof(IndexHeader) || !file.map(0, (size_t)file.size, view))
+    {
+        error = indexPath + ": not a recording index";
+        return false;
+    }
+    const IndexHeader *h = (const IndexHeader *)view.data;
+    uint64_t end = h->eventOffset[RECORDED_EVENT_KINDS - 1] +
+                   h->eventCount[RECORDED_EVENT_KINDS - 1] * sizeof(RecordedEvent);
+    if (h->magic != RECORDING_INDEX_MAGIC || h->version != RECORDING_VERSION ||
+        h->eventKinds != RECORDED_EVENT_KINDS || end > file.size)
+    {
+        error = indexPath + ": not a recording index or truncated";
+        MappedFile::unmap(view);
+        return false;
+    }
+    header = h;
+    return true;
+}
+
+vector<RecordedEvent> RunIndex::findEvents(RecordedEventKind kind, double t0, double t1, int lane) const
+{
+    const RecordedEvent *begin = events(kind);
+    const RecordedEvent *end = begin + header->eventCount[(int)kind];
+    const RecordedEvent *first =
+        lower_bound(begin, end, t0, [](const RecordedEvent &e, double t) { return e.time < t; });
+    vector<RecordedEvent> result;
+    for (const RecordedEvent *e = first; e != end && e->time <= t1; ++e)
+    {
+        if (lane < 0 || e->lane == lane)
+            result.push_back(*e);
+    }
+    return result;
+}
+
+const IndexVehicle *RunIndex::findVehicle(int vehicleId) const
+{
+    const IndexVehicle *begin = vehicles();
+    const IndexVehicle *end = begin + header->vehicleCount;
+    const IndexVehicle *it =
+        lower_bound(begin, end, vehicleId, [](const IndexVehicle &v, int id) { return v.vehicleId < id; });
+    return it != end && it->vehicleId == vehicleId ? it : nullptr;
+}
+
+void RunIndex::chunksInTime(double t0, double t1, uint64_t &first, uint64_t &last) const
+{
+    const IndexChunk *begin = chunks();
+    const IndexChunk *end = begin + header->chunkCount;
+    first = lower_bound(begin, end, t0, [](const IndexChunk &c, double t) { return c.lastTime < t; }) - begin;
+    last = upper_bound(begin, end, t1, [](double t, const IndexChunk &c) { return t < c.firstTime; }) - begin;
+    last = max(first, last);
+}
+
+bool RunReader::open(const string &path, string &error)
+{
+    if (!file.open(path))
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    MappedView view;
+    if (file.size < sizeof(RecordingHeader) || !file.map(0, sizeof(RecordingHeader), view))
+    {
+        error = path + ": not a recording";
+        return false;
+    }
+    memcpy(&header, view.data, sizeof(header));
+    MappedFile::unmap(view);
+    if (header.magic != RECORDING_MAGIC || header.version != RECORDING_VERSION ||
+        header.vehicleSize != sizeof(LiveVehicle))
+    {
+        error = path + ": not a recording";
+        return false;
+    }
+    if (!index.open(path + ".idx", error))
+        return false;
+    const IndexChunk *chunks = index.chunks();
+    uint64_t chunkCount = index.header->chunkCount;
+    if (chunkCount > 0 && chunks[chunkCount - 1].offset + chunks[chunkCount - 1].length > file.size)
+    {
+        error = path + ": recording is shorter than its index";
+        return false;
+    }
+    return true;
+}
+
+const uint8_t *RunReader::mapRange(uint64_t offset, uint64_t length, MappedView &view) const
+{
+    // 映射起点向下对齐到映射粒度
+    uint64_t start = offset / MappedFile::granularity() * MappedFile::granularity();
+    if (length == 0 || !file.map(start, (size_t)(offset - start + length), view))
+        return nullptr;
+    return view.data + (offset - start);
+}
+
+vector<VehicleSample> RunReader::vehicleHistory(int vehicleId) const
+{
+    vector<VehicleSample> samples;
+    const IndexVehicle *entry = index.findVehicle(vehicleId);
+    if (entry == nullptr)
+        return samples;
+    samples.reserve((size_t)(entry->lastTick - entry->firstTick + 1));
+    const uint32_t *posting = index.postings() + entry->firstPosting;
+    for (uint32_t i = 0; i < entry->postingCount; ++i)
+    {
+        forEachFrame(index.chunks()[posting[i]], [&](const RecordedFrame &frame, const LiveVehicle *vehicles)
+        {
+            // 帧内车辆按id递增排列
+            const LiveVehicle *end = vehicles + frame.count;
+            const LiveVehicle *it = lower_bound(vehicles, end, vehicleId,
+                                                [](const LiveVehicle &v, int id) { return v.id < id; });
+            if (it != end && it->id == vehicleId)
+                samples.push_back({frame.tick, frame.time, *it});
+        });
+    }
+    return samples;
+}
@@ -0,0 +1,225 @@
+﻿#include <vector>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+#include "MappedFile.h"
+#include "LiveState.h"
+#include "Simulation.h"
+#include "EventEngine.h"
+using namespace std;
+
+// 运行记录：逐帧保存桥上所有车辆的紧凑状态（LiveVehicle），同时在内存中建立索引，
+// 结束时写入旁路索引文件（记录文件名 + ".idx"）。查询只映射索引和需要的数据块，
+// 多GB的记录也能在毫秒级回答"某段时间的帧""某辆车的轨迹""某类事件"。
+//
+// 记录文件格式（小端）：48字节文件头 + 连续的帧，每帧为RecordedFrame + count个LiveVehicle（按id递增）。
+// 每ticksPerChunk帧为一个数据块，索引按数据块定位。
+//
+// 索引文件格式：IndexHeader + 数据块表 + 车辆目录（按id递增）+ 车辆的数据块倒排表 + 各类事件（按帧号递增）
+
+const uint32_t RECORDING_MAGIC = 0x43455243;       // "CREC"
+const uint32_t RECORDING_INDEX_MAGIC = 0x58444943; // "CIDX"
+const uint32_t RECORDING_VERSION = 1;
+
+struct RecordingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vehicleSize;   // sizeof(LiveVehicle)
+    uint32_t ticksPerChunk; // 每个数据块的帧数
+    int32_t windowWidth, windowHeight;
+    int32_t laneCount, laneHeight;
+    int64_t frameCount;     // 帧数（close时写入）
+    uint64_t reserved;
+};
+
+// 帧头，后面紧跟count个LiveVehicle
+struct RecordedFrame
+{
+    int64_t tick;
+    double time;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+// 索引中的事件类型
+enum class RecordedEventKind : uint8_t
+{
+    ENTER,       // 进入桥面
+    EXIT,        // 驶离桥面
+    LANE_CHANGE, // 完成变道（lane为新车道）
+    CRASH,       // 抛锚（碰撞）
+    NEAR_MISS,   // 开始与前车距离过近（isFlashing的上升沿）
+    COUNT
+};
+
+const int RECORDED_EVENT_KINDS = (int)RecordedEventKind::COUNT;
+
+struct RecordedEvent
+{
+    double time;
+    int64_t tick;
+    int32_t vehicleId;
+    int32_t x;        // 事件发生时的位置（像素）
+    int16_t lane;
+    int16_t speed;    // 像素/帧
+    uint8_t kind;     // RecordedEventKind
+    uint8_t reserved[3];
+};
+
+// 一个数据块在记录文件中的位置
+struct IndexChunk
+{
+    int64_t firstTick, lastTick;
+    double firstTime, lastTime;
+    uint64_t offset; // 第一帧在记录文件中的偏移
+    uint64_t length; // 字节数
+};
+
+// 车辆目录项：倒排表中[firstPosting, firstPosting + postingCount)是这辆车出现过的数据块序号
+struct IndexVehicle
+{
+    int32_t vehicleId;
+    uint32_t postingCount;
+    uint64_t firstPosting;
+    int64_t firstTick, lastTick;
+};
+
+struct IndexHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t eventKinds; // RECORDED_EVENT_KINDS
+    uint32_t reserved;
+    uint64_t chunkCount;
+    uint64_t vehicleCount;
+    uint64_t postingCount;
+    uint64_t chunkOffset;   // 以下偏移都相对索引文件开头
+    uint64_t vehicleOffset;
+    uint64_t postingOffset;
+    uint64_t eventCount[RECORDED_EVENT_KINDS];
+    uint64_t eventOffset[RECORDED_EVENT_KINDS];
+};
+
+static_assert(sizeof(RecordingHeader) == 48, "记录文件头必须是48字节");
+static_assert(sizeof(RecordedFrame) == 24, "帧头必须是24字节");
+static_assert(sizeof(RecordedEvent) == 32, "记录事件必须是32字节");
+static_assert(sizeof(IndexChunk) == 48, "数据块索引项必须是48字节");
+static_assert(sizeof(IndexVehicle) == 32, "车辆目录项必须是32字节");
+
+// 记录方：open一次，每次Simulation::step之后record，结束时close写入索引
+struct RunRecorder
+{
+    ofstream data;
+    string indexPath;
+    RecordingHeader header;
+    uint64_t offset = 0;    // 已写入记录文件的字节数
+    bool chunkOpen = false; // 当前数据块是否已有帧
+    uint32_t chunkFrames = 0;
+    IndexChunk chunk;
+    vector<IndexChunk> chunks;
+
+    // 每辆车出现过的数据块（按时间先后，不重复）
+    struct Postings
+    {
+        vector<uint32_t> chunks;
+        int64_t firstTick, lastTick;
+    };
+    unordered_map<int, Postings> postings;
+    vector<RecordedEvent> events[RECORDED_EVENT_KINDS];
+
+    vector<Vehicle> previous;        // 上一帧的车辆，用于检测事件
+    vector<TrafficEvent> traffic;    // 复用的事件缓冲
+    vector<char> buffer;             // 一帧的写入缓冲
+
+    ~RunRecorder() { close(); }
+
+    // 创建记录文件，ticksPerChunk为每个数据块的帧数
+    bool open(const string &path, const Simulation &sim, uint32_t ticksPerChunk = 64);
+    // 记录一帧（在Simulation::step之后调用）
+    void record(const Simulation &sim);
+    // 写完记录文件头并写入索引文件
+    bool close();
+
+    void finishChunk();
+    void addEvent(RecordedEventKind kind, long long tick, double time, const Vehicle &v);
+};
+
+// 索引：整个索引文件只读映射，各表直接指向映射内存
+struct RunIndex
+{
+    MappedFile file;
+    MappedView view;
+    const IndexHeader *header = nullptr;
+
+    ~RunIndex() { MappedFile::unmap(view); }
+
+    bool open(const string &indexPath, string &error);
+
+    const IndexChunk *chunks() const { return (const IndexChunk *)(view.data + header->chunkOffset); }
+    const IndexVehicle *vehicles() const { return (const IndexVehicle *)(view.data + header->vehicleOffset); }
+    const uint32_t *postings() const { return (const uint32_t *)(view.data + header->postingOffset); }
+    const RecordedEvent *events(RecordedEventKind kind) const
+    {
+        return (const RecordedEvent *)(view.data + header->eventOffset[(int)kind]);
+    }
+
+    // 时间在[t0, t1]内的某类事件，lane不小于0时只返回该车道的
+    vector<RecordedEvent> findEvents(RecordedEventKind kind, double t0, double t1, int lane = -1) const;
+    // 车辆目录项，没有这辆车时返回nullptr
+    const IndexVehicle *findVehicle(int vehicleId) const;
+    // 与时间范围[t0, t1]相交的数据块[first, last)
+    void chunksInTime(double t0, double t1, uint64_t &first, uint64_t &last) const;
+};
+
+// 查询得到的一帧中一辆车的状态
+struct VehicleSample
+{
+    int64_t tick;
+    double time;
+    LiveVehicle state;
+};
+
+// 记录文件读取：只映射需要的数据块
+struct RunReader
+{
+    MappedFile file;
+    RecordingHeader header;
+    RunIndex index;
+
+    // 打开记录文件和它的索引
+    bool open(const string &path, string &error);
+
+    // 依次访问数据块中的帧：visitor(const RecordedFrame &, const LiveVehicle *)
+    template <typename Visitor>
+    bool forEachFrame(const IndexChunk &chunk, Visitor &&visitor) const
+    {
+        MappedView view;
+        const uint8_t *data = mapRange(chunk.offset, chunk.length, view);
+        if (data == nullptr)
+            return false;
+        const uint8_t *end = data + chunk.length;
+        while (data + sizeof(RecordedFrame) <= end)
+        {
+            const RecordedFrame *frame = (const RecordedFrame *)data;
+            const LiveVehicle *vehicles = (const LiveVehicle *)(frame + 1);
+            visitor(*frame, vehicles);
+            data += sizeof(RecordedFrame) + (size_t)frame->count * sizeof(LiveVehicle);
+        }
+        MappedFile::unmap(view);
+        return true;
+    }
+
+    // 映射记录文件中的[offset, offset + length)，返回offset处的地址（失败时返回nullptr）
+    const uint8_t *mapRange(uint64_t offset, uint64_t length, MappedView &view) const;
+
+    // 一辆车的完整轨迹（只读取倒排表中的数据块）
+    vector<VehicleSample> vehicleHistory(int vehicleId) const;
+};
+
+// 事件类型名称（enter/exit/lanechange/crash/nearmiss）与解析
+const char *recordedEventName(RecordedEventKind kind);
+bool parseRecordedEventKind(const string &name, RecordedEventKind &kind);
+
+#pragma once
@@ -0,0 +1,233 @@
+﻿#ifndef CAR_SIM_HEADLESS
+#include <graphics.h>
+#endif
+#include <cwchar>
+#include <cmath>
+
+#include "Render.h"
+using namespace std;
+
+void RasterCanvas::reset(int canvasWidth, int canvasHeight)
+{
+    width = canvasWidth;
+    height = canvasHeight;
+    clear();
+    fillColor = lineColor = textColor = WHITE;
+    lineStyle = PS_SOLID;
+    lineThickness = 1;
+    textHeight = 16;
+    stateCalls = 0;
+}
+
+void RasterCanvas::clear()
+{
+    commands.clear();
+    text.clear();
+}
+
+void RasterCanvas::addShape(int left, int top, int right, int bottom, int rx, int ry, bool fill, bool outline, uint8_t extraFlags)
+{
+    RasterCommand c = {};
+    c.op = RasterOp::SHAPE;
+    c.flags = (uint8_t)((fill ? RASTER_FILL : 0) | (outline ? RASTER_OUTLINE : 0) | extraFlags);
+    c.thickness = (int16_t)max(1, lineThickness);
+    c.x0 = min(left, right);
+    c.y0 = min(top, bottom);
+    c.x1 = max(left, right);
+    c.y1 = max(top, bottom);
+    c.rx = max(0, rx);
+    c.ry = max(0, ry);
+    c.fill = colorToPixel(fillColor);
+    c.line = colorToPixel(lineColor);
+    commands.push_back(c);
+}
+
+void RasterCanvas::addLine(int x0, int y0, int x1, int y1)
+{
+    RasterCommand c = {};
+    c.op = RasterOp::LINE;
+    c.flags = lineStyle == PS_DASH ? RASTER_DASHED : 0;
+    c.thickness = (int16_t)max(1, lineThickness);
+    c.x0 = x0;
+    c.y0 = y0;
+    c.x1 = x1;
+    c.y1 = y1;
+    c.line = colorToPixel(lineColor);
+    commands.push_back(c);
+}
+
+void RasterCanvas::addText(int x, int y, const wchar_t *str)
+{
+    RasterCommand c = {};
+    c.op = RasterOp::TEXT;
+    c.x0 = x;
+    c.y0 = y;
+    c.rx = textHeight;
+    c.line = colorToPixel(textColor);
+    c.textOffset = (uint32_t)text.size();
+    for (const wchar_t *p = str; *p != 0; ++p)
+        text.push_back(*p);
+    c.textLength = (uint32_t)(text.size() - c.textOffset);
+    commands.push_back(c);
+}
+
+RasterCanvas *&currentRasterCanvas()
+{
+    thread_local RasterCanvas *canvas = nullptr;
+    return canvas;
+}
+
+RenderTransform &currentRenderTransform()
+{
+    thread_local RenderTransform transform;
+    return transform;
+}
+
+namespace
+{
+    // 世界坐标换算为屏幕坐标（四舍五入，恒等变换时不改变坐标）
+    inline int screenX(int x)
+    {
+        const RenderTransform &t = currentRenderTransform();
+        return (int)floor((x - t.originX) * t.zoom + 0.5);
+    }
+
+    inline int screenY(int y)
+    {
+        const RenderTransform &t = currentRenderTransform();
+        return (int)floor((y - t.originY) * t.zoom + 0.5);
+    }
+
+    inline int screenLength(int length)
+    {
+        return (int)floor(length * currentRenderTransform().zoom + 0.5);
+    }
+}
+
+// 绑定了画布时记录命令，否则调用EasyX（无界面构建中忽略）
+#ifndef CAR_SIM_HEADLESS
+#define RENDER_DISPATCH(recorded, easyx) \
+    if (RasterCanvas *canvas = currentRasterCanvas()) \
+    {                                                \
+        recorded;                                    \
+    }                                                \
+    else                                             \
+    {                                                \
+        easyx;                                       \
+    }
+#else
+#define RENDER_DISPATCH(recorded, easyx)             \
+    if (RasterCanvas *canvas = currentRasterCanvas()) \
+    {                                                \
+        recorded;                                    \
+    }
+#endif
+
+namespace render
+{
+    void cleardevice()
+    {
+        RENDER_DISPATCH(canvas->clear(), ::cleardevice());
+    }
+
+    void setfillcolor(COLORREF color)
+    {
+        RENDER_DISPATCH((canvas->fillColor = color, ++canvas->stateCalls), ::setfillcolor(color));
+    }
+
+    void setlinecolor(COLORREF color)
+    {
+        RENDER_DISPATCH((canvas->lineColor = color, ++canvas->stateCalls), ::setlinecolor(color));
+    }
+
+    COLORREF getlinecolor()
+    {
+        RENDER_DISPATCH(return canvas->lineColor, return ::getlinecolor());
+        return WHITE;
+    }
+
+    void setlinestyle(int style, int thickness)
+    {
+        RENDER_DISPATCH((canvas->lineStyle = style, canvas->lineThickness = thickness, ++canvas->stateCalls),
+                        ::setlinestyle(style, thickness));
+    }
+
+    void getlinestyle(int &style, int &thickness)
+    {
+        style = PS_SOLID;
+        thickness = 1;
+#ifndef CAR_SIM_HEADLESS
+        LINESTYLE current;
+#endif
+        RENDER_DISPATCH((style = canvas->lineStyle, thickness = canvas->lineThickness),
+                        (::getlinestyle(&current), style = current.style, thickness = current.thickness));
+    }
+
+    void settextcolor(COLORREF color)
+    {
+        RENDER_DISPATCH((canvas->textColor = color, ++canvas->stateCalls), ::settextcolor(color));
+    }
+
+    void settextstyle(int height, int width, const wchar_t *face)
+    {
+        // 画布只记录字高（文字按字高估算大小）
+        (void)width, (void)face; // 无界面构建中不使用
+        RENDER_DISPATCH((canvas->textHeight = height, ++canvas->stateCalls), ::settextstyle(height, width, face));
+    }
+
+    void setbkmode(int mode)
+    {
+        // 画布上的文字总是透明背景，只统计调用次数
+        (void)mode; // 无界面构建中不使用
+        RENDER_DISPATCH(++canvas->stateCalls, ::setbkmode(mode));
+    }
+
+    void fillrectangle(int left, int top, int right, int bottom)
+    {
+        left = screenX(left), top = screenY(top), right = screenX(right), bottom = screenY(bottom);
+        RENDER_DISPATCH(canvas->addShape(left, top, right, bottom, 0, 0, true, true),
+                        ::fillrectangle(left, top, right, bottom));
+    }
+
+    void solidrectangle(int left, int top, int right, int bottom)
+    {
+        left = screenX(left), top = screenY(top), right = screenX(right), bottom = screenY(bottom);
+        RENDER_DISPATCH(canvas->addShape(left, top, right, bottom, 0, 0, true, false),
+                        ::solidrectangle(left, top, right, bottom));
+    }
+
+    void rectangle(int left, int top, int right, int bottom)
+    {
+        left = screenX(left), top = screenY(top), right = screenX(right), bottom = screenY(bottom);
+        RENDER_DISPATCH(canvas->addShape(left, top, right, bottom, 0, 0, false, true),
+                        ::rectangle(left, top, right, bottom));
+    }
+
+    void fillroundrect(int left, int top, int right, int bottom, int ellipseWidth, int ellipseHeight)
+    {
+        left = screenX(left), top = screenY(top), right = screenX(right), bottom = screenY(bottom);
+        ellipseWidth = screenLength(ellipseWidth), ellipseHeight = screenLength(ellipseHeight);
+        uint8_t odd = (uint8_t)((ellipseWidth % 2 ? RASTER_ODD_WIDTH : 0) | (ellipseHeight % 2 ? RASTER_ODD_HEIGHT : 0));
+        RENDER_DISPATCH(canvas->addShape(left, top, right, bottom, ellipseWidth / 2, ellipseHeight / 2, true, true, odd),
+                        ::fillroundrect(left, top, right, bottom, ellipseWidth, ellipseHeight));
+    }
+
+    void fillcircle(int x, int y, int radius)
+    {
+        x = screenX(x), y = screenY(y), radius = screenLength(radius);
+        RENDER_DISPATCH(canvas->addShape(x - radius, y - radius, x + radius, y + radius, radius, radius, true, true, RASTER_CIRCLE),
+                        ::fillcircle(x, y, radius));
+    }
+
+    void line(int x1, int y1, int x2, int y2)
+    {
+        x1 = screenX(x1), y1 = screenY(y1), x2 = screenX(x2), y2 = screenY(y2);
+        RENDER_DISPATCH(canvas->addLine(x1, y1, x2, y2), ::line(x1, y1, x2, y2));
+    }
+
+    void outtextxy(int x, int y, const wchar_t *str)
+    {
+        x = screenX(x), y = screenY(y);
+        RENDER_DISPATCH(canvas->addText(x, y, str), ::outtextxy(x, y, str));
+    }
+}
@@ -0,0 +1,140 @@
+﻿#include <vector>
+#include <cstdint>
+#include "Class.h"
+using namespace std;
+
+// 绘图输出：车辆和场景的绘制代码只通过render::中的函数画图。
+// 默认画到EasyX的当前工作图像（与直接调用EasyX相同）；用RasterCanvasScope绑定一个RasterCanvas后，
+// 同样的调用改为记录成图元命令，由分块软件光栅化器在多个线程中画出（见SoftRaster.h）。
+// 无界面构建中没有EasyX，没有绑定画布时绘制调用什么也不做。
+
+#ifdef CAR_SIM_HEADLESS
+// 无界面构建：补上绘制代码用到的EasyX常量
+const int PS_SOLID = 0;
+const int PS_DASH = 1;
+const int TRANSPARENT = 1;
+const COLORREF BLACK = 0;
+const COLORREF BLUE = 0xAA0000;
+const COLORREF RED = 0x0000AA;
+const COLORREF WHITE = 0xFFFFFF;
+#endif
+
+// 图元类型
+enum class RasterOp : uint8_t
+{
+    SHAPE, // 矩形、圆角矩形、圆：可同时填充和描边
+    LINE,  // 线段（实线或虚线，可有线宽）
+    TEXT   // 字形位图
+};
+
+// 图元标志位
+const uint8_t RASTER_FILL = 1;    // SHAPE：填充
+const uint8_t RASTER_OUTLINE = 2; // SHAPE：描边
+const uint8_t RASTER_DASHED = 4;  // LINE：虚线
+const uint8_t RASTER_CIRCLE = 8;      // SHAPE：由fillcircle记录（rx为半径）
+const uint8_t RASTER_ODD_WIDTH = 16;  // SHAPE：fillroundrect的圆角宽度为奇数（rx为其一半向下取整）
+const uint8_t RASTER_ODD_HEIGHT = 32; // SHAPE：fillroundrect的圆角高度为奇数
+
+// 一条图元命令，坐标为像素（包含右、下边界）
+struct RasterCommand
+{
+    RasterOp op;
+    uint8_t flags;
+    int16_t thickness;      // 线宽
+    int32_t x0, y0, x1, y1; // SHAPE：外接矩形；LINE：两个端点；TEXT：左上角（x0, y0）
+    int32_t rx, ry;         // SHAPE：圆角的水平、垂直半径（圆为半径）；TEXT：字高、未使用
+    uint32_t fill;          // 填充颜色 0x00RRGGBB
+    uint32_t line;          // 描边/线段/文字颜色 0x00RRGGBB
+    uint32_t textOffset;    // TEXT：字符在RasterCanvas::text中的范围
+    uint32_t textLength;
+};
+
+// 记录一帧的图元命令和绘图状态（状态的含义与EasyX相同）
+struct RasterCanvas
+{
+    int width = 0, height = 0;
+    uint32_t background = 0;       // cleardevice的颜色 0x00RRGGBB
+    vector<RasterCommand> commands;
+    vector<wchar_t> text;          // 所有TEXT命令的字符
+
+    COLORREF fillColor = WHITE;
+    COLORREF lineColor = WHITE;
+    COLORREF textColor = WHITE;
+    int lineStyle = PS_SOLID;
+    int lineThickness = 1;
+    int textHeight = 16;
+    size_t stateCalls = 0;         // 本帧的状态设置调用数（直接画到EasyX时每次调用都切换一次状态）
+
+    // 开始新的一帧（保留已分配的容量）
+    void reset(int canvasWidth, int canvasHeight);
+    // 清空已记录的命令（cleardevice）
+    void clear();
+    // extraFlags为RASTER_CIRCLE等只用于提交给EasyX的标志（见RenderBatch.h）
+    void addShape(int left, int top, int right, int bottom, int rx, int ry, bool fill, bool outline, uint8_t extraFlags = 0);
+    void addLine(int x0, int y0, int x1, int y1);
+    void addText(int x, int y, const wchar_t *str);
+};
+
+// 当前线程绑定的画布（nullptr表示画到EasyX）
+RasterCanvas *&currentRasterCanvas();
+
+// 作用域内的绘制调用都记录到canvas中
+struct RasterCanvasScope
+{
+    RasterCanvas *previous;
+
+    explicit RasterCanvasScope(RasterCanvas &canvas) : previous(currentRasterCanvas()) { currentRasterCanvas() = &canvas; }
+    ~RasterCanvasScope() { currentRasterCanvas() = previous; }
+};
+
+// 世界坐标到屏幕坐标的变换：屏幕 = (世界 - origin) * zoom（见Viewport.h的Camera）。
+// 绘制函数的坐标和尺寸按当前线程的变换换算，线宽和字高保持屏幕像素不变
+struct RenderTransform
+{
+    double zoom = 1;
+    double originX = 0, originY = 0;
+};
+
+// 当前线程的变换（默认为恒等变换）
+RenderTransform &currentRenderTransform();
+
+// 作用域内的绘制调用使用transform
+struct RenderTransformScope
+{
+    RenderTransform previous;
+
+    explicit RenderTransformScope(const RenderTransform &transform) : previous(currentRenderTransform())
+    {
+        currentRenderTransform() = transform;
+    }
+    ~RenderTransformScope() { currentRenderTransform() = previous; }
+};
+
+// COLORREF（0x00BBGGRR）转换为像素格式0x00RRGGBB
+inline uint32_t colorToPixel(COLORREF c)
+{
+    return ((c & 0xFF) << 16) | (c & 0xFF00) | ((c >> 16) & 0xFF);
+}
+
+// 与EasyX同名同义的绘制函数
+namespace render
+{
+    void cleardevice();
+    void setfillcolor(COLORREF color);
+    void setlinecolor(COLORREF color);
+    COLORREF getlinecolor();
+    void setlinestyle(int style, int thickness = 1);
+    void getlinestyle(int &style, int &thickness);
+    void settextcolor(COLORREF color);
+    void settextstyle(int height, int width, const wchar_t *face);
+    void setbkmode(int mode);
+    void fillrectangle(int left, int top, int right, int bottom);
+    void solidrectangle(int left, int top, int right, int bottom);
+    void rectangle(int left, int top, int right, int bottom);
+    void fillroundrect(int left, int top, int right, int bottom, int ellipseWidth, int ellipseHeight);
+    void fillcircle(int x, int y, int radius);
+    void line(int x1, int y1, int x2, int y2);
+    void outtextxy(int x, int y, const wchar_t *str);
+}
+
+#pragma once
@@ -0,0 +1,309 @@
+﻿#ifndef CAR_SIM_HEADLESS
+#include <graphics.h>
+#endif
+#include <vector>
+#include <algorithm>
+
+#include "RenderBatch.h"
+using namespace std;
+
+namespace
+{
+    const uint32_t NO_COMMAND = 0xFFFFFFFF;
+    const uint32_t NO_COLOR = 0xFFFFFFFF; // 尚未设置的状态
+
+    typedef RasterPrepared::Bounds Bounds;
+
+    RenderStateKey keyOf(const RasterCommand &c)
+    {
+        RenderStateKey key = {};
+        key.op = c.op;
+        if (c.op == RasterOp::SHAPE)
+        {
+            key.flags = c.flags & (RASTER_FILL | RASTER_OUTLINE);
+            if (c.flags & RASTER_FILL)
+                key.fill = c.fill;
+            if (c.flags & RASTER_OUTLINE)
+            {
+                key.line = c.line;
+                key.thickness = c.thickness;
+            }
+        }
+        else if (c.op == RasterOp::LINE)
+        {
+            key.flags = c.flags & RASTER_DASHED;
+            key.line = c.line;
+            key.thickness = c.thickness;
+        }
+        else
+        {
+            key.line = c.line;
+            key.textHeight = c.rx;
+        }
+        return key;
+    }
+
+    // 重叠判断用的包围盒：描边的线宽可能超出形状的外接矩形，向外放宽线宽
+    Bounds overlapBounds(const Bounds &b, const RasterCommand &c)
+    {
+        int margin = c.op == RasterOp::SHAPE && (c.flags & RASTER_OUTLINE) ? c.thickness : 0;
+        return Bounds{b.left - margin, b.top - margin, b.right + margin, b.bottom + margin};
+    }
+
+    bool intersects(const Bounds &a, const Bounds &b)
+    {
+        return !(a.left > b.right || a.right < b.left || a.top > b.bottom || a.bottom < b.top);
+    }
+
+    // 按提交顺序遍历批次：只在状态改变时调用sink的set*，同一批次中首尾相接的细线段合并为折线
+    template <typename Sink>
+    void walk(const RasterCanvas &canvas, const vector<RenderBatch> &batches, const vector<uint32_t> &next, Sink &sink)
+    {
+        uint32_t fill = NO_COLOR, line = NO_COLOR, textColor = NO_COLOR;
+        int style = -1, thickness = -1, textHeight = -1;
+        sink.setTransparent(); // 画布上的文字总是透明背景
+        for (const auto &batch : batches)
+        {
+            const RenderStateKey &key = batch.key;
+            if ((key.op == RasterOp::SHAPE && (key.flags & RASTER_FILL)) && fill != key.fill)
+            {
+                fill = key.fill;
+                sink.setFill(fill);
+            }
+            if (key.op == RasterOp::LINE || (key.op == RasterOp::SHAPE && (key.flags & RASTER_OUTLINE)))
+            {
+                if (line != key.line)
+                {
+                    line = key.line;
+                    sink.setLine(line);
+                }
+                int keyStyle = (key.op == RasterOp::LINE && (key.flags & RASTER_DASHED)) ? PS_DASH : PS_SOLID;
+                if (style != keyStyle || thickness != key.thickness)
+                {
+                    style = keyStyle;
+                    thickness = key.thickness;
+                    sink.setLineStyle(style, thickness);
+                }
+            }
+            if (key.op == RasterOp::TEXT)
+            {
+                if (textColor != key.line)
+                {
+                    textColor = key.line;
+                    sink.setTextColor(textColor);
+                }
+                if (textHeight != key.textHeight)
+                {
+                    textHeight = key.textHeight;
+                    sink.setTextHeight(textHeight);
+                }
+            }
+
+            for (uint32_t i = batch.first; i != NO_COMMAND; i = next[i])
+            {
+                const RasterCommand &c = canvas.commands[i];
+                if (c.op == RasterOp::SHAPE)
+                {
+                    sink.shape(c);
+                }
+                else if (c.op == RasterOp::TEXT)
+                {
+                    sink.text(c);
+                }
+                else
+                {
+                    // 粗线的拐角与分开画的两段不同，只合并线宽为1的线段
+                    sink.beginPolyline(c.x0, c.y0);
+                    sink.addPoint(c.x1, c.y1);
+                    while (key.thickness == 1 && next[i] != NO_COMMAND && canvas.commands[next[i]].x0 == canvas.commands[i].x1 &&
+                           canvas.commands[next[i]].y0 == canvas.commands[i].y1)
+                    {
+                        i = next[i];
+                        sink.addPoint(canvas.commands[i].x1, canvas.commands[i].y1);
+                    }
+                    sink.endPolyline();
+                }
+            }
+        }
+    }
+
+    // 只统计调用次数
+    struct CountingSink
+    {
+        RenderBatchStats &stats;
+
+        void setTransparent() { ++stats.stateChanges; }
+        void setFill(uint32_t) { ++stats.stateChanges; }
+        void setLine(uint32_t) { ++stats.stateChanges; }
+        void setLineStyle(int, int) { ++stats.stateChanges; }
+        void setTextColor(uint32_t) { ++stats.stateChanges; }
+        void setTextHeight(int) { ++stats.stateChanges; }
+        void shape(const RasterCommand &) { ++stats.drawCalls; }
+        void text(const RasterCommand &) { ++stats.drawCalls; }
+        void beginPolyline(int, int) {}
+        void addPoint(int, int) {}
+        void endPolyline() { ++stats.drawCalls; }
+    };
+
+#ifndef CAR_SIM_HEADLESS
+    // 像素格式0x00RRGGBB转换为COLORREF
+    COLORREF pixelToColor(uint32_t p)
+    {
+        return RGB((p >> 16) & 0xFF, (p >> 8) & 0xFF, p & 0xFF);
+    }
+
+    // 画到EasyX
+    struct EasyXSink
+    {
+        const RasterCanvas &canvas;
+        vector<POINT> points;
+        vector<wchar_t> buffer;
+
+        explicit EasyXSink(const RasterCanvas &canvas) : canvas(canvas) {}
+
+        void setTransparent() { ::setbkmode(TRANSPARENT); }
+        void setFill(uint32_t color) { ::setfillcolor(pixelToColor(color)); }
+        void setLine(uint32_t color) { ::setlinecolor(pixelToColor(color)); }
+        void setLineStyle(int style, int thickness) { ::setlinestyle(style, thickness); }
+        void setTextColor(uint32_t color) { ::settextcolor(pixelToColor(color)); }
+        void setTextHeight(int height) { ::settextstyle(height, 0, L"Arial"); }
+
+        void shape(const RasterCommand &c)
+        {
+            if (c.flags & RASTER_CIRCLE)
+            {
+                ::fillcircle((c.x0 + c.x1) / 2, (c.y0 + c.y1) / 2, c.rx);
+            }
+            else if (c.rx > 0 || c.ry > 0 || (c.flags & (RASTER_ODD_WIDTH | RASTER_ODD_HEIGHT)))
+            {
+                ::fillroundrect(c.x0, c.y0, c.x1, c.y1, 2 * c.rx + ((c.flags & RASTER_ODD_WIDTH) ? 1 : 0),
+                                2 * c.ry + ((c.flags & RASTER_ODD_HEIGHT) ? 1 : 0));
+            }
+            else if ((c.flags & RASTER_FILL) && (c.flags & RASTER_OUTLINE))
+            {
+                ::fillrectangle(c.x0, c.y0, c.x1, c.y1);
+            }
+            else if (c.flags & RASTER_FILL)
+            {
+                ::solidrectangle(c.x0, c.y0, c.x1, c.y1);
+            }
+            else
+            {
+                ::rectangle(c.x0, c.y0, c.x1, c.y1);
+            }
+        }
+
+        void text(const RasterCommand &c)
+        {
+            buffer.assign(canvas.text.begin() + c.textOffset, canvas.text.begin() + c.textOffset + c.textLength);
+            buffer.push_back(0);
+            ::outtextxy(c.x0, c.y0, buffer.data());
+        }
+
+        void beginPolyline(int x, int y)
+        {
+            points.clear();
+            addPoint(x, y);
+        }
+        void addPoint(int x, int y)
+        {
+            POINT p;
+            p.x = x;
+            p.y = y;
+            points.push_back(p);
+        }
+        void endPolyline()
+        {
+            if (points.size() == 2)
+                ::line(points[0].x, points[0].y, points[1].x, points[1].y);
+            else
+                ::polyline(points.data(), (int)points.size());
+        }
+    };
+#endif
+}
+
+void RenderBatcher::build(const RasterCanvas &canvas)
+{
+    prepareRaster(canvas, glyphCache, prepared);
+    uint32_t count = (uint32_t)canvas.commands.size();
+    batches.clear();
+    next.assign(count, NO_COMMAND);
+    stats = RenderBatchStats();
+    stats.commands = count;
+    stats.stateCalls = canvas.stateCalls;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const RasterCommand &c = canvas.commands[i];
+        const Bounds &clipped = prepared.bounds[i];
+        if (clipped.left > clipped.right || clipped.top > clipped.bottom)
+        {
+            ++stats.culled; // 完全在画面外
+            continue;
+        }
+        Bounds bounds = overlapBounds(clipped, c);
+        RenderStateKey key = keyOf(c);
+
+        // 向前查找状态相同的批次，遇到与本图元相交的批次时停止（不能越过它）
+        int target = -1;
+        int stop = max(0, (int)batches.size() - lookback);
+        for (int k = (int)batches.size() - 1; k >= stop; --k)
+        {
+            if (batches[k].key == key)
+            {
+                target = k;
+                break;
+            }
+            if (intersects(batches[k].bounds, bounds))
+                break;
+        }
+        if (target < 0)
+        {
+            batches.push_back(RenderBatch{key, i, i, bounds});
+            continue;
+        }
+        RenderBatch &batch = batches[target];
+        next[batch.last] = i;
+        batch.last = i;
+        batch.bounds.left = min(batch.bounds.left, bounds.left);
+        batch.bounds.top = min(batch.bounds.top, bounds.top);
+        batch.bounds.right = max(batch.bounds.right, bounds.right);
+        batch.bounds.bottom = max(batch.bounds.bottom, bounds.bottom);
+    }
+    stats.batches = batches.size();
+
+    CountingSink counter{stats};
+    walk(canvas, batches, next, counter);
+}
+
+void RenderBatcher::submit(const RasterCanvas &canvas)
+{
+#ifndef CAR_SIM_HEADLESS
+    ::cleardevice();
+    EasyXSink sink(canvas);
+    walk(canvas, batches, next, sink);
+#else
+    (void)canvas;
+#endif
+}
+
+void RenderBatcher::replay(const RasterCanvas &canvas, RasterCanvas &out) const
+{
+    out.reset(canvas.width, canvas.height);
+    out.background = canvas.background;
+    for (const auto &batch : batches)
+    {
+        for (uint32_t i = batch.first; i != NO_COMMAND; i = next[i])
+        {
+            RasterCommand c = canvas.commands[i];
+            if (c.op == RasterOp::TEXT)
+            {
+                c.textOffset = (uint32_t)out.text.size();
+                out.text.insert(out.text.end(), canvas.text.begin() + canvas.commands[i].textOffset,
+                                canvas.text.begin() + canvas.commands[i].textOffset + c.textLength);
+            }
+            out.commands.push_back(c);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+﻿#include <vector>
+#include <cstdint>
+#include "Render.h"
+#include "SoftRaster.h"
+using namespace std;
+
+// 批量提交：绘制代码先把一帧记录到RasterCanvas，再按绘图状态（颜色、线型和线宽、字高）分组后提交给EasyX。
+//
+// 图元只会提前到前面状态相同的批次中，并且不越过与它相交的图元，所以重叠部分的覆盖关系与记录顺序相同；
+// 完全在画面外的图元不提交。提交时只在状态真正改变时调用set*，
+// 同一批次中首尾相接的线段合并成一条折线（虚线的线型因此沿折线连续，不再每段重新开始）。
+
+// 图元需要的绘图状态（与图元无关的字段为0）
+struct RenderStateKey
+{
+    RasterOp op;
+    uint8_t flags;      // RASTER_FILL、RASTER_OUTLINE、RASTER_DASHED
+    int16_t thickness;  // 描边和线段的线宽
+    uint32_t fill;      // 填充颜色
+    uint32_t line;      // 描边、线段或文字的颜色
+    int32_t textHeight; // 字高
+
+    bool operator==(const RenderStateKey &o) const
+    {
+        return op == o.op && flags == o.flags && thickness == o.thickness && fill == o.fill && line == o.line &&
+               textHeight == o.textHeight;
+    }
+    bool operator!=(const RenderStateKey &o) const { return !(*this == o); }
+};
+
+// 一个批次：状态相同的图元，按记录顺序用next链接
+struct RenderBatch
+{
+    RenderStateKey key;
+    uint32_t first, last;
+    RasterPrepared::Bounds bounds; // 批次中所有图元的包围盒
+};
+
+// 一帧的统计：直接绘制与批量提交对比
+struct RenderBatchStats
+{
+    size_t commands = 0;     // 记录的图元数（直接绘制时的绘制调用数）
+    size_t stateCalls = 0;   // 直接绘制时的状态设置调用数
+    size_t culled = 0;       // 完全在画面外、不提交的图元数
+    size_t batches = 0;      // 批次数
+    size_t stateChanges = 0; // 提交时的状态设置调用数
+    size_t drawCalls = 0;    // 提交时的绘制调用数（折线算一次）
+};
+
+struct RenderBatcher
+{
+    int lookback = 32; // 图元最多向前越过的批次数
+    GlyphCache glyphCache;
+    RasterPrepared prepared;
+    vector<RenderBatch> batches; // 提交顺序
+    vector<uint32_t> next;       // 同一批次中的下一个图元
+    RenderBatchStats stats;
+
+    // 把画布上的图元分组，并统计提交时的状态切换和绘制调用
+    void build(const RasterCanvas &canvas);
+    // 按分组结果画到EasyX的当前工作图像（无界面构建中没有EasyX，不做任何事）
+    void submit(const RasterCanvas &canvas);
+    // 按提交顺序把图元写成另一个画布（用于检查分组前后的画面是否相同）
+    void replay(const RasterCanvas &canvas, RasterCanvas &out) const;
+};
+
+#pragma once
@@ -0,0 +1,229 @@
+﻿#include <algorithm>
+#include <cstdio>
+#include <cmath>
+
+#include "SafetyMetrics.h"
+using namespace std;
+
+namespace
+{
+    const double TICK_SECONDS = 0.2; // 每帧的仿真时长
+
+    // 沿行驶方向的位置（按仿真的车道布局）
+    double progressOf(const LaneTopology &lanes, const Vehicle &v, int lane)
+    {
+        return lanes.direction(lane) * v.x;
+    }
+}
+
+SafetyHistogram::SafetyHistogram(double upper)
+    : upper(upper), overflow(0), count(0), sum(0), minimum(INFINITY)
+{
+    fill(begin(bins), end(bins), 0);
+}
+
+void SafetyHistogram::add(double value)
+{
+    ++count;
+    minimum = min(minimum, value);
+    if (value >= upper)
+    {
+        ++overflow;
+        return;
+    }
+    int bin = (int)(max(0.0, value) / upper * SAFETY_HISTOGRAM_BINS);
+    ++bins[min(bin, SAFETY_HISTOGRAM_BINS - 1)];
+    sum += value;
+}
+
+void SafetyHistogram::merge(const SafetyHistogram &other)
+{
+    for (int i = 0; i < SAFETY_HISTOGRAM_BINS; ++i)
+        bins[i] += other.bins[i];
+    overflow += other.overflow;
+    count += other.count;
+    sum += other.sum;
+    minimum = min(minimum, other.minimum);
+}
+
+uint64_t SafetyHistogram::countBelow(double threshold) const
+{
+    int last = (int)min((double)SAFETY_HISTOGRAM_BINS, threshold / upper * SAFETY_HISTOGRAM_BINS);
+    uint64_t total = 0;
+    for (int i = 0; i < last; ++i)
+        total += bins[i];
+    return total;
+}
+
+double SafetyHistogram::quantile(double q) const
+{
+    if (count == 0)
+        return 0;
+    double target = q * count;
+    double seen = 0;
+    double width = upper / SAFETY_HISTOGRAM_BINS;
+    for (int i = 0; i < SAFETY_HISTOGRAM_BINS; ++i)
+    {
+        if (seen + bins[i] >= target && bins[i] > 0)
+            return width * (i + (target - seen) / bins[i]);
+        seen += bins[i];
+    }
+    return upper;
+}
+
+SafetyMetrics::SafetyMetrics()
+    : followTtc(10), followDrac(10), laneChangeTtc(10), laneChangeDrac(10), pet(10),
+      overlaps(0), pairTicks(0), laneChanges(0), ticks(0), seconds(0) {}
+
+void SafetyMetrics::merge(const SafetyMetrics &other)
+{
+    followTtc.merge(other.followTtc);
+    followDrac.merge(other.followDrac);
+    laneChangeTtc.merge(other.laneChangeTtc);
+    laneChangeDrac.merge(other.laneChangeDrac);
+    pet.merge(other.pet);
+    overlaps += other.overlaps;
+    pairTicks += other.pairTicks;
+    laneChanges += other.laneChanges;
+    ticks += other.ticks;
+    seconds += other.seconds;
+}
+
+void SafetyMonitor::addPair(const Simulation &sim, const Vehicle &follower, const Vehicle &leader,
+                            SafetyHistogram &ttc, SafetyHistogram &drac)
+{
+    ++metrics.pairTicks;
+    double gap = (abs(leader.x - follower.x) - (leader.carlength / 2 + follower.carlength / 2)) / sim.scale; // 米
+    double closing = (follower.speed - leader.speed) / sim.scale / TICK_SECONDS;                            // 米/秒
+    if (gap <= 0)
+    {
+        ++metrics.overlaps;
+        return;
+    }
+    if (closing <= 0)
+        return;
+    ttc.add(gap / closing);
+    drac.add(closing * closing / (2 * gap));
+}
+
+void SafetyMonitor::record(const Simulation &sim)
+{
+    const vector<Vehicle> &vehicles = sim.vehicles;
+    ++metrics.ticks;
+    metrics.seconds += TICK_SECONDS;
+
+    const LaneTopology &topology = sim.laneKernels.topology;
+    // 每条车道按行驶方向从后到前排列
+    int lanes = sim.laneCount;
+    laneOrder.resize(lanes);
+    for (int lane = 0; lane < lanes; ++lane)
+        laneOrder[lane].clear();
+    for (int i = 0; i < (int)vehicles.size(); ++i)
+    {
+        int lane = vehicles[i].lane;
+        if (lane >= 0 && lane < lanes)
+            laneOrder[lane].push_back(i);
+    }
+    for (int lane = 0; lane < lanes; ++lane)
+    {
+        sort(laneOrder[lane].begin(), laneOrder[lane].end(), [&](int a, int b)
+             { return progressOf(topology, vehicles[a], lane) < progressOf(topology, vehicles[b], lane); });
+    }
+
+    // 同车道相邻的跟驰车对
+    for (int lane = 0; lane < lanes; ++lane)
+    {
+        const vector<int> &order = laneOrder[lane];
+        for (size_t k = 1; k < order.size(); ++k)
+            addPair(sim, vehicles[order[k - 1]], vehicles[order[k]], metrics.followTtc, metrics.followDrac);
+    }
+
+    // 正在变道的车辆与目标车道上的前车、后车
+    for (const Vehicle &v : vehicles)
+    {
+        if (!v.isChangingLane || v.targetLane < 0 || v.targetLane >= lanes || v.targetLane == v.lane)
+            continue;
+        const vector<int> &order = laneOrder[v.targetLane];
+        double position = progressOf(topology, v, v.targetLane);
+        auto ahead = lower_bound(order.begin(), order.end(), position, [&](int i, double p)
+                                 { return progressOf(topology, vehicles[i], v.targetLane) < p; });
+        if (ahead != order.end())
+            addPair(sim, v, vehicles[*ahead], metrics.laneChangeTtc, metrics.laneChangeDrac);
+        if (ahead != order.begin())
+            addPair(sim, vehicles[*(ahead - 1)], v, metrics.laneChangeTtc, metrics.laneChangeDrac);
+    }
+
+    // 与上一帧比较找出完成变道的车辆，登记侵入点（两个列表都按编号递增）
+    size_t p = 0;
+    for (int i = 0; i < (int)vehicles.size(); ++i)
+    {
+        const Vehicle &v = vehicles[i];
+        while (p < previousLanes.size() && previousLanes[p].first < v.id)
+            ++p;
+        if (p == previousLanes.size() || previousLanes[p].first != v.id || previousLanes[p].second == v.lane ||
+            v.lane < 0 || v.lane >= lanes)
+            continue;
+        ++metrics.laneChanges;
+        const vector<int> &order = laneOrder[v.lane];
+        auto self = find(order.begin(), order.end(), i);
+        if (self != order.begin() && self != order.end())
+        {
+            double rear = progressOf(topology, v, v.lane) - v.carlength / 2;
+            pending.push_back({v.lane, rear, sim.time, vehicles[*(self - 1)].id});
+        }
+    }
+    previousLanes.clear();
+    for (const Vehicle &v : vehicles)
+        previousLanes.push_back({v.id, v.lane});
+
+    // 后车车头越过侵入点时得到PET（按本帧内匀速插值越过的时刻）
+    size_t kept = 0;
+    for (size_t k = 0; k < pending.size(); ++k)
+    {
+        const Encroachment &e = pending[k];
+        auto it = lower_bound(vehicles.begin(), vehicles.end(), e.followerId,
+                              [](const Vehicle &v, int id) { return v.id < id; });
+        bool resolved = true;
+        if (it == vehicles.end() || it->id != e.followerId || it->lane != e.lane)
+        {
+            // 后车已经驶离或离开了这条车道，没有后侵入
+        }
+        else if (progressOf(topology, *it, e.lane) + it->carlength / 2 >= e.rear)
+        {
+            double past = (progressOf(topology, *it, e.lane) + it->carlength / 2 - e.rear) / max(1, it->speed) * TICK_SECONDS;
+            metrics.pet.add(max(0.0, sim.time - min(past, TICK_SECONDS) - e.time));
+        }
+        else if (sim.time - e.time >= horizon)
+        {
+            metrics.pet.add(horizon);
+        }
+        else
+        {
+            resolved = false;
+        }
+        if (!resolved)
+            pending[kept++] = e;
+    }
+    pending.resize(kept);
+}
+
+void printSafetyMetrics(const SafetyMetrics &metrics, const SafetyThresholds &thresholds)
+{
+    double minutes = max(metrics.seconds, 1e-9) / 60.0;
+    printf("safety over %lld ticks (%.1f min): %lld pair-ticks, %lld overlapping, %lld lane changes\n",
+           metrics.ticks, minutes, metrics.pairTicks, metrics.overlaps, metrics.laneChanges);
+    printf("  %-16s %10s %8s %8s %8s %8s %12s\n", "measure", "samples", "min", "p5", "p50", "mean", "critical/min");
+    auto row = [&](const char *name, const SafetyHistogram &h, double threshold, bool below)
+    {
+        uint64_t critical = below ? h.countBelow(threshold) : h.count - h.countBelow(threshold);
+        printf("  %-16s %10llu %8.2f %8.2f %8.2f %8.2f %12.2f\n", name, (unsigned long long)h.count,
+               h.count ? h.minimum : 0.0, h.quantile(0.05), h.quantile(0.5), h.mean(), critical / minutes);
+    };
+    row("TTC follow (s)", metrics.followTtc, thresholds.ttc, true);
+    row("TTC change (s)", metrics.laneChangeTtc, thresholds.ttc, true);
+    row("PET (s)", metrics.pet, thresholds.pet, true);
+    row("DRAC follow", metrics.followDrac, thresholds.drac, false);
+    row("DRAC change", metrics.laneChangeDrac, thresholds.drac, false);
+    printf("  critical: TTC < %.1f s, PET < %.1f s, DRAC > %.1f m/s^2\n", thresholds.ttc, thresholds.pet,
+           thresholds.drac);
+}
@@ -0,0 +1,90 @@
+﻿#include <vector>
+#include <cstdint>
+#include "Simulation.h"
+using namespace std;
+
+// 替代安全指标（surrogate safety measures）：每帧对所有跟驰车对和正在变道的车辆计算
+//   TTC  碰撞时间：间距 / 接近速度（秒），只在后车比前车快时有定义
+//   DRAC 避免碰撞所需减速度：接近速度² / (2 × 间距)（米/秒²）
+//   PET  后侵入时间：变道车离开目标车道上的位置后，目标车道的后车到达该位置所用的时间（秒）
+// 结果累加到固定桶数的直方图，内存不随运行时长增长；每帧只对每条车道排序一次，
+// 缓冲区复用、不分配内存，可以在大批量运行中一直开启。
+
+const int SAFETY_HISTOGRAM_BINS = 50;
+
+// 定宽直方图：[0, upper)等分为SAFETY_HISTOGRAM_BINS个桶，超出上限的样本计入overflow
+struct SafetyHistogram
+{
+    double upper;
+    uint64_t bins[SAFETY_HISTOGRAM_BINS];
+    uint64_t overflow;
+    uint64_t count;
+    double sum;     // 样本之和（不含overflow），用于均值
+    double minimum; // 最小样本
+
+    explicit SafetyHistogram(double upper = 10);
+
+    void add(double value);
+    void merge(const SafetyHistogram &other);
+    // 小于threshold的样本数（按桶边界近似）
+    uint64_t countBelow(double threshold) const;
+    // 分位数（按桶内线性插值，落在overflow中时返回upper）
+    double quantile(double q) const;
+    double mean() const { return count > overflow ? sum / (count - overflow) : 0; }
+};
+
+// 常用的危险阈值
+struct SafetyThresholds
+{
+    double ttc = 1.5;  // 秒
+    double pet = 1.0;  // 秒
+    double drac = 3.4; // 米/秒²
+};
+
+struct SafetyMetrics
+{
+    SafetyHistogram followTtc;      // 同车道跟驰车对
+    SafetyHistogram followDrac;
+    SafetyHistogram laneChangeTtc;  // 变道车与目标车道前车/后车
+    SafetyHistogram laneChangeDrac;
+    SafetyHistogram pet;            // 变道完成后目标车道后车的后侵入时间
+    long long overlaps;             // 间距不大于0的车对帧数（已经相撞）
+    long long pairTicks;            // 统计过的跟驰车对帧数
+    long long laneChanges;          // 完成的变道次数
+    long long ticks;
+    double seconds;                 // 统计的仿真时长
+
+    SafetyMetrics();
+    void merge(const SafetyMetrics &other);
+};
+
+// 逐帧累加器：每次Simulation::step之后调用record
+struct SafetyMonitor
+{
+    SafetyMetrics metrics;
+    double horizon = 10; // PET的最长等待时间（秒），超过时记为overflow
+
+    // 一次变道留下的侵入点，等待目标车道的后车经过
+    struct Encroachment
+    {
+        int lane;
+        double rear;   // 变道车完成变道时车尾沿行驶方向的位置（像素）
+        double time;   // 完成变道的时刻
+        int followerId; // 当时目标车道上紧随其后的车辆
+    };
+    vector<Encroachment> pending;
+
+    // 复用的缓冲区
+    vector<vector<int>> laneOrder;         // 每条车道按行驶方向从后到前排列的车辆下标（按sim.laneCount调整）
+    vector<pair<int, int>> previousLanes;  // 上一帧的(编号, 车道)，按编号递增
+
+    void record(const Simulation &sim);
+    // 记录一对前后车的TTC/DRAC（两车不在接近时不计入直方图）
+    void addPair(const Simulation &sim, const Vehicle &follower, const Vehicle &leader,
+                 SafetyHistogram &ttc, SafetyHistogram &drac);
+};
+
+// 输出各指标的分布摘要
+void printSafetyMetrics(const SafetyMetrics &metrics, const SafetyThresholds &thresholds = SafetyThresholds());
+
+#pragma once
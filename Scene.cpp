@@ -0,0 +1,162 @@
+﻿#include <cwchar>
+#include <cmath>
+#include <algorithm>
+
+#include "Define.h"
+#include "VehicleTypes.h"
+#include "Scene.h"
+#include "Render.h"
+#include "AllocProfiler.h"
+using namespace std;
+
+namespace
+{
+    // 查出要绘制的车辆：车身、警告线框、速度标签或预测轨迹与视口相交
+    void collectVisible(const Simulation &sim, const LodConfig &lodConfig, SceneView &view)
+    {
+        const Camera &camera = view.camera;
+        WorldRect viewRect = camera.visibleRect();
+        // 警告线框在车身外5像素；速度标签在车身上方25像素，宽高按屏幕像素固定（约40×20）
+        int margin = 25 + (int)ceil(40 / camera.zoom);
+        view.visible.clear();
+        view.candidates.clear();
+
+        if (!view.culling)
+        {
+            // 不裁剪：绘制所有车辆，可见车辆数同样逐一判断，画面与裁剪时相同
+            int visibleCount = 0;
+            for (size_t i = 0; i < sim.vehicles.size(); ++i)
+            {
+                view.visible.push_back((int)i);
+                if (vehicleBounds(sim.vehicles[i]).intersects(viewRect))
+                    ++visibleCount;
+            }
+            view.visibleVehicles = visibleCount;
+            return;
+        }
+
+        view.grid.build(sim.vehicles, sim.windowWidth, sim.windowHeight, sim.laneHeight);
+        view.grid.query(viewRect.expanded(margin, margin), view.candidates);
+        int visibleCount = 0;
+        for (int i : view.candidates)
+        {
+            if (vehicleBounds(sim.vehicles[i]).intersects(viewRect))
+                ++visibleCount;
+        }
+        view.visibleVehicles = visibleCount;
+
+        // 轨迹可能显示时，按每格轨迹实际伸出的范围找出轨迹伸进视口的车辆（变道轨迹可伸进相邻车道）
+        bool trajectories = shouldShowTrajectory(lodConfig, camera.screenLength(2 * view.grid.maxHalfLength), visibleCount);
+        if (trajectories)
+        {
+            view.candidates.clear();
+            view.grid.queryTrajectories(viewRect.expanded(margin, margin + sim.laneHeight), view.candidates);
+        }
+        for (int i : view.candidates)
+        {
+            const Vehicle &v = sim.vehicles[i];
+            if (vehicleBounds(v).expanded(margin, margin).intersects(viewRect) ||
+                (trajectories && trajectoryBounds(v, v.predictionHorizon()).intersects(viewRect)))
+            {
+                view.visible.push_back(i);
+            }
+        }
+    }
+}
+
+void drawScene(const Bridge &bridge, const Simulation &sim, const LodConfig &lodConfig)
+{
+    // 没有相机时显示整座桥
+    thread_local SceneView view;
+    view.camera.fit(sim.windowWidth, sim.windowHeight, sim.windowWidth, sim.windowHeight);
+    drawScene(bridge, sim, lodConfig, view);
+}
+
+void drawScene(const Bridge &bridge, const Simulation &sim, const LodConfig &lodConfig, SceneView &view)
+{
+    ALLOC_SCOPE("draw");
+    SimulationScope scope(sim); // 预测帧数等按本仿真的参数计算
+    int windowWidth = sim.windowWidth;
+    const Camera &camera = view.camera;
+    render::cleardevice();
+    {
+        ALLOC_SCOPE("label"); // 软件光栅化时文字命令追加到画布
+        // 显示桥的参数信息
+        wchar_t info[256];
+        swprintf(info, 256, L"桥长： %.0fm  桥宽：%.0fm  桥宽放大率： %.1f", bridge.bridgeLength, bridge.bridgeWidth, bridge.widthScale);
+        render::settextstyle(20, 0, L"Arial");
+        render::outtextxy(10, 10, info);
+        // 显示时间
+        wchar_t info2[256];
+        swprintf(info2, 256, L"时间： %.0fs", sim.time);
+        render::settextstyle(20, 0, L"Arial");
+        render::outtextxy(windowWidth - 150, 10, info2);
+        // 放大时显示缩放倍数
+        if (camera.zoom > 1)
+        {
+            swprintf(info2, 256, L"缩放： %.1fx", camera.zoom);
+            render::outtextxy(windowWidth - 150, 35, info2);
+        }
+        if (view.qualityLabel != nullptr)
+        {
+            render::outtextxy(windowWidth - 150, 60, view.qualityLabel);
+        }
+    }
+
+    // 绘制车道（只画视口内的部分，起点对齐虚线的周期）
+    WorldRect viewRect = camera.visibleRect();
+    render::setlinecolor(WHITE);                              // 设置线条为白色
+    render::settextcolor(WHITE);                              // 设置文字为白色
+    int laneCount = sim.laneCount;                    // 车道数量
+    int laneHeight = sim.laneHeight;                  // 车道像素宽度
+    {
+        RenderTransformScope world(camera.transform());
+        int lineStart = max(0, viewRect.left / 20 * 20);
+        int lineEnd = min(windowWidth, viewRect.right + 20);
+        for (int i = 0; i < laneCount - 1; ++i)
+        {
+            int y = (i + 1) * laneHeight;
+            if (y >= viewRect.top && y <= viewRect.bottom)
+                drawDashedLine(lineStart, y, lineEnd, y);
+        }
+    }
+    // 绘制箭头和可视化按钮
+    for (int i = 0; i < laneCount; ++i)
+    {
+        // 绘制按钮背景
+        int buttonX = 5;
+        int buttonY = laneHeight * i + (int)(0.5 * laneHeight) - (int)(laneHeight / 4);
+        int buttonWidth = 40;
+        int buttonHeight = (int)(laneHeight / 2);
+
+        // 设置按钮颜色
+        render::setfillcolor(RGB(70, 70, 70));    // 深灰色背景
+        render::setlinecolor(RGB(200, 200, 200)); // 浅灰色边框
+        render::fillrectangle(buttonX, buttonY, buttonX + buttonWidth, buttonY + buttonHeight);
+
+        // 绘制箭头
+        render::settextstyle((int)(laneHeight / 2), 0, L"Arial");
+        render::settextcolor(WHITE);
+        render::outtextxy(buttonX + 10, buttonY, i < laneCount / 2 ? L"→" : L"←");
+    }
+
+    // 绘制视口内的车辆（按屏幕上的车长和可见车辆数选择细节等级）
+    collectVisible(sim, lodConfig, view);
+    RenderTransformScope world(camera.transform());
+    int vehicleCount = view.visibleVehicles;
+    for (int i : view.visible)
+    {
+        const Vehicle &v = sim.vehicles[i];
+        int screenLength = camera.screenLength(v.carlength);
+        if (v.isFlashing)
+        {
+            v.drawFlashingFrame(); // 距离过近的橘色警告线框
+        }
+        if (shouldShowTrajectory(lodConfig, screenLength, vehicleCount))
+        {
+            v.predictAndDrawTrajectory(v.predictionHorizon(), sim.vehicles); // 预测并绘制轨迹
+        }
+        v.draw(chooseLod(lodConfig, screenLength, vehicleCount),
+               shouldShowLabel(lodConfig, screenLength, vehicleCount)); // 绘制车辆
+    }
+}
@@ -0,0 +1,24 @@
+﻿#include "Class.h"
+#include "Simulation.h"
+#include "Viewport.h"
+
+// 一个窗口的视图状态：相机、空间网格和查询缓冲区（绘制线程私有，跨帧复用）
+struct SceneView
+{
+    Camera camera;
+    VehicleGrid grid;
+    vector<int> candidates; // 网格查询的结果
+    vector<int> visible;    // 本帧实际绘制的车辆下标
+    bool culling = true;    // false时绘制所有车辆（超出视口的部分被裁掉，用于对比）
+    int visibleVehicles = 0; // 本帧车身在视口内的车辆数（细节等级按此选择）
+    const wchar_t *qualityLabel = nullptr; // 不为空时显示在右上角（画质降级时的当前等级，见FrameGovernor.h）
+};
+
+// 绘制一帧完整画面：桥的参数信息、时间、车道线、清空车道按钮和所有车辆
+// 绘制到当前工作图像上（窗口或SetWorkingImage指定的离屏图像）
+void drawScene(const Bridge &bridge, const Simulation &sim, const LodConfig &lodConfig);
+// 按view的相机绘制：参数信息和按钮固定在窗口上，车道和车辆按相机缩放平移，
+// 只绘制与视口相交的车辆和轨迹（由空间网格查出）
+void drawScene(const Bridge &bridge, const Simulation &sim, const LodConfig &lodConfig, SceneView &view);
+
+#pragma once
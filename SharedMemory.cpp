@@ -0,0 +1,138 @@
+﻿#include <string>
+#include <cstring>
+
+#include "SharedMemory.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+#ifdef _WIN32
+
+bool SharedMemory::create(const string &regionName, size_t regionSize)
+{
+    close();
+    unsigned long long size64 = regionSize;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                        (DWORD)(size64 >> 32), (DWORD)(size64 & 0xFFFFFFFF), regionName.c_str());
+    if (mapping == NULL)
+        return false;
+    void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, regionSize);
+    if (view == NULL)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    handle = mapping;
+    data = view;
+    size = regionSize;
+    name = regionName;
+    owner = true;
+    memset(data, 0, size); // 新建的映射本来就是零页，这里保证语义一致
+    return true;
+}
+
+bool SharedMemory::open(const string &regionName, size_t regionSize, bool readOnly)
+{
+    close();
+    HANDLE mapping = OpenFileMappingA(readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS, FALSE, regionName.c_str());
+    if (mapping == NULL)
+        return false;
+    void *view = MapViewOfFile(mapping, readOnly ? FILE_MAP_READ : FILE_MAP_ALL_ACCESS, 0, 0, regionSize);
+    if (view == NULL)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    handle = mapping;
+    data = view;
+    size = regionSize;
+    name = regionName;
+    owner = false;
+    return true;
+}
+
+void SharedMemory::close()
+{
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (handle != nullptr)
+        CloseHandle((HANDLE)handle);
+    data = nullptr;
+    handle = nullptr;
+    size = 0;
+    owner = false;
+}
+
+#else
+
+bool SharedMemory::create(const string &regionName, size_t regionSize)
+{
+    close();
+    string path = "/" + regionName;
+    shm_unlink(path.c_str()); // 清除上次异常退出留下的同名区域
+    int descriptor = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (descriptor < 0)
+        return false;
+    if (ftruncate(descriptor, (off_t)regionSize) != 0)
+    {
+        ::close(descriptor);
+        shm_unlink(path.c_str());
+        return false;
+    }
+    void *view = mmap(NULL, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(descriptor);
+        shm_unlink(path.c_str());
+        return false;
+    }
+    fd = descriptor;
+    data = view;
+    size = regionSize;
+    name = regionName;
+    owner = true;
+    return true;
+}
+
+bool SharedMemory::open(const string &regionName, size_t regionSize, bool readOnly)
+{
+    close();
+    string path = "/" + regionName;
+    int descriptor = shm_open(path.c_str(), readOnly ? O_RDONLY : O_RDWR, 0600);
+    if (descriptor < 0)
+        return false;
+    void *view = mmap(NULL, regionSize, readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(descriptor);
+        return false;
+    }
+    fd = descriptor;
+    data = view;
+    size = regionSize;
+    name = regionName;
+    owner = false;
+    return true;
+}
+
+void SharedMemory::close()
+{
+    if (data != nullptr)
+        munmap(data, size);
+    if (fd >= 0)
+        ::close(fd);
+    if (owner)
+        shm_unlink(("/" + name).c_str());
+    data = nullptr;
+    fd = -1;
+    size = 0;
+    owner = false;
+}
+
+#endif
@@ -0,0 +1,32 @@
+﻿#include <string>
+#include <cstddef>
+using namespace std;
+
+// 命名共享内存区域，多个本地进程映射同一块内存
+// Windows使用文件映射对象，其他平台使用POSIX共享内存
+struct SharedMemory
+{
+    void *data = nullptr; // 映射到本进程的地址
+    size_t size = 0;      // 区域大小（字节）
+    string name;          // 区域名称
+    bool owner = false;   // 是否由本进程创建（负责删除）
+#ifdef _WIN32
+    void *handle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    SharedMemory() {}
+    SharedMemory(const SharedMemory &) = delete;
+    SharedMemory &operator=(const SharedMemory &) = delete;
+    ~SharedMemory() { close(); }
+
+    // 创建并映射一块新的共享内存（内容清零）
+    bool create(const string &regionName, size_t regionSize);
+    // 映射已存在的共享内存，readOnly为true时只读映射
+    bool open(const string &regionName, size_t regionSize, bool readOnly = false);
+    // 取消映射，创建者同时删除区域
+    void close();
+};
+
+#pragma once
@@ -0,0 +1,35 @@
+﻿#include "Define.h"
+
+// 仿真运行时参数：默认值取自Define.h中的常量，可在运行时修改用于参数扫描
+struct SimParams
+{
+    int safeDistance = SAFE_DISTANCE;   // 安全距离（像素）
+    int crashDistance = CRASH_DISTANCE; // 碰撞距离（像素）
+    int wait = WAIT;                    // 等待速度差阈值
+    int crash = CRASH;                  // 危险速度差阈值
+    double sedanSafeFactor = 0.8;       // 小轿车安全距离倍数
+    double suvSafeFactor = 1.0;         // SUV安全距离倍数
+    double truckSafeFactor = 1.5;       // 大卡车安全距离倍数
+    int spawnPeriod = 10;               // 平均每多少帧尝试生成一辆新车（越大交通越稀疏）
+    int maxPredictionSteps = 30;        // 轨迹预测的最长帧数
+    int minPredictionSteps = 5;         // 轨迹预测的最短帧数
+    double brakingDeceleration = 5;     // 制动减速度（像素/帧²），按速度估计停车距离，决定预测帧数
+    bool logRelativeSpeed = true;       // 是否在控制台输出相对速度（批量运行时关闭）
+};
+
+// 当前线程正在推进的仿真所绑定的参数（由Simulation::step设置）
+inline const SimParams *&boundSimParams()
+{
+    thread_local const SimParams *params = nullptr;
+    return params;
+}
+
+// 车辆逻辑读取参数：未绑定仿真时使用默认参数
+inline const SimParams &simParams()
+{
+    static const SimParams defaults;
+    const SimParams *params = boundSimParams();
+    return params != nullptr ? *params : defaults;
+}
+
+#pragma once
@@ -0,0 +1,259 @@
+﻿#include <vector>
+#include <random>
+#include <algorithm>
+#include <iostream>
+
+#include "Simulation.h"
+#include "Define.h"
+#include "VehicleTypes.h"
+#include "LaneChange.h"
+#include "AllocProfiler.h"
+#include "PerfCounters.h"
+using namespace std;
+
+Simulation::Simulation(int windowWidth, int windowHeight, double scale, double widthScale, uint64_t seed)
+    : engine(seed), time(0), tick(0), nextVehicleId(1), exitedCount(0), brokenDownCount(0),
+      windowWidth(windowWidth), windowHeight(windowHeight),
+      laneCount(6), laneHeight(windowHeight / 6), scale(scale), widthScale(widthScale),
+      laneKernels(selectLaneKernels(6, 3)) {}
+
+void Simulation::setLaneCount(int count)
+{
+    laneCount = count;
+    laneHeight = windowHeight / count;
+    laneKernels = selectLaneKernels(count, count / 2);
+}
+
+void Simulation::step()
+{
+    // 本帧内车辆使用的参数都来自本仿真
+    SimulationScope scope(*this);
+    ALLOC_SCOPE("step");
+    PERF_SCOPE("step");
+
+    // 清除上一帧的警告线框标记
+    for (auto &v : vehicles)
+    {
+        v.isFlashing = false;
+    }
+
+    {
+        ALLOC_SCOPE("spawn");
+        PERF_SCOPE("spawn");
+        spawn();
+    }
+    updateVehicles();
+    {
+        ALLOC_SCOPE("removeExited");
+        PERF_SCOPE("removeExited");
+        removeExited();
+    }
+
+    time += 0.2;
+    ++tick;
+}
+
+size_t countBrokenDown(const vector<Vehicle> &vehicles)
+{
+    return count_if(vehicles.begin(), vehicles.end(),
+                    [](const Vehicle &v) { return v.isBrokenDown; });
+}
+
+// 车辆长宽的分布：正态分布（每次新建分布对象，避免分布内部缓存影响检查点恢复）
+int Simulation::sampleCarWidth()
+{
+    return (int)(normal_distribution<>(3, 0.1)(engine) * scale * widthScale);
+}
+
+int Simulation::sampleCarLength()
+{
+    return (int)(normal_distribution<>(6, 0.1)(engine) * scale);
+}
+
+int Simulation::sampleVehicleType()
+{
+    return (int)(engine() % 3);
+}
+
+int Simulation::sampleSpeed()
+{
+    return uniform_int_distribution<int>(20, 120)(engine);
+}
+
+// 采样一次生成尝试
+bool Simulation::sampleSpawn(SpawnAttempt &attempt)
+{
+    if (engine() % (uint64_t)max(1, params.spawnPeriod) != 0) // 判断要不要产生新的一辆车
+        return false;
+
+    attempt.id = nextVehicleId++;
+    attempt.lane = (int)(engine() % (uint64_t)max(1, laneCount)); // 如果有车，车辆的随机位置
+    sampleVehicle(attempt);
+    return true;
+}
+
+// 采样车辆的长宽、车型、速度和随机数种子
+void Simulation::sampleVehicle(SpawnAttempt &attempt)
+{
+    attempt.carwidth = sampleCarWidth();
+    attempt.carlength = sampleCarLength();
+    attempt.vehicleType = sampleVehicleType(); // 随机选择车辆类型：0-小轿车，1-SUV，2-大卡车
+    attempt.speed = sampleSpeed();
+    attempt.rngSeed = engine();
+}
+
+// 检查新车位置是否安全
+bool Simulation::isSpawnSafe(const SpawnAttempt &attempt, const vector<Vehicle> &existing) const
+{
+    int newX = laneKernels.topology.direction(attempt.lane) > 0 ? 0 : windowWidth; // 从行驶方向的入口进入
+    for (const auto &existingVehicle : existing)
+    {
+        // 只检查同一车道的车辆
+        if (existingVehicle.lane != attempt.lane)
+            continue;
+
+        // 计算两车之间的距离
+        int distance = abs(existingVehicle.x - newX) - (existingVehicle.carlength / 2 + attempt.carlength / 2);
+
+        // 如果距离小于安全距离，位置不安全
+        if (distance < params.safeDistance)
+            return false;
+    }
+    return true;
+}
+
+Vehicle Simulation::makeVehicle(const SpawnAttempt &attempt) const
+{
+    int newX = laneKernels.topology.direction(attempt.lane) > 0 ? 0 : windowWidth; // 从行驶方向的入口进入
+    int newY = laneCenterY(attempt.lane);
+    Vehicle v;
+    if (attempt.vehicleType == 0)
+    {
+        v = Sedan(attempt.lane, attempt.carlength, attempt.carwidth, newX, newY, attempt.speed);
+    }
+    else if (attempt.vehicleType == 1)
+    {
+        v = SUV(attempt.lane, attempt.carlength, attempt.carwidth, newX, newY, attempt.speed);
+    }
+    else
+    {
+        v = Truck(attempt.lane, attempt.carlength, attempt.carwidth, newX, newY, attempt.speed);
+    }
+    v.id = attempt.id;
+    v.rng = SimRandom(attempt.rngSeed);
+    return v;
+}
+
+// 生成新车：只有在位置安全时才添加
+void Simulation::spawn()
+{
+    if (spawnSource)
+    {
+        spawnSource(*this);
+        return;
+    }
+    SpawnAttempt attempt;
+    if (sampleSpawn(attempt) && isSpawnSafe(attempt, vehicles))
+    {
+        ALLOC_SCOPE("vehicles"); // 车辆数组增长
+        vehicles.push_back(makeVehicle(attempt));
+    }
+}
+
+// 第一阶段：车辆前进
+void Simulation::moveVehicles(vector<Vehicle> &movers) const
+{
+    laneKernels.move(movers);
+}
+
+// 跟车：检查与前车距离，可能设置准备变道状态或使车辆抛锚
+void Simulation::followVehicles(vector<Vehicle> &movers, const vector<Vehicle> &snapshot, vector<int> &crashedIds) const
+{
+    SafeDistanceTable safeDistances(params); // 按车型的安全距离，每帧只计算一次
+    laneKernels.follow(movers, snapshot, safeDistances, crashedIds); // 使用车型的安全距离检查与前车距离
+}
+
+void Simulation::advanceLaneChanges(vector<Vehicle> &movers) const
+{
+    for (auto &v : movers)
+    {
+        if (v.isGoing2change && v.isChangingLane && !v.isBrokenDown)
+        {
+            if (v.advanceLaneChange())
+            {
+                v.haschanged = true;
+            }
+        }
+    }
+}
+
+void Simulation::recoverVehicles(vector<Vehicle> &movers, const vector<Vehicle> &snapshot) const
+{
+    laneKernels.recover(movers, snapshot, params.safeDistance);
+}
+
+// 第二阶段：跟车、变道和警告恢复，只读快照、只修改movers中的车辆自身
+void Simulation::followAndChangeLanes(vector<Vehicle> &movers, const vector<Vehicle> &snapshot, vector<int> &crashedIds) const
+{
+    {
+        ALLOC_SCOPE("follow");
+        PERF_SCOPE("follow");
+        followVehicles(movers, snapshot, crashedIds);
+    }
+
+    // 推进正在进行的变道
+    advanceLaneChanges(movers);
+
+    // 新的变道意图统一批量判断
+    {
+        ALLOC_SCOPE("laneChange");
+        PERF_SCOPE("laneChange");
+        resolveLaneChanges(movers, snapshot, laneHeight, laneCount);
+    }
+
+    recoverVehicles(movers, snapshot);
+}
+
+// 更新车辆的位置
+void Simulation::updateVehicles()
+{
+    size_t brokenBefore = countBrokenDown(vehicles);
+
+    {
+        ALLOC_SCOPE("move");
+        PERF_SCOPE("move");
+        moveVehicles(vehicles);
+    }
+    vector<Vehicle> snapshot; // 前进后的状态快照，第二阶段只读
+    {
+        ALLOC_SCOPE("snapshot");
+        PERF_SCOPE("snapshot");
+        snapshot = vehicles;
+    }
+    vector<int> crashedIds;
+    followAndChangeLanes(vehicles, snapshot, crashedIds);
+
+    // 被撞的前车也进入抛锚状态
+    sort(crashedIds.begin(), crashedIds.end());
+    for (auto &v : vehicles)
+    {
+        if (binary_search(crashedIds.begin(), crashedIds.end(), v.id))
+        {
+            v.handleDangerousSituation();
+        }
+    }
+
+    brokenDownCount += (long long)(countBrokenDown(vehicles) - brokenBefore);
+}
+// 移除离开车辆
+void Simulation::removeExited()
+{
+    int width = windowWidth;
+    size_t before = vehicles.size();
+    vehicles.erase(remove_if(vehicles.begin(), vehicles.end(),
+                             [width](const Vehicle &v)
+                             { return v.x < 0 || v.x > width; }),
+                   vehicles.end()); // remove_if:遍历所有车辆，将不需要删除的车辆移至前方，
+    // 将需要删除的移至后方，返回一个分界点值，erase删除从分界点到末尾的值
+    exitedCount += (long long)(before - vehicles.size());
+}
@@ -0,0 +1,108 @@
+﻿#include <vector>
+#include <functional>
+#include "Random.h"
+#include "Class.h"
+using namespace std;
+
+// 一次生成新车尝试的采样结果：先采样全部随机量再检查位置是否安全，
+// 这样随机数的消耗与桥上的车辆无关，分域运行的各进程可以保持同一个随机数序列
+struct SpawnAttempt
+{
+    int id;            // 新车编号（每次尝试都分配，保证各进程一致）
+    int lane;          // 车道
+    int carwidth;      // 车宽（像素）
+    int carlength;     // 车长（像素）
+    int vehicleType;   // 0-小轿车，1-SUV，2-大卡车
+    int speed;         // 速度
+    uint64_t rngSeed;  // 车辆自己的随机数种子
+};
+
+// 仿真状态：所有车辆、随机数引擎和时钟，不依赖窗口绘制，可以独立推进
+//
+// 每帧分两个阶段：先所有车辆前进，再基于前进后的快照做跟车和变道判断。
+// 判断阶段只读快照、只写车辆自身，撞上的前车记录下来在阶段结束后统一处理，
+// 因此结果与车辆在vector中的顺序无关，可以按x范围拆分到多个进程（见Domain.h）
+struct Simulation
+{
+    vector<Vehicle> vehicles; // 桥上的所有车辆（按编号递增排列）
+    SimRandom engine;         // 仿真使用的随机数引擎（生成新车）
+    double time;              // 仿真时钟（秒）
+    long long tick;           // 已推进的帧数
+    int nextVehicleId;        // 下一辆车的编号
+    SimParams params;         // 运行时参数（安全距离、碰撞距离等）
+    function<void(Simulation &)> spawnSource; // 外部需求来源（例如到达记录回放，见Trace.h），为空时随机生成新车
+
+    // 统计量
+    long long exitedCount;    // 已驶离桥面的车辆数（通过量）
+    long long brokenDownCount; // 因危险情况抛锚的车辆数
+
+    // 桥面几何（像素）
+    int windowWidth, windowHeight;
+    int laneCount, laneHeight;
+    double scale, widthScale;
+    LaneKernels laneKernels; // 按车道布局选定的热点内核（见LaneTopology.h），改变车道数时用setLaneCount重新选择
+
+    Simulation(int windowWidth = 0, int windowHeight = 0, double scale = 1, double widthScale = 1, uint64_t seed = 0);
+
+    // 推进一帧：生成新车、更新车辆位置和状态、移除离开的车辆
+    void step();
+    // 生成新车：有外部需求来源时由它生成，否则按一定概率在随机车道生成
+    void spawn();
+    // 采样一次生成尝试，本帧不生成时返回false
+    bool sampleSpawn(SpawnAttempt &attempt);
+    // 采样新车的长宽、车型、速度和随机数种子（编号和车道由调用者决定）
+    void sampleVehicle(SpawnAttempt &attempt);
+    // 新车与existing中的车辆是否保持安全距离
+    bool isSpawnSafe(const SpawnAttempt &attempt, const vector<Vehicle> &existing) const;
+    // 按采样结果创建车辆
+    Vehicle makeVehicle(const SpawnAttempt &attempt) const;
+    // 第一阶段：车辆前进（速度为0的车辆抛锚）
+    void moveVehicles(vector<Vehicle> &movers) const;
+    // 跟车：检查与前车距离，被撞的前车编号写入crashedIds
+    void followVehicles(vector<Vehicle> &movers, const vector<Vehicle> &snapshot, vector<int> &crashedIds) const;
+    // 推进正在进行的变道
+    void advanceLaneChanges(vector<Vehicle> &movers) const;
+    // 处于警告状态的车辆检查是否需要恢复
+    void recoverVehicles(vector<Vehicle> &movers, const vector<Vehicle> &snapshot) const;
+    // 第二阶段：基于快照做跟车、变道和警告恢复，被撞的前车编号写入crashedIds
+    // 新的变道意图由resolveLaneChanges批量判断（分域运行时拆开各步，见Domain.cpp）
+    void followAndChangeLanes(vector<Vehicle> &movers, const vector<Vehicle> &snapshot, vector<int> &crashedIds) const;
+    // 更新所有车辆的位置、跟车和变道状态
+    void updateVehicles();
+    // 移除离开桥面的车辆
+    void removeExited();
+    // 按main()中使用的分布采样车辆参数
+    int sampleCarWidth();   // 车宽：正态分布N(3, 0.1)米
+    int sampleCarLength();  // 车长：正态分布N(6, 0.1)米
+    int sampleVehicleType(); // 车型：0-小轿车，1-SUV，2-大卡车
+    int sampleSpeed();      // 速度：均匀分布[20, 120]
+    // 设置车道数（前一半车道向右行驶），按窗口高度重新计算车道高度并重新选择内核
+    void setLaneCount(int count);
+    // 车道中心线的y坐标
+    int laneCenterY(int lane) const { return laneHeight * lane + (int)(0.5 * laneHeight); }
+};
+
+// 统计抛锚车辆数
+size_t countBrokenDown(const vector<Vehicle> &vehicles);
+
+// 在当前线程绑定仿真的参数和车道内核，作用域结束时恢复
+// 车辆逻辑中的simParams()和currentLaneKernels()由此读取本仿真的参数和布局
+struct SimulationScope
+{
+    const SimParams *previousParams;
+    const LaneKernels *previousKernels;
+
+    explicit SimulationScope(const Simulation &sim)
+        : previousParams(boundSimParams()), previousKernels(boundLaneKernels())
+    {
+        boundSimParams() = &sim.params;
+        boundLaneKernels() = &sim.laneKernels;
+    }
+    ~SimulationScope()
+    {
+        boundSimParams() = previousParams;
+        boundLaneKernels() = previousKernels;
+    }
+};
+
+#pragma once
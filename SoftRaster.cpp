@@ -0,0 +1,480 @@
+﻿#ifndef CAR_SIM_HEADLESS
+#include <graphics.h>
+#endif
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "SoftRaster.h"
+using namespace std;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CAR_SIM_SSE2
+#endif
+
+namespace
+{
+    const int DASH_ON = 18;  // 虚线：实部像素数
+    const int DASH_OFF = 6;  // 虚线：空白像素数
+
+#ifdef CAR_SIM_HEADLESS
+    // 内置5×7点阵字（每行低5位，最高位在左）
+    struct BuiltinGlyph
+    {
+        wchar_t c;
+        uint8_t rows[7];
+    };
+    const BuiltinGlyph builtinGlyphs[] = {
+        {L'0', {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}},
+        {L'1', {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}},
+        {L'2', {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}},
+        {L'3', {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}},
+        {L'4', {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}},
+        {L'5', {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}},
+        {L'6', {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}},
+        {L'7', {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+        {L'8', {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}},
+        {L'9', {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}},
+        {L'-', {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}},
+        {L'.', {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}},
+        {0x2192, {0x00, 0x04, 0x02, 0x1F, 0x02, 0x04, 0x00}}, // →
+        {0x2190, {0x00, 0x04, 0x08, 0x1F, 0x08, 0x04, 0x00}}, // ←
+    };
+
+    Glyph makeBuiltinGlyph(wchar_t c, int height)
+    {
+        int s = max(1, height / 10);
+        Glyph g;
+        g.advance = 6 * s;
+        g.width = 0;
+        g.height = 0;
+        for (const BuiltinGlyph &b : builtinGlyphs)
+        {
+            if (b.c != c)
+                continue;
+            g.width = 5 * s;
+            g.height = max(height, 7 * s);
+            g.mask.assign((size_t)g.width * g.height, 0);
+            int top = (g.height - 7 * s) / 2;
+            for (int row = 0; row < 7 * s; ++row)
+            {
+                for (int col = 0; col < 5 * s; ++col)
+                {
+                    if (b.rows[row / s] & (0x10 >> (col / s)))
+                        g.mask[(size_t)(top + row) * g.width + col] = 0xFFFFFF;
+                }
+            }
+        }
+        return g;
+    }
+#else
+    // 用EasyX在离屏图像上画出白字黑底的字形并读回
+    Glyph makeEasyXGlyph(wchar_t c, int height)
+    {
+        Glyph g;
+        IMAGE *previous = GetWorkingImage();
+        IMAGE image(max(1, height * 3), max(1, height * 2));
+        SetWorkingImage(&image);
+        settextstyle(height, 0, L"Arial");
+        wchar_t s[2] = {c, 0};
+        g.width = min(textwidth(s), height * 3);
+        g.height = min(textheight(s), height * 2);
+        g.advance = textwidth(s);
+        setbkcolor(BLACK);
+        cleardevice();
+        setbkmode(TRANSPARENT);
+        settextcolor(WHITE);
+        outtextxy(0, 0, s);
+        const DWORD *buffer = GetImageBuffer(&image);
+        g.mask.resize((size_t)g.width * g.height);
+        for (int y = 0; y < g.height; ++y)
+        {
+            for (int x = 0; x < g.width; ++x)
+                g.mask[(size_t)y * g.width + x] = buffer[(size_t)y * image.getwidth() + x] & 0xFFFFFF;
+        }
+        SetWorkingImage(previous);
+        return g;
+    }
+#endif
+
+    // 在第y行填充[left, right]（裁剪到目标区域）
+    inline void span(const RasterTarget &t, int y, int left, int right, uint32_t color)
+    {
+        if (y < t.clipTop || y > t.clipBottom)
+            return;
+        left = max(left, t.clipLeft);
+        right = min(right, t.clipRight);
+        if (left <= right)
+            fillSpan(t.pixels + (size_t)y * t.stride + left, right - left + 1, color);
+    }
+
+    // 圆角矩形在第y行覆盖的范围（rx = ry = 0为矩形，外接正方形且半径为边长一半时为圆）
+    bool shapeRow(int left, int top, int right, int bottom, int rx, int ry, int y, int &l, int &r)
+    {
+        if (y < top || y > bottom || left > right)
+            return false;
+        rx = min(rx, (right - left) / 2);
+        ry = min(ry, (bottom - top) / 2);
+        int inset = 0;
+        if (rx > 0 && ry > 0)
+        {
+            int d = y < top + ry ? top + ry - y : (y > bottom - ry ? y - (bottom - ry) : 0);
+            if (d > 0)
+            {
+                double f = (double)d / ry;
+                inset = (int)(rx - rx * sqrt(max(0.0, 1 - f * f)) + 0.5);
+            }
+        }
+        l = left + inset;
+        r = right - inset;
+        return l <= r;
+    }
+
+    void rasterizeShape(const RasterTarget &t, const RasterCommand &c)
+    {
+        bool fill = (c.flags & RASTER_FILL) != 0;
+        bool outline = (c.flags & RASTER_OUTLINE) != 0;
+        int w = c.thickness;
+        int y0 = max(c.y0, t.clipTop), y1 = min(c.y1, t.clipBottom);
+        for (int y = y0; y <= y1; ++y)
+        {
+            int ol, orr;
+            if (!shapeRow(c.x0, c.y0, c.x1, c.y1, c.rx, c.ry, y, ol, orr))
+                continue;
+            if (!outline)
+            {
+                span(t, y, ol, orr, c.fill);
+                continue;
+            }
+            // 描边在形状内侧，宽度为线宽：内缩后的形状以外的部分用线条颜色
+            int il, ir;
+            if (!shapeRow(c.x0 + w, c.y0 + w, c.x1 - w, c.y1 - w, max(0, c.rx - w), max(0, c.ry - w), y, il, ir))
+            {
+                span(t, y, ol, orr, c.line);
+                continue;
+            }
+            span(t, y, ol, il - 1, c.line);
+            if (fill)
+                span(t, y, il, ir, c.fill);
+            span(t, y, ir + 1, orr, c.line);
+        }
+    }
+
+    // 四舍五入的整数除法（n > 0）
+    inline int roundDiv(long long a, long long n)
+    {
+        return (int)(a >= 0 ? (2 * a + n) / (2 * n) : -((-2 * a + n) / (2 * n)));
+    }
+
+    // 线段第i步的点（共steps步）：主方向每步前进1像素，次方向按比例四舍五入。
+    // 每个点只由i决定，屏幕块只需要遍历落在自己范围内的那一段，结果与整条线逐点画出相同
+    void rasterizeLine(const RasterTarget &t, const RasterCommand &c)
+    {
+        int w = c.thickness;
+        int offset = (w - 1) / 2;
+        bool dashed = (c.flags & RASTER_DASHED) != 0;
+        int dx = c.x1 - c.x0, dy = c.y1 - c.y0;
+        int steps = max(abs(dx), abs(dy));
+        if (!dashed && dy == 0)
+        {
+            // 水平线：直接按扫描段填充
+            for (int y = c.y0 - offset; y < c.y0 - offset + w; ++y)
+                span(t, y, min(c.x0, c.x1) - offset, max(c.x0, c.x1) - offset + w - 1, c.line);
+            return;
+        }
+
+        // 主方向上与裁剪区域（加上线宽）相交的步数范围
+        bool xMajor = abs(dx) >= abs(dy);
+        int major0 = xMajor ? c.x0 : c.y0;
+        int direction = (xMajor ? dx : dy) >= 0 ? 1 : -1;
+        int low = (xMajor ? t.clipLeft : t.clipTop) - (w - 1 - offset);
+        int high = (xMajor ? t.clipRight : t.clipBottom) + offset;
+        int first = direction > 0 ? low - major0 : major0 - high;
+        int last = direction > 0 ? high - major0 : major0 - low;
+        first = max(first, 0);
+        last = min(last, steps);
+
+        for (int i = first; i <= last; ++i)
+        {
+            if (dashed && i % (DASH_ON + DASH_OFF) >= DASH_ON)
+                continue;
+            int x = steps == 0 ? c.x0 : c.x0 + roundDiv((long long)i * dx, steps);
+            int y = steps == 0 ? c.y0 : c.y0 + roundDiv((long long)i * dy, steps);
+            if (w == 1)
+            {
+                if (x >= t.clipLeft && x <= t.clipRight && y >= t.clipTop && y <= t.clipBottom)
+                    t.pixels[(size_t)y * t.stride + x] = c.line;
+                continue;
+            }
+            for (int yy = y - offset; yy < y - offset + w; ++yy)
+                span(t, yy, x - offset, x - offset + w - 1, c.line);
+        }
+    }
+
+    // 按覆盖度逐通道混合
+    inline uint32_t blend(uint32_t dst, uint32_t color, uint32_t mask)
+    {
+        if (mask == 0xFFFFFF)
+            return color;
+        uint32_t result = 0;
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            int d = (dst >> shift) & 0xFF, c = (color >> shift) & 0xFF, m = (mask >> shift) & 0xFF;
+            result |= (uint32_t)(d + (c - d) * m / 255) << shift;
+        }
+        return result;
+    }
+
+    void rasterizeText(const RasterTarget &t, const RasterCommand &c, const RasterPrepared &prepared)
+    {
+        int x = c.x0;
+        for (uint32_t i = 0; i < c.textLength; ++i)
+        {
+            const Glyph &g = *prepared.glyphs[c.textOffset + i];
+            int row0 = max(0, t.clipTop - c.y0), row1 = min(g.height - 1, t.clipBottom - c.y0);
+            int col0 = max(0, t.clipLeft - x), col1 = min(g.width - 1, t.clipRight - x);
+            for (int row = row0; row <= row1; ++row)
+            {
+                uint32_t *out = t.pixels + (size_t)(c.y0 + row) * t.stride + x;
+                const uint32_t *mask = g.mask.data() + (size_t)row * g.width;
+                for (int col = col0; col <= col1; ++col)
+                {
+                    if (mask[col] != 0)
+                        out[col] = blend(out[col], c.line, mask[col]);
+                }
+            }
+            x += g.advance;
+        }
+    }
+}
+
+const Glyph &GlyphCache::get(wchar_t c, int height)
+{
+    auto key = make_pair(height, c);
+    auto it = glyphs.find(key);
+    if (it != glyphs.end())
+        return it->second;
+#ifdef CAR_SIM_HEADLESS
+    Glyph g = makeBuiltinGlyph(c, height);
+#else
+    Glyph g = makeEasyXGlyph(c, height);
+#endif
+    return glyphs.emplace(key, move(g)).first->second;
+}
+
+void fillSpan(uint32_t *pixels, int count, uint32_t color)
+{
+    int i = 0;
+#ifdef CAR_SIM_SSE2
+    __m128i value = _mm_set1_epi32((int)color);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128((__m128i *)(pixels + i), value);
+#endif
+    for (; i < count; ++i)
+        pixels[i] = color;
+}
+
+void prepareRaster(const RasterCanvas &canvas, GlyphCache &glyphCache, RasterPrepared &prepared)
+{
+    prepared.bounds.resize(canvas.commands.size());
+    prepared.glyphs.assign(canvas.text.size(), nullptr);
+    for (size_t i = 0; i < canvas.commands.size(); ++i)
+    {
+        const RasterCommand &c = canvas.commands[i];
+        RasterPrepared::Bounds b;
+        if (c.op == RasterOp::SHAPE)
+        {
+            b = {c.x0, c.y0, c.x1, c.y1};
+        }
+        else if (c.op == RasterOp::LINE)
+        {
+            int offset = (c.thickness - 1) / 2;
+            b = {min(c.x0, c.x1) - offset, min(c.y0, c.y1) - offset, max(c.x0, c.x1) - offset + c.thickness - 1,
+                 max(c.y0, c.y1) - offset + c.thickness - 1};
+        }
+        else
+        {
+            int width = 0, height = 0;
+            for (uint32_t k = 0; k < c.textLength; ++k)
+            {
+                const Glyph &g = glyphCache.get(canvas.text[c.textOffset + k], c.rx);
+                prepared.glyphs[c.textOffset + k] = &g;
+                width += g.advance;
+                height = max(height, g.height);
+            }
+            b = {c.x0, c.y0, c.x0 + width - 1, c.y0 + height - 1};
+        }
+        b.left = max(b.left, 0);
+        b.top = max(b.top, 0);
+        b.right = min(b.right, canvas.width - 1);
+        b.bottom = min(b.bottom, canvas.height - 1);
+        if (b.top > b.bottom)
+            b.left = b.right + 1; // 完全在画面外
+        prepared.bounds[i] = b;
+    }
+}
+
+void rasterizeCommand(const RasterTarget &target, const RasterCanvas &canvas, const RasterPrepared &prepared,
+                      size_t index)
+{
+    const RasterCommand &c = canvas.commands[index];
+    if (c.op == RasterOp::SHAPE)
+        rasterizeShape(target, c);
+    else if (c.op == RasterOp::LINE)
+        rasterizeLine(target, c);
+    else
+        rasterizeText(target, c, prepared);
+}
+
+void renderReference(const RasterCanvas &canvas, GlyphCache &glyphCache, uint32_t *pixels, int stride)
+{
+    RasterPrepared prepared;
+    prepareRaster(canvas, glyphCache, prepared);
+    for (int y = 0; y < canvas.height; ++y)
+        fillSpan(pixels + (size_t)y * stride, canvas.width, canvas.background);
+    RasterTarget target = {pixels, stride, 0, 0, canvas.width - 1, canvas.height - 1};
+    for (size_t i = 0; i < canvas.commands.size(); ++i)
+    {
+        if (prepared.bounds[i].left <= prepared.bounds[i].right)
+            rasterizeCommand(target, canvas, prepared, i);
+    }
+}
+
+TileRenderer::TileRenderer(int threads, int tileSize)
+    : tileSize(max(8, tileSize)), nextTile(0)
+{
+    threadCount = threads > 0 ? threads : max(1, (int)thread::hardware_concurrency());
+    for (int i = 1; i < threadCount; ++i)
+        workers.emplace_back(&TileRenderer::workerLoop, this);
+}
+
+TileRenderer::~TileRenderer()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &w : workers)
+        w.join();
+}
+
+void TileRenderer::render(const RasterCanvas &frameCanvas, uint32_t *framePixels, int frameStride)
+{
+    auto start = chrono::steady_clock::now();
+    canvas = &frameCanvas;
+    pixels = framePixels;
+    stride = frameStride;
+    prepareRaster(frameCanvas, glyphCache, prepared);
+    bin();
+    auto binned = chrono::steady_clock::now();
+    renderTiles();
+    auto end = chrono::steady_clock::now();
+    stats.commands = frameCanvas.commands.size();
+    stats.binSeconds = chrono::duration<double>(binned - start).count();
+    stats.rasterSeconds = chrono::duration<double>(end - binned).count();
+}
+
+void TileRenderer::bin()
+{
+    tilesX = (canvas->width + tileSize - 1) / tileSize;
+    tilesY = (canvas->height + tileSize - 1) / tileSize;
+    bins.resize((size_t)tilesX * tilesY);
+    for (auto &b : bins)
+        b.clear(); // 保留容量，稳定后每帧不再分配
+    stats.binEntries = 0;
+    for (size_t i = 0; i < prepared.bounds.size(); ++i)
+    {
+        const RasterPrepared::Bounds &b = prepared.bounds[i];
+        if (b.left > b.right)
+            continue;
+        for (int ty = b.top / tileSize; ty <= b.bottom / tileSize; ++ty)
+        {
+            for (int tx = b.left / tileSize; tx <= b.right / tileSize; ++tx)
+            {
+                bins[(size_t)ty * tilesX + tx].push_back((uint32_t)i);
+                ++stats.binEntries;
+            }
+        }
+    }
+}
+
+void TileRenderer::renderTile(int tile)
+{
+    int tx = tile % tilesX, ty = tile / tilesX;
+    RasterTarget target;
+    target.pixels = pixels;
+    target.stride = stride;
+    target.clipLeft = tx * tileSize;
+    target.clipTop = ty * tileSize;
+    target.clipRight = min(canvas->width, target.clipLeft + tileSize) - 1;
+    target.clipBottom = min(canvas->height, target.clipTop + tileSize) - 1;
+    for (int y = target.clipTop; y <= target.clipBottom; ++y)
+        fillSpan(pixels + (size_t)y * stride + target.clipLeft, target.clipRight - target.clipLeft + 1,
+                 canvas->background);
+    for (uint32_t index : bins[tile])
+        rasterizeCommand(target, *canvas, prepared, index);
+}
+
+void TileRenderer::renderTiles()
+{
+    int tileCount = tilesX * tilesY;
+    nextTile.store(0);
+    {
+        lock_guard<mutex> guard(lock);
+        ++generation;
+        running = (int)workers.size();
+    }
+    wake.notify_all();
+
+    int tile;
+    while ((tile = nextTile++) < tileCount)
+        renderTile(tile);
+
+    unique_lock<mutex> guard(lock);
+    finished.wait(guard, [this]() { return running == 0; });
+}
+
+void TileRenderer::workerLoop()
+{
+    long long seen = 0;
+    while (true)
+    {
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait(guard, [&]() { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        int tileCount = tilesX * tilesY;
+        int tile;
+        while ((tile = nextTile++) < tileCount)
+            renderTile(tile);
+        {
+            lock_guard<mutex> guard(lock);
+            if (--running == 0)
+                finished.notify_one();
+        }
+    }
+}
+
+FrameDifference compareFrames(const uint32_t *a, const uint32_t *b, size_t count, int tolerance)
+{
+    FrameDifference d;
+    d.pixels = (long long)count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (a[i] == b[i])
+            continue;
+        int delta = 0;
+        for (int shift = 0; shift < 24; shift += 8)
+            delta = max(delta, abs((int)((a[i] >> shift) & 0xFF) - (int)((b[i] >> shift) & 0xFF)));
+        d.maxChannelDelta = max(d.maxChannelDelta, delta);
+        if (delta > tolerance)
+            ++d.differing;
+    }
+    return d;
+}
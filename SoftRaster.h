@@ -0,0 +1,123 @@
+﻿#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include "Render.h"
+using namespace std;
+
+// 分块软件光栅化：把RasterCanvas中的图元按包围盒分到64×64像素的屏幕块，
+// 各屏幕块由线程池并行光栅化。每个屏幕块按记录顺序画与它相交的图元，
+// 不同屏幕块写入的像素互不重叠，结果与单线程逐个图元绘制（renderReference）逐像素相同。
+// 填充按水平扫描段进行，扫描段用SIMD一次写入4个像素。
+
+// 一个字形：白字黑底的覆盖度位图（0x00RRGGBB，每个通道独立混合）
+struct Glyph
+{
+    int width, height;
+    int advance; // 到下一个字符的水平距离
+    vector<uint32_t> mask;
+};
+
+// 字形缓存：Windows上用EasyX按实际字体画出字形并读回（与EasyX的文字逐像素一致），
+// 无界面构建使用内置的点阵字（数字、负号、小数点和左右箭头，其他字符只留空位）
+struct GlyphCache
+{
+    map<pair<int, wchar_t>, Glyph> glyphs; // (字高, 字符) -> 字形
+
+    // 取得字形（不存在时生成），只能在绘制线程调用
+    const Glyph &get(wchar_t c, int height);
+};
+
+// 一帧图元的准备结果：每个图元裁剪后的包围盒和文字的字形
+struct RasterPrepared
+{
+    struct Bounds
+    {
+        int left, top, right, bottom; // 包含边界；left > right表示完全在画面外
+    };
+    vector<Bounds> bounds;
+    vector<const Glyph *> glyphs; // 与RasterCanvas::text一一对应
+};
+
+// 光栅化的目标区域：像素写入被限制在裁剪矩形内（包含边界）
+struct RasterTarget
+{
+    uint32_t *pixels;
+    int stride; // 每行的像素数
+    int clipLeft, clipTop, clipRight, clipBottom;
+};
+
+// 计算包围盒并取得字形
+void prepareRaster(const RasterCanvas &canvas, GlyphCache &glyphCache, RasterPrepared &prepared);
+// 在target的裁剪区域内画一个图元
+void rasterizeCommand(const RasterTarget &target, const RasterCanvas &canvas, const RasterPrepared &prepared,
+                      size_t index);
+// 用color填充count个连续像素（SIMD）
+void fillSpan(uint32_t *pixels, int count, uint32_t color);
+
+// 参考实现：单线程、不分块，逐个图元画满整个画面
+void renderReference(const RasterCanvas &canvas, GlyphCache &glyphCache, uint32_t *pixels, int stride);
+
+// 分块渲染统计（最近一帧）
+struct TileRenderStats
+{
+    size_t commands = 0;    // 图元数
+    size_t binEntries = 0;  // 所有屏幕块中的图元引用数
+    double binSeconds = 0;  // 准备和分块耗时
+    double rasterSeconds = 0; // 并行光栅化耗时
+};
+
+struct TileRenderer
+{
+    int tileSize;
+    int threadCount;
+    GlyphCache glyphCache;
+    TileRenderStats stats;
+
+    // 当前帧
+    const RasterCanvas *canvas = nullptr;
+    RasterPrepared prepared;
+    uint32_t *pixels = nullptr;
+    int stride = 0;
+    int tilesX = 0, tilesY = 0;
+    vector<vector<uint32_t>> bins; // 每个屏幕块中按记录顺序排列的图元序号
+
+    // 线程池：工作线程和调用线程一起领取屏幕块
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake;
+    condition_variable finished;
+    long long generation = 0; // 每帧加1，唤醒工作线程
+    int running = 0;          // 正在处理本帧的工作线程数
+    atomic<int> nextTile;
+    bool stopping = false;
+
+    // threads为0时使用硬件线程数
+    explicit TileRenderer(int threads = 0, int tileSize = 64);
+    ~TileRenderer();
+    TileRenderer(const TileRenderer &) = delete;
+    TileRenderer &operator=(const TileRenderer &) = delete;
+
+    // 把画布画到pixels（width × height，每行stride个像素）
+    void render(const RasterCanvas &frameCanvas, uint32_t *framePixels, int frameStride);
+
+    void bin();
+    void renderTiles();
+    void renderTile(int tile);
+    void workerLoop();
+};
+
+// 两帧的差异：任一通道差超过tolerance的像素数
+struct FrameDifference
+{
+    long long pixels = 0;
+    long long differing = 0;
+    int maxChannelDelta = 0;
+};
+
+FrameDifference compareFrames(const uint32_t *a, const uint32_t *b, size_t count, int tolerance);
+
+#pragma once
@@ -0,0 +1,160 @@
+﻿#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+
+#include "SpaceTime.h"
+#include "FrameExport.h"
+using namespace std;
+
+namespace
+{
+    // 速度配色：慢-红，中-黄，快-绿；brightness为0-1的亮度
+    uint32_t speedColor(double ratio, double brightness)
+    {
+        ratio = min(1.0, max(0.0, ratio));
+        double r = ratio < 0.5 ? 1.0 : 2.0 * (1.0 - ratio);
+        double g = ratio < 0.5 ? 2.0 * ratio : 1.0;
+        int red = (int)(255 * r * brightness);
+        int green = (int)(255 * g * brightness);
+        return ((uint32_t)red << 16) | ((uint32_t)green << 8);
+    }
+
+    bool writeFile(const string &path, const vector<uint8_t> &data)
+    {
+        ofstream file(path, ios::binary);
+        file.write((const char *)data.data(), data.size());
+        file.close();
+        return !file.fail();
+    }
+}
+
+SpaceTimeAccumulator::SpaceTimeAccumulator(int laneCount, int bridgeWidth, const SpaceTimeConfig &spaceTimeConfig)
+    : config(spaceTimeConfig), laneCount(laneCount), firstBucket(0), lastBucket(-1), maxSpeed(1)
+{
+    config.cellPixels = max(1, config.cellPixels);
+    config.ticksPerBucket = max(1, config.ticksPerBucket);
+    config.bucketCount = max(1, config.bucketCount);
+    cellCount = max(1, (bridgeWidth + config.cellPixels) / config.cellPixels); // x在[0, bridgeWidth]内
+    cells.assign((size_t)config.bucketCount * laneCount * cellCount, SpaceTimeCell{0, 0});
+}
+
+size_t SpaceTimeAccumulator::index(long long bucket, int lane, int cell) const
+{
+    size_t slot = (size_t)(bucket % config.bucketCount);
+    return (slot * laneCount + lane) * cellCount + cell;
+}
+
+void SpaceTimeAccumulator::add(long long tick, int lane, int x, int speed)
+{
+    if (lane < 0 || lane >= laneCount || tick < 0)
+        return;
+    long long bucket = tick / config.ticksPerBucket;
+    if (bucket < firstBucket)
+        return; // 已滚出窗口
+
+    if (bucket > lastBucket)
+    {
+        // 新的时间格：清空它（以及跳过的时间格）的槽位，最多清空整个缓冲区一次
+        long long from = max(lastBucket + 1, bucket - config.bucketCount + 1);
+        size_t slotSize = (size_t)laneCount * cellCount;
+        for (long long b = from; b <= bucket; ++b)
+        {
+            auto begin = cells.begin() + index(b, 0, 0);
+            fill(begin, begin + slotSize, SpaceTimeCell{0, 0});
+        }
+        lastBucket = bucket;
+        firstBucket = max(firstBucket, bucket - config.bucketCount + 1);
+    }
+
+    int cell = min(cellCount - 1, max(0, x / config.cellPixels));
+    SpaceTimeCell &c = cells[index(bucket, lane, cell)];
+    int magnitude = abs(speed);
+    c.vehicleTicks += 1;
+    c.speedSum += (uint32_t)magnitude;
+    maxSpeed = max(maxSpeed, magnitude);
+}
+
+void SpaceTimeAccumulator::record(const Simulation &sim)
+{
+    // Simulation::step之后tick已加1，本帧的数据记在tick-1
+    for (const auto &v : sim.vehicles)
+    {
+        add(sim.tick - 1, v.lane, v.x, v.speed);
+    }
+}
+
+long long SpaceTimeAccumulator::bucketsStored() const
+{
+    return lastBucket < 0 ? 0 : lastBucket - firstBucket + 1;
+}
+
+const SpaceTimeCell &SpaceTimeAccumulator::at(long long bucket, int lane, int cell) const
+{
+    return cells[index(bucket, lane, cell)];
+}
+
+bool SpaceTimeAccumulator::exportRaw(const string &path) const
+{
+    SpaceTimeHeader header = {};
+    header.magic = SPACETIME_MAGIC;
+    header.version = SPACETIME_VERSION;
+    header.laneCount = (uint32_t)laneCount;
+    header.cellCount = (uint32_t)cellCount;
+    header.bucketCount = (uint32_t)bucketsStored();
+    header.cellPixels = (uint32_t)config.cellPixels;
+    header.ticksPerBucket = (uint32_t)config.ticksPerBucket;
+    header.firstBucket = firstBucket;
+
+    ofstream file(path, ios::binary);
+    file.write((const char *)&header, sizeof(header));
+    size_t slotSize = (size_t)laneCount * cellCount;
+    for (long long b = firstBucket; b <= lastBucket; ++b)
+    {
+        file.write((const char *)&cells[index(b, 0, 0)], slotSize * sizeof(SpaceTimeCell));
+    }
+    file.close();
+    return !file.fail();
+}
+
+bool SpaceTimeAccumulator::exportHeatmaps(const string &directory, const LaneTopology &topology) const
+{
+    long long buckets = bucketsStored();
+    if (buckets == 0)
+        return false;
+
+    Frame speedImage, densityImage;
+    speedImage.index = densityImage.index = 0;
+    speedImage.width = densityImage.width = (int)buckets;
+    speedImage.height = densityImage.height = cellCount;
+
+    bool ok = true;
+    for (int lane = 0; lane < laneCount; ++lane)
+    {
+        speedImage.pixels.assign((size_t)buckets * cellCount, 0);
+        densityImage.pixels.assign((size_t)buckets * cellCount, 0);
+        bool movingRight = topology.direction(lane) > 0;
+        for (long long b = firstBucket; b <= lastBucket; ++b)
+        {
+            int column = (int)(b - firstBucket);
+            for (int cell = 0; cell < cellCount; ++cell)
+            {
+                const SpaceTimeCell &c = at(b, lane, cell);
+                if (c.vehicleTicks == 0)
+                    continue;
+                int row = movingRight ? cellCount - 1 - cell : cell;
+                size_t pixel = (size_t)row * buckets + column;
+                double occupancy = min(1.0, (double)c.vehicleTicks / config.ticksPerBucket);
+                double meanSpeed = (double)c.speedSum / c.vehicleTicks;
+                speedImage.pixels[pixel] = speedColor(meanSpeed / maxSpeed, 0.4 + 0.6 * occupancy);
+                uint32_t gray = (uint32_t)(255 * occupancy);
+                densityImage.pixels[pixel] = (gray << 16) | (gray << 8) | gray;
+            }
+        }
+        string prefix = directory + "/lane_" + to_string(lane);
+        ok = writeFile(prefix + "_speed.png", encodePng(speedImage)) && ok;
+        ok = writeFile(prefix + "_density.png", encodePng(densityImage)) && ok;
+    }
+    return ok;
+}
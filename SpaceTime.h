@@ -0,0 +1,76 @@
+﻿#include <vector>
+#include <string>
+#include <cstdint>
+#include "Simulation.h"
+using namespace std;
+
+// 时空图（x-t图）累加器：按 车道 × 空间格 × 时间格 统计车辆占有和速度，用于诊断激波和拥堵。
+// 每辆车每帧只累加到一个格子（O(1)），不保存轨迹；时间格是环形缓冲区，
+// 只保留最近bucketCount个时间格，长时间运行内存也不增长。
+
+struct SpaceTimeConfig
+{
+    int cellPixels = 10;    // 空间格宽度（像素）
+    int ticksPerBucket = 5; // 每个时间格的帧数（每帧0.2秒，默认1秒）
+    int bucketCount = 600;  // 滚动窗口保留的时间格数
+};
+
+// 一个格子的累加量
+struct SpaceTimeCell
+{
+    uint32_t vehicleTicks; // 车辆在格内的帧数之和（除以ticksPerBucket为平均车辆数）
+    uint32_t speedSum;     // 速度之和（像素/帧，除以vehicleTicks为平均速度）
+};
+
+// 原始数组文件格式（小端）：40字节文件头 + 按时间先后排列的 [时间格][车道][空间格] SpaceTimeCell
+const uint32_t SPACETIME_MAGIC = 0x44545343; // "CSTD"
+const uint32_t SPACETIME_VERSION = 1;
+
+struct SpaceTimeHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t laneCount;
+    uint32_t cellCount;
+    uint32_t bucketCount;    // 文件中的时间格数
+    uint32_t cellPixels;
+    uint32_t ticksPerBucket;
+    uint32_t reserved;
+    int64_t firstBucket;     // 第一个时间格的序号（帧号 / ticksPerBucket）
+};
+
+static_assert(sizeof(SpaceTimeCell) == 8, "时空格必须是8字节");
+static_assert(sizeof(SpaceTimeHeader) == 40, "时空图文件头必须是40字节");
+
+struct SpaceTimeAccumulator
+{
+    SpaceTimeConfig config;
+    int laneCount, cellCount;
+    vector<SpaceTimeCell> cells; // 环形缓冲区：[时间格槽位][车道][空间格]
+    long long firstBucket;       // 窗口内最早的时间格序号
+    long long lastBucket;        // 最近写入的时间格序号，-1表示还没有数据
+    int maxSpeed;                // 出现过的最大速度，用于热力图配色
+
+    SpaceTimeAccumulator(int laneCount, int bridgeWidth, const SpaceTimeConfig &spaceTimeConfig = SpaceTimeConfig());
+
+    // 累加一帧中桥上的所有车辆（在Simulation::step之后调用）
+    void record(const Simulation &sim);
+    // 累加一辆车一帧：早于窗口的数据丢弃，新的时间格开始时清空它的槽位
+    void add(long long tick, int lane, int x, int speed);
+
+    // 窗口内的时间格数
+    long long bucketsStored() const;
+    // 读取窗口内某个时间格的格子
+    const SpaceTimeCell &at(long long bucket, int lane, int cell) const;
+
+    // 写出原始数组（按时间先后展开环形缓冲区）
+    bool exportRaw(const string &path) const;
+    // 每条车道写出两张PNG：lane_N_speed.png（平均速度）和lane_N_density.png（平均车辆数）
+    // 横轴为时间（向右），纵轴为空间（车辆行驶方向向上，方向由topology给出）
+    bool exportHeatmaps(const string &directory, const LaneTopology &topology) const;
+
+private:
+    size_t index(long long bucket, int lane, int cell) const;
+};
+
+#pragma once
@@ -0,0 +1,306 @@
+﻿#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdio>
+
+#include "Sweep.h"
+#include "WarmStart.h"
+using namespace std;
+
+namespace
+{
+    // 95%双侧t分布临界值
+    double tValue95(int degreesOfFreedom)
+    {
+        static const double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                       2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                       2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+        if (degreesOfFreedom < 1)
+            return 0;
+        if (degreesOfFreedom <= 30)
+            return table[degreesOfFreedom - 1];
+        return 1.96;
+    }
+
+    double mean(const vector<double> &samples)
+    {
+        if (samples.empty())
+            return 0;
+        return accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    }
+
+    double halfWidth(const vector<double> &samples)
+    {
+        int n = (int)samples.size();
+        if (n < 2)
+            return INFINITY;
+        double m = mean(samples);
+        double sum = 0;
+        for (double s : samples)
+            sum += (s - m) * (s - m);
+        return tValue95(n - 1) * sqrt(sum / (n - 1) / n);
+    }
+
+    // 一次重复：热启动后推进measureTicks帧，统计通过量和事故率
+    void runReplication(int windowWidth, int windowHeight, double scale, double widthScale,
+                        const SimParams &params, uint64_t seed, int measureTicks,
+                        double &throughput, double &crashRate, SafetyMetrics &safety)
+    {
+        Simulation sim(windowWidth, windowHeight, scale, widthScale, seed);
+        sim.params = params;
+        sim.params.logRelativeSpeed = false;
+        warmStart(sim, WarmStartConfig());
+        SafetyMonitor monitor;
+        for (int i = 0; i < measureTicks; ++i)
+        {
+            sim.step();
+            monitor.record(sim);
+        }
+        safety = monitor.metrics;
+        double minutes = sim.time / 60.0;
+        throughput = sim.exitedCount / minutes;
+        crashRate = sim.brokenDownCount / minutes;
+    }
+}
+
+double SweepResult::throughputMean() const { return mean(throughput); }
+double SweepResult::throughputHalfWidth() const { return halfWidth(throughput); }
+double SweepResult::crashRateMean() const { return mean(crashRate); }
+double SweepResult::crashRateHalfWidth() const { return halfWidth(crashRate); }
+double SweepResult::criticalTtcRate() const
+{
+    return safety.seconds > 0 ? safety.followTtc.countBelow(SafetyThresholds().ttc) / (safety.seconds / 60.0) : 0;
+}
+
+bool setSimParam(SimParams &params, const string &name, double value)
+{
+    if (name == "safeDistance")
+        params.safeDistance = (int)value;
+    else if (name == "crashDistance")
+        params.crashDistance = (int)value;
+    else if (name == "wait")
+        params.wait = (int)value;
+    else if (name == "crash")
+        params.crash = (int)value;
+    else if (name == "sedanSafeFactor")
+        params.sedanSafeFactor = value;
+    else if (name == "suvSafeFactor")
+        params.suvSafeFactor = value;
+    else if (name == "truckSafeFactor")
+        params.truckSafeFactor = value;
+    else if (name == "spawnPeriod")
+        params.spawnPeriod = (int)value;
+    else if (name == "maxPredictionSteps")
+        params.maxPredictionSteps = (int)value;
+    else if (name == "minPredictionSteps")
+        params.minPredictionSteps = (int)value;
+    else if (name == "brakingDeceleration")
+        params.brakingDeceleration = value;
+    else
+        return false;
+    return true;
+}
+
+double getSimParam(const SimParams &params, const string &name)
+{
+    if (name == "safeDistance")
+        return params.safeDistance;
+    if (name == "crashDistance")
+        return params.crashDistance;
+    if (name == "wait")
+        return params.wait;
+    if (name == "crash")
+        return params.crash;
+    if (name == "sedanSafeFactor")
+        return params.sedanSafeFactor;
+    if (name == "suvSafeFactor")
+        return params.suvSafeFactor;
+    if (name == "truckSafeFactor")
+        return params.truckSafeFactor;
+    if (name == "spawnPeriod")
+        return params.spawnPeriod;
+    if (name == "maxPredictionSteps")
+        return params.maxPredictionSteps;
+    if (name == "minPredictionSteps")
+        return params.minPredictionSteps;
+    if (name == "brakingDeceleration")
+        return params.brakingDeceleration;
+    return 0;
+}
+
+vector<SweepResult> runSweep(int windowWidth, int windowHeight, double scale, double widthScale,
+                             const vector<SweepAxis> &axes, const SweepOptions &options)
+{
+    // 生成参数网格（笛卡尔积）
+    vector<SweepResult> results(1);
+    for (const auto &axis : axes)
+    {
+        vector<SweepResult> expanded;
+        for (const auto &partial : results)
+        {
+            for (double value : axis.values)
+            {
+                SweepResult r = partial;
+                setSimParam(r.params, axis.name, value);
+                expanded.push_back(r);
+            }
+        }
+        results = expanded;
+    }
+
+    int threadCount = options.threads > 0 ? options.threads : max(1, (int)thread::hardware_concurrency());
+
+    // 一个批次中的一次重复任务
+    struct Job
+    {
+        int config;
+        int replication;
+        double throughput, crashRate;
+        SafetyMetrics safety;
+
+        Job(int config, int replication) : config(config), replication(replication), throughput(0), crashRate(0) {}
+    };
+
+    auto runBatch = [&](vector<Job> &jobs)
+    {
+        atomic<size_t> next(0);
+        vector<thread> workers;
+        for (int t = 0; t < threadCount; ++t)
+        {
+            workers.emplace_back([&]()
+                                 {
+                                     size_t i;
+                                     while ((i = next++) < jobs.size())
+                                     {
+                                         Job &job = jobs[i];
+                                         // 种子只由配置和重复序号决定，结果与线程调度无关
+                                         uint64_t seed = options.seed * 1000003ULL + job.config * 7919ULL + job.replication;
+                                         runReplication(windowWidth, windowHeight, scale, widthScale,
+                                                        results[job.config].params, seed, options.measureTicks,
+                                                        job.throughput, job.crashRate, job.safety);
+                                     }
+                                 });
+        }
+        for (auto &w : workers)
+            w.join();
+        for (const auto &job : jobs)
+        {
+            results[job.config].throughput.push_back(job.throughput);
+            results[job.config].crashRate.push_back(job.crashRate);
+            results[job.config].safety.merge(job.safety);
+        }
+    };
+
+    // 只看置信区间宽度；达到重复次数上限另由capped标记
+    auto isConverged = [&](const SweepResult &r)
+    {
+        if ((int)r.throughput.size() < options.minReplications)
+            return false;
+        double throughputTolerance = options.relativeTolerance * fabs(r.throughputMean());
+        double crashTolerance = max(options.relativeTolerance * fabs(r.crashRateMean()), options.crashRateFloor);
+        return r.throughputHalfWidth() <= throughputTolerance && r.crashRateHalfWidth() <= crashTolerance;
+    };
+
+    // 第一轮：每个配置都做最少次数的重复
+    vector<Job> jobs;
+    for (int c = 0; c < (int)results.size(); ++c)
+    {
+        for (int rep = 0; rep < options.minReplications; ++rep)
+        {
+            jobs.push_back(Job(c, rep));
+        }
+    }
+    runBatch(jobs);
+
+    // 之后每轮按优先级分配一批重复：置信区间越宽（越不确定）、评价越好（越有希望）优先
+    while (true)
+    {
+        vector<pair<double, int>> open;
+        double best = -INFINITY;
+        for (const auto &r : results)
+        {
+            best = max(best, r.throughputMean() - options.crashPenalty * r.crashRateMean());
+        }
+        for (int c = 0; c < (int)results.size(); ++c)
+        {
+            SweepResult &r = results[c];
+            r.converged = isConverged(r);
+            r.capped = !r.converged && (int)r.throughput.size() >= options.maxReplications;
+            if (r.converged || r.capped)
+                continue;
+            double score = r.throughputMean() - options.crashPenalty * r.crashRateMean();
+            double uncertainty = r.throughputHalfWidth() + options.crashPenalty * r.crashRateHalfWidth();
+            // 置信区间上界离当前最优越近越有希望
+            double priority = uncertainty - max(0.0, best - (score + uncertainty));
+            open.push_back(make_pair(priority, c));
+        }
+        if (open.empty())
+            break;
+
+        sort(open.begin(), open.end(), [](const pair<double, int> &a, const pair<double, int> &b)
+             { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+        jobs.clear();
+        for (int i = 0; i < (int)open.size() && (int)jobs.size() < threadCount; ++i)
+        {
+            int c = open[i].second;
+            jobs.push_back(Job(c, (int)results[c].throughput.size()));
+        }
+        // 线程多于未收敛配置时，把剩余名额继续分给优先级最高的配置
+        for (int i = 0; (int)jobs.size() < threadCount; ++i)
+        {
+            const Job &source = jobs[i % open.size()];
+            int pending = (int)count_if(jobs.begin(), jobs.end(), [&](const Job &j) { return j.config == source.config; });
+            if ((int)results[source.config].throughput.size() + pending >= options.maxReplications)
+                break;
+            jobs.push_back(Job(source.config, (int)results[source.config].throughput.size() + pending));
+        }
+        runBatch(jobs);
+    }
+
+    // 标记通过量-事故率的帕累托最优配置
+    for (auto &r : results)
+    {
+        r.paretoOptimal = true;
+        for (const auto &other : results)
+        {
+            bool noWorse = other.throughputMean() >= r.throughputMean() && other.crashRateMean() <= r.crashRateMean();
+            bool better = other.throughputMean() > r.throughputMean() || other.crashRateMean() < r.crashRateMean();
+            if (noWorse && better)
+            {
+                r.paretoOptimal = false;
+                break;
+            }
+        }
+    }
+
+    // 按通过量从高到低排列，便于查看权衡
+    sort(results.begin(), results.end(), [](const SweepResult &a, const SweepResult &b)
+         { return a.throughputMean() > b.throughputMean(); });
+    return results;
+}
+
+void printSweepTable(const vector<SweepResult> &results, const vector<SweepAxis> &axes)
+{
+    for (const auto &axis : axes)
+    {
+        printf("%16s", axis.name.c_str());
+    }
+    printf("%6s %22s %22s %12s %8s %7s\n", "reps", "throughput(veh/min)", "crashRate(veh/min)", "TTC<1.5/min", "conv",
+           "pareto");
+
+    for (const auto &r : results)
+    {
+        for (const auto &axis : axes)
+        {
+            double value = getSimParam(r.params, axis.name);
+            printf("%16g", value);
+        }
+        printf("%6d %12.2f +- %-7.2f %12.2f +- %-7.2f %12.1f %8s %7s\n", (int)r.throughput.size(),
+               r.throughputMean(), r.throughputHalfWidth(), r.crashRateMean(), r.crashRateHalfWidth(),
+               r.criticalTtcRate(), r.converged ? "yes" : (r.capped ? "capped" : "no"), r.paretoOptimal ? "*" : "");
+    }
+}
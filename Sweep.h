@@ -0,0 +1,58 @@
+﻿#include <vector>
+#include <string>
+#include "Simulation.h"
+#include "SafetyMetrics.h"
+using namespace std;
+
+// 扫描的一个参数维度，name为SimParams中的字段名
+struct SweepAxis
+{
+    string name;
+    vector<double> values;
+};
+
+// 扫描选项
+struct SweepOptions
+{
+    int measureTicks = 1500;     // 每次重复测量的帧数（热启动后立即开始统计）
+    int minReplications = 3;     // 每个配置至少重复的次数
+    int maxReplications = 30;    // 每个配置最多重复的次数
+    double relativeTolerance = 0.05; // 置信区间半宽小于均值的此比例时提前停止
+    double crashRateFloor = 1.0; // 事故率很小时的绝对容差（辆/分钟）
+    double crashPenalty = 1.0;   // 评价“有希望”程度时事故率的权重
+    int threads = 0;             // 工作线程数，0表示使用硬件线程数
+    uint64_t seed = 1;           // 基础随机种子
+};
+
+// 单个配置的扫描结果
+struct SweepResult
+{
+    SimParams params;
+    vector<double> throughput; // 每次重复的通过量（辆/分钟）
+    vector<double> crashRate;  // 每次重复的事故率（抛锚车辆/分钟）
+    SafetyMetrics safety;      // 所有重复合并的替代安全指标分布
+    bool converged = false;    // 置信区间是否已足够窄
+    bool capped = false;       // 达到最多重复次数时置信区间仍然过宽（未收敛）
+    bool paretoOptimal = false; // 在通过量-事故率权衡上是否不被其他配置支配
+
+    double throughputMean() const;
+    double throughputHalfWidth() const; // 95%置信区间半宽
+    double crashRateMean() const;
+    double crashRateHalfWidth() const;
+    double criticalTtcRate() const; // TTC低于阈值的跟驰车对帧数（每分钟）
+};
+
+// 按名称设置参数，名称无效时返回false
+bool setSimParam(SimParams &params, const string &name, double value);
+// 按名称读取参数，名称无效时返回0
+double getSimParam(const SimParams &params, const string &name);
+
+// 在参数网格上并行扫描：先给每个配置最少的重复次数，
+// 之后把更多重复分配给不确定或有希望的配置，置信区间足够窄的配置提前停止
+vector<SweepResult> runSweep(int windowWidth, int windowHeight, double scale, double widthScale,
+                             const vector<SweepAxis> &axes, const SweepOptions &options);
+
+// 输出通过量-事故率权衡表
+void printSweepTable(const vector<SweepResult> &results, const vector<SweepAxis> &axes);
+
+#pragma once
@@ -0,0 +1,374 @@
+﻿#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Trace.h"
+#include "AllocProfiler.h"
+using namespace std;
+
+namespace
+{
+    // 解析车型：数字或名称
+    bool parseVehicleType(const string &text, int &type)
+    {
+        if (text == "0" || text == "sedan")
+            type = 0;
+        else if (text == "1" || text == "suv")
+            type = 1;
+        else if (text == "2" || text == "truck")
+            type = 2;
+        else
+            return false;
+        return true;
+    }
+
+    // 去掉首尾空白
+    string trim(const string &text)
+    {
+        size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == string::npos)
+            return string();
+        size_t last = text.find_last_not_of(" \t\r\n");
+        return text.substr(first, last - first + 1);
+    }
+
+    bool parseNumber(const string &text, double &value)
+    {
+        char *end = nullptr;
+        value = strtod(text.c_str(), &end);
+        return !text.empty() && end == text.c_str() + text.size();
+    }
+}
+
+bool convertTraceCsv(const string &csvPath, const string &tracePath, string &error)
+{
+    ifstream in(csvPath);
+    if (!in)
+    {
+        error = "cannot open " + csvPath;
+        return false;
+    }
+    ofstream out(tracePath, ios::binary);
+    if (!out)
+    {
+        error = "cannot create " + tracePath;
+        return false;
+    }
+
+    TraceHeader header = {TRACE_MAGIC, TRACE_VERSION, (uint32_t)sizeof(TraceRecord), 0, 0, 0};
+    out.write((const char *)&header, sizeof(header));
+
+    vector<TraceRecord> batch; // 成批写入
+    batch.reserve(1 << 16);
+    string line;
+    long long lineNumber = 0;
+    double lastTime = -1e300;
+    while (getline(in, line))
+    {
+        ++lineNumber;
+        if (trim(line).empty())
+            continue;
+        vector<string> fields;
+        stringstream stream(line);
+        string field;
+        while (getline(stream, field, ','))
+        {
+            fields.push_back(trim(field));
+        }
+
+        double time, lane, length, width, speed;
+        int type;
+        bool ok = fields.size() == 6 && parseNumber(fields[0], time) && parseNumber(fields[1], lane) &&
+                  parseVehicleType(fields[2], type) && parseNumber(fields[3], length) &&
+                  parseNumber(fields[4], width) && parseNumber(fields[5], speed);
+        if (!ok)
+        {
+            if (header.recordCount == 0 && batch.empty() && !parseNumber(fields.empty() ? string() : fields[0], time))
+                continue; // 表头
+            error = "line " + to_string(lineNumber) + ": expected time,lane,type,length,width,speed";
+            return false;
+        }
+        // 车道数由回放时的布局决定，这里只检查能否存入记录
+        if (lane < 0 || lane > 255 || lane != (int)lane)
+        {
+            error = "line " + to_string(lineNumber) + ": lane must be an integer 0-255";
+            return false;
+        }
+        if (time < lastTime)
+        {
+            error = "line " + to_string(lineNumber) + ": arrival times must not decrease";
+            return false;
+        }
+        lastTime = time;
+
+        TraceRecord record;
+        record.time = time;
+        record.length = (float)length;
+        record.width = (float)width;
+        record.speed = (float)speed;
+        record.lane = (uint8_t)lane;
+        record.type = (uint8_t)type;
+        record.reserved = 0;
+        batch.push_back(record);
+        if (batch.size() == batch.capacity())
+        {
+            out.write((const char *)batch.data(), batch.size() * sizeof(TraceRecord));
+            header.recordCount += batch.size();
+            batch.clear();
+        }
+    }
+    out.write((const char *)batch.data(), batch.size() * sizeof(TraceRecord));
+    header.recordCount += batch.size();
+
+    // 最后写入记录条数
+    out.seekp(0);
+    out.write((const char *)&header, sizeof(header));
+    out.close();
+    if (!out)
+    {
+        error = "write failed: " + tracePath;
+        return false;
+    }
+    return true;
+}
+
+TraceReader::TraceReader()
+    : recordCount(0), position(0), windowSize(0), currentWindow(-1),
+      requestedWindow(-1), readyWindow(-1), stopping(false), stalls(0), failed(false) {}
+
+bool TraceReader::open(const string &path, string &error, size_t windowBytes)
+{
+    close();
+    if (!file.open(path))
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    TraceHeader header;
+    MappedView view;
+    if (file.size < sizeof(TraceHeader) || !file.map(0, sizeof(TraceHeader), view))
+    {
+        error = path + ": not a trace file";
+        file.close();
+        return false;
+    }
+    memcpy(&header, view.data, sizeof(header));
+    MappedFile::unmap(view);
+    if (header.magic != TRACE_MAGIC || header.version != TRACE_VERSION || header.recordSize != sizeof(TraceRecord) ||
+        file.size < sizeof(TraceHeader) + header.recordCount * sizeof(TraceRecord))
+    {
+        error = path + ": not a trace file or truncated";
+        file.close();
+        return false;
+    }
+
+    recordCount = header.recordCount;
+    position = 0;
+    // 窗口大小取映射粒度的整数倍
+    size_t granularity = MappedFile::granularity();
+    windowSize = max(granularity, windowBytes / granularity * granularity);
+    currentWindow = -1;
+    requestedWindow = -1;
+    readyWindow = -1;
+    stopping = false;
+    stalls = 0;
+    failed = false;
+    prefetcher = thread(&TraceReader::prefetchLoop, this);
+    return true;
+}
+
+void TraceReader::close()
+{
+    if (prefetcher.joinable())
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        changed.notify_all();
+        prefetcher.join();
+    }
+    MappedFile::unmap(current);
+    MappedFile::unmap(ready);
+    currentWindow = -1;
+    readyWindow = -1;
+    file.close();
+    recordCount = 0;
+    position = 0;
+}
+
+long long TraceReader::windowOf(uint64_t index) const
+{
+    return (long long)((sizeof(TraceHeader) + index * sizeof(TraceRecord)) / windowSize);
+}
+
+bool TraceReader::mapWindow(long long k, MappedView &view) const
+{
+    uint64_t start = (uint64_t)k * windowSize;
+    if (start >= file.size)
+        return false;
+    // 窗口多映射一条记录的长度，跨越窗口边界的记录也完整地位于前一个窗口中
+    uint64_t length = min<uint64_t>(file.size - start, windowSize + sizeof(TraceRecord));
+    return file.map(start, (size_t)length, view);
+}
+
+bool TraceReader::switchTo(long long k)
+{
+    MappedFile::unmap(current);
+    {
+        unique_lock<mutex> guard(lock);
+        if (readyWindow == k)
+        {
+            current = ready;
+            ready = MappedView();
+            readyWindow = -1;
+        }
+    }
+    if (current.data == nullptr)
+    {
+        // 预读线程还没准备好（或预读的不是这个窗口），同步映射
+        ++stalls;
+        if (!mapWindow(k, current))
+        {
+            failed = true;
+            currentWindow = -1;
+            return false;
+        }
+    }
+    currentWindow = k;
+
+    // 请求预读下一个窗口
+    {
+        lock_guard<mutex> guard(lock);
+        requestedWindow = k + 1;
+    }
+    changed.notify_all();
+    return true;
+}
+
+const TraceRecord *TraceReader::peek()
+{
+    if (!hasNext())
+        return nullptr;
+    long long k = windowOf(position);
+    if (k != currentWindow && !switchTo(k))
+        return nullptr;
+    uint64_t offset = sizeof(TraceHeader) + position * sizeof(TraceRecord);
+    return reinterpret_cast<const TraceRecord *>(current.data + (offset - current.offset));
+}
+
+const TraceRecord *TraceReader::next()
+{
+    const TraceRecord *record = peek();
+    if (record != nullptr)
+        ++position;
+    return record;
+}
+
+void TraceReader::prefetchLoop()
+{
+    long long prepared = -1;
+    while (true)
+    {
+        long long k;
+        {
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [&] { return stopping || requestedWindow != prepared; });
+            if (stopping)
+                return;
+            k = requestedWindow;
+            if (readyWindow >= 0 && readyWindow != k)
+            {
+                MappedFile::unmap(ready); // 已经用不到的预读窗口
+                readyWindow = -1;
+            }
+        }
+        prepared = k;
+
+        MappedView view;
+        if (!mapWindow(k, view))
+            continue;
+        // 逐页读取一个字节，让操作系统把整个窗口读入内存
+        volatile uint8_t sink = 0;
+        for (size_t i = 0; i < view.length; i += 4096)
+        {
+            sink = sink + view.data[i];
+        }
+
+        lock_guard<mutex> guard(lock);
+        if (stopping || requestedWindow != k || readyWindow >= 0)
+        {
+            MappedFile::unmap(view);
+            continue;
+        }
+        ready = view;
+        readyWindow = k;
+    }
+}
+
+void TraceDemand::spawnDue(Simulation &sim)
+{
+    if (!started)
+    {
+        const TraceRecord *first = reader.peek();
+        startOffset = first != nullptr ? first->time - sim.time : 0;
+        started = true;
+        waiting.assign(sim.laneCount, deque<SpawnAttempt>());
+        lastTime = -1e300;
+    }
+
+    // 到期的记录进入各车道入口的等待队列，等待总数达到上限时暂停；读取失败时停止，已在等待的车辆照常进入
+    size_t total = waitingCount();
+    const TraceRecord *due;
+    while (total < maxWaiting && (due = reader.peek()) != nullptr && due->time - startOffset <= sim.time)
+    {
+        const TraceRecord &record = *reader.next();
+        // 上一次生成时已经到期，说明当时因为上限留在了文件中
+        if (record.time - startOffset <= lastTime)
+            ++deferred;
+        if (record.lane >= waiting.size())
+        {
+            ++rejected;
+            continue;
+        }
+        SpawnAttempt attempt;
+        attempt.id = 0;
+        attempt.lane = record.lane;
+        attempt.carwidth = (int)(record.width * sim.scale * sim.widthScale);
+        attempt.carlength = (int)(record.length * sim.scale);
+        attempt.vehicleType = min<int>(record.type, 2);
+        // 米/秒换算为像素/帧（每帧0.2秒）
+        attempt.speed = max(1, (int)(record.speed * sim.scale * 0.2 + 0.5));
+        attempt.rngSeed = sim.engine();
+        waiting[attempt.lane].push_back(attempt);
+        ++total;
+        ++released;
+    }
+    lastTime = sim.time;
+
+    // 每条车道入口每帧最多进入一辆车
+    for (auto &queue : waiting)
+    {
+        if (!queue.empty() && sim.isSpawnSafe(queue.front(), sim.vehicles))
+        {
+            SpawnAttempt &attempt = queue.front();
+            attempt.id = sim.nextVehicleId++; // 进入时才分配编号，保持车辆按编号递增排列
+            ALLOC_SCOPE("vehicles");
+            sim.vehicles.push_back(sim.makeVehicle(attempt));
+            queue.pop_front();
+            ++spawned;
+        }
+    }
+}
+
+size_t TraceDemand::waitingCount() const
+{
+    size_t total = 0;
+    for (const auto &queue : waiting)
+    {
+        total += queue.size();
+    }
+    return total;
+}
@@ -0,0 +1,125 @@
+﻿#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "MappedFile.h"
+#include "Simulation.h"
+using namespace std;
+
+// 到达记录文件格式（小端）：32字节文件头 + 按到达时间递增排列的定长记录
+const uint32_t TRACE_MAGIC = 0x43525443; // "CTRC"
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;  // sizeof(TraceRecord)
+    uint32_t reserved;
+    uint64_t recordCount; // 记录条数
+    uint64_t reserved2;
+};
+
+// 一辆车的到达记录
+struct TraceRecord
+{
+    double time;    // 到达时间（秒）
+    float length;   // 车长（米）
+    float width;    // 车宽（米）
+    float speed;    // 速度（米/秒）
+    uint8_t lane;   // 车道（回放时按仿真的车道数检查）
+    uint8_t type;   // 车型：0-小轿车，1-SUV，2-大卡车
+    uint16_t reserved;
+};
+
+static_assert(sizeof(TraceHeader) == 32, "到达记录文件头必须是32字节");
+static_assert(sizeof(TraceRecord) == 24, "到达记录必须是24字节");
+
+// CSV转换为二进制到达记录文件
+// 每行：时间(秒),车道,车型,车长(米),车宽(米),速度(米/秒)，车型可写0/1/2或sedan/suv/truck，
+// 第一行不是数字时视为表头跳过。时间必须不递减，出错时返回false并在error中说明行号
+bool convertTraceCsv(const string &csvPath, const string &tracePath, string &error);
+
+// 到达记录读取器：按窗口映射文件，后台线程提前映射并读入下一个窗口，
+// 仿真线程顺序读取时不会因为磁盘读取而等待，任意大小的文件只占用两个窗口的内存
+struct TraceReader
+{
+    MappedFile file;
+    uint64_t recordCount;
+    uint64_t position;      // 下一条要读取的记录序号
+    size_t windowSize;      // 每个窗口的字节数（映射粒度的整数倍）
+    MappedView current;     // 当前窗口
+    long long currentWindow;
+
+    // 预读线程
+    thread prefetcher;
+    mutex lock;
+    condition_variable changed;
+    long long requestedWindow; // 请求预读的窗口序号
+    long long readyWindow;     // 已预读好的窗口序号
+    MappedView ready;          // 已预读好的窗口
+    bool stopping;
+    long long stalls;          // 需要的窗口尚未预读好、只能同步映射的次数
+    bool failed;               // 窗口映射失败（I/O或地址空间不足），之后不再返回记录
+
+    TraceReader();
+    ~TraceReader() { close(); }
+
+    // 打开到达记录文件并检查文件头
+    bool open(const string &path, string &error, size_t windowBytes = 64 << 20);
+    void close();
+    // 是否还有记录（映射失败后返回false）
+    bool hasNext() const { return !failed && position < recordCount; }
+    // 下一条记录（不前进），映射失败时返回nullptr并置failed
+    const TraceRecord *peek();
+    // 读取下一条记录并前进，映射失败时返回nullptr
+    const TraceRecord *next();
+
+    // 记录i所在的窗口
+    long long windowOf(uint64_t index) const;
+    // 切换到窗口k（优先使用预读好的窗口），并请求预读下一个窗口，映射失败时返回false
+    bool switchTo(long long k);
+    // 映射窗口k
+    bool mapWindow(long long k, MappedView &view) const;
+    void prefetchLoop();
+};
+
+// 到达记录驱动的需求：按仿真时钟把到期的记录转换为车辆，
+// 入口处距离不安全的车辆在该车道排队等待，不会丢弃；
+// 车道不在仿真布局内的记录无法进入桥面，计入rejected。
+// 需求超过入口通行能力时，等待的车辆总数达到maxWaiting后暂停读取，到期的记录留在文件中，
+// 内存占用不随记录文件增长（代价是所有车道的后续到达一起推迟，计入deferred）
+struct TraceDemand
+{
+    TraceReader reader;
+    vector<deque<SpawnAttempt>> waiting; // 每条车道入口处等待的车辆（第一次生成时按sim.laneCount分配）
+    size_t maxWaiting;                   // 等待车辆总数的上限
+    double startOffset;                  // 记录时间与仿真时钟的差
+    double lastTime;                     // 上一次生成时的仿真时钟
+    bool started;
+    long long released;                  // 已到期的记录数
+    long long spawned;                   // 已进入桥面的车辆数
+    long long rejected;                  // 车道超出仿真车道数而丢弃的记录数
+    long long deferred;                  // 因等待车辆达到上限而晚于到达时间读取的记录数
+
+    TraceDemand()
+        : maxWaiting(4096), startOffset(0), lastTime(0), started(false), released(0), spawned(0), rejected(0),
+          deferred(0) {}
+
+    // 把第一条记录对齐到仿真的当前时刻
+    bool open(const string &path, string &error, size_t windowBytes = 64 << 20)
+    {
+        return reader.open(path, error, windowBytes);
+    }
+    // 生成到期的车辆（作为Simulation::spawnSource）
+    void spawnDue(Simulation &sim);
+    // 入口处等待的车辆数
+    size_t waitingCount() const;
+    // 记录是否已全部进入桥面（读取失败时不再有新车，等待的车辆进入后也结束）
+    bool finished() const { return !reader.hasNext() && waitingCount() == 0; }
+};
+
+#pragma once
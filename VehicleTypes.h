@@ -1,34 +1,94 @@
 ﻿#include "Class.h"
 
+// 各车型的构造类型：只负责设置车型标记，不含虚函数和额外数据，
+// 因此按值存入vector<Vehicle>时不会发生切片
 // 小轿车类
 struct Sedan : public Vehicle {
     Sedan(int lane, int carlength, int carwidth, int x, int y, int speed);
-    // 重写变道函数，实现更快的变道曲线
-    bool smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicles) override;
-    // 获取小轿车的安全距离
-    int getSafeDistance() const override;
-    // 重写绘制函数
-    void draw() const override;
 };
 
 // SUV类
 struct SUV : public Vehicle {
     SUV(int lane, int carlength, int carwidth, int x, int y, int speed);
-    // 重写变道函数，实现中等的变道曲线
-    bool smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicles) override;
-    // 获取SUV的安全距离
-    int getSafeDistance() const override;
-    // 重写绘制函数
-    void draw() const override;
 };
 
 // 大卡车类
 struct Truck : public Vehicle {
     Truck(int lane, int carlength, int carwidth, int x, int y, int speed);
-    // 重写变道函数，实现更慢的变道曲线
-    bool smoothLaneChange(int laneHeight, const vector<Vehicle> &allVehicles) override;
-    // 获取大卡车的安全距离
-    int getSafeDistance() const override;
-    // 重写绘制函数
-    void draw() const override;
 };
+
+// 各车型的参数和行为，按车型在编译期分派（不使用虚函数）
+template <VehicleType T>
+struct VehicleTraits;
+
+// 小轿车：安全距离短，变道快
+template <>
+struct VehicleTraits<VehicleType::SEDAN>
+{
+    static float laneChangeRate() { return 0.08f; }
+    static double safeFactor(const SimParams &params) { return params.sedanSafeFactor; }
+    static void draw(const Vehicle &v, LodLevel lod, bool showLabel);
+};
+
+// SUV：标准安全距离，变道速度适中
+template <>
+struct VehicleTraits<VehicleType::SUV>
+{
+    static float laneChangeRate() { return 0.05f; }
+    static double safeFactor(const SimParams &params) { return params.suvSafeFactor; }
+    static void draw(const Vehicle &v, LodLevel lod, bool showLabel);
+};
+
+// 大卡车：安全距离长，变道慢
+template <>
+struct VehicleTraits<VehicleType::TRUCK>
+{
+    static float laneChangeRate() { return 0.03f; }
+    static double safeFactor(const SimParams &params) { return params.truckSafeFactor; }
+    static void draw(const Vehicle &v, LodLevel lod, bool showLabel);
+};
+
+// 按车型标记调用fn(VehicleTraits<T>())，分支在编译期展开为各车型的专用代码
+template <typename Fn>
+auto dispatchVehicleType(VehicleType type, Fn &&fn) -> decltype(fn(VehicleTraits<VehicleType::SEDAN>()))
+{
+    switch (type)
+    {
+    case VehicleType::SUV:
+        return fn(VehicleTraits<VehicleType::SUV>());
+    case VehicleType::TRUCK:
+        return fn(VehicleTraits<VehicleType::TRUCK>());
+    default:
+        return fn(VehicleTraits<VehicleType::SEDAN>());
+    }
+}
+
+// 获取安全距离：标准安全距离乘以车型倍数
+inline int Vehicle::getSafeDistance() const
+{
+    const SimParams &params = simParams();
+    return dispatchVehicleType(type, [&](auto traits)
+                               { return (int)(params.safeDistance * traits.safeFactor(params)); });
+}
+
+// 每帧的变道进度增量
+inline float Vehicle::laneChangeRate() const
+{
+    return dispatchVehicleType(type, [](auto traits)
+                               { return traits.laneChangeRate(); });
+}
+
+// 按车型的安全距离表，每帧根据当前参数计算一次
+struct SafeDistanceTable
+{
+    int distance[3];
+    explicit SafeDistanceTable(const SimParams &params)
+    {
+        distance[(int)VehicleType::SEDAN] = (int)(params.safeDistance * VehicleTraits<VehicleType::SEDAN>::safeFactor(params));
+        distance[(int)VehicleType::SUV] = (int)(params.safeDistance * VehicleTraits<VehicleType::SUV>::safeFactor(params));
+        distance[(int)VehicleType::TRUCK] = (int)(params.safeDistance * VehicleTraits<VehicleType::TRUCK>::safeFactor(params));
+    }
+    int operator[](VehicleType type) const { return distance[(int)type]; }
+};
+
+#pragma once
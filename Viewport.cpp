@@ -0,0 +1,142 @@
+﻿#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+
+#include "Viewport.h"
+using namespace std;
+
+void Camera::fit(int viewWidth, int viewHeight, int bridgeWidth, int bridgeHeight)
+{
+    screenWidth = viewWidth;
+    screenHeight = viewHeight;
+    worldWidth = bridgeWidth;
+    worldHeight = bridgeHeight;
+    zoom = 1;
+    originX = originY = 0;
+}
+
+void Camera::zoomAt(int screenX, int screenY, double factor)
+{
+    double worldX = originX + screenX / zoom;
+    double worldY = originY + screenY / zoom;
+    zoom *= factor;
+    clamp();
+    originX = worldX - screenX / zoom;
+    originY = worldY - screenY / zoom;
+    clamp();
+}
+
+void Camera::pan(int dxScreen, int dyScreen)
+{
+    originX -= dxScreen / zoom;
+    originY -= dyScreen / zoom;
+    clamp();
+}
+
+void Camera::clamp()
+{
+    zoom = min(maxZoom, max(1.0, zoom));
+    // zoom为1时视口正好等于桥面；放大后视口不超出桥面
+    double viewWidth = screenWidth / zoom;
+    double viewHeight = screenHeight / zoom;
+    originX = min(max(0.0, worldWidth - viewWidth), max(0.0, originX));
+    originY = min(max(0.0, worldHeight - viewHeight), max(0.0, originY));
+}
+
+WorldRect Camera::visibleRect() const
+{
+    return WorldRect{(int)floor(originX), (int)floor(originY), (int)ceil(originX + screenWidth / zoom),
+                     (int)ceil(originY + screenHeight / zoom)};
+}
+
+void VehicleGrid::build(const vector<Vehicle> &vehicles, int worldWidth, int worldHeight, int laneHeight)
+{
+    rowHeight = max(1, laneHeight);
+    columns = max(1, (worldWidth + cellWidth - 1) / cellWidth);
+    rows = max(1, (worldHeight + rowHeight - 1) / rowHeight);
+    size_t cellCount = (size_t)columns * rows;
+    cellStart.assign(cellCount + 1, 0);
+    cellOf.resize(vehicles.size());
+    entries.resize(vehicles.size());
+    spanLeft.assign(cellCount, INT_MAX);
+    spanRight.assign(cellCount, INT_MIN);
+    maxHalfLength = maxHalfWidth = 0;
+
+    // 计数排序：先数每格的车辆数，再按下标顺序放入，格内保持递增
+    for (size_t i = 0; i < vehicles.size(); ++i)
+    {
+        const Vehicle &v = vehicles[i];
+        int column = min(columns - 1, max(0, v.x / cellWidth));
+        int row = min(rows - 1, max(0, v.y / rowHeight));
+        cellOf[i] = row * columns + column;
+        ++cellStart[cellOf[i] + 1];
+        maxHalfLength = max(maxHalfLength, v.carlength / 2 + 1);
+        maxHalfWidth = max(maxHalfWidth, v.carwidth / 2 + 1);
+        WorldRect path = trajectoryBounds(v, v.predictionHorizon());
+        spanLeft[cellOf[i]] = min(spanLeft[cellOf[i]], min(path.left, v.x - v.carlength / 2));
+        spanRight[cellOf[i]] = max(spanRight[cellOf[i]], max(path.right, v.x + v.carlength / 2));
+    }
+    for (size_t cell = 0; cell < cellCount; ++cell)
+        cellStart[cell + 1] += cellStart[cell];
+    cursor.assign(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < vehicles.size(); ++i)
+        entries[cursor[cellOf[i]]++] = (int)i;
+}
+
+void VehicleGrid::query(const WorldRect &area, vector<int> &out) const
+{
+    if (columns == 0 || entries.empty())
+        return;
+    // 车辆按中心分格，车身可以伸出格子最多半个车长/车宽
+    WorldRect r = area.expanded(maxHalfLength, maxHalfWidth);
+    int c0 = min(columns - 1, max(0, r.left / cellWidth));
+    int c1 = min(columns - 1, max(0, r.right / cellWidth));
+    int r0 = min(rows - 1, max(0, r.top / rowHeight));
+    int r1 = min(rows - 1, max(0, r.bottom / rowHeight));
+    size_t first = out.size();
+    for (int row = r0; row <= r1; ++row)
+    {
+        int begin = cellStart[row * columns + c0];
+        int end = cellStart[row * columns + c1 + 1]; // 同一行相邻格子在entries中连续
+        out.insert(out.end(), entries.begin() + begin, entries.begin() + end);
+    }
+    sort(out.begin() + first, out.end()); // 按车辆顺序返回，绘制的先后与全量绘制相同
+}
+
+void VehicleGrid::queryTrajectories(const WorldRect &area, vector<int> &out) const
+{
+    if (columns == 0 || entries.empty())
+        return;
+    // 轨迹只沿行驶方向伸出，每格按实际的范围判断，不按最快车辆和预测帧数上限统一扩展
+    int r0 = min(rows - 1, max(0, (area.top - maxHalfWidth) / rowHeight));
+    int r1 = min(rows - 1, max(0, (area.bottom + maxHalfWidth) / rowHeight));
+    size_t first = out.size();
+    for (int row = r0; row <= r1; ++row)
+    {
+        for (int column = 0; column < columns; ++column)
+        {
+            int cell = row * columns + column;
+            if (spanLeft[cell] <= area.right && spanRight[cell] >= area.left)
+                out.insert(out.end(), entries.begin() + cellStart[cell], entries.begin() + cellStart[cell + 1]);
+        }
+    }
+    sort(out.begin() + first, out.end());
+}
+
+WorldRect vehicleBounds(const Vehicle &v)
+{
+    return WorldRect{v.x - v.carlength / 2, v.y - v.carwidth / 2, v.x + v.carlength / 2, v.y + v.carwidth / 2};
+}
+
+WorldRect trajectoryBounds(const Vehicle &v, int predictionSteps)
+{
+    int reach = v.direction() * v.speed * predictionSteps;
+    int top = v.y, bottom = v.y;
+    if (v.isChangingLane)
+    {
+        top = min(top, min(v.startY, v.endY));
+        bottom = max(bottom, max(v.startY, v.endY));
+    }
+    return WorldRect{min(v.x, v.x + reach), top, max(v.x, v.x + reach), bottom};
+}
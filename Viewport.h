@@ -0,0 +1,77 @@
+﻿#include <vector>
+#include "Simulation.h"
+#include "Render.h"
+using namespace std;
+
+// 视口：带缩放和平移的相机，以及按位置查找车辆的空间网格。
+// 世界坐标就是仿真使用的像素坐标（整座桥按窗口拟合时的像素），zoom为1时整座桥正好放进窗口，
+// 放大后只显示桥的一部分。绘制时先用网格查出与视口相交的车辆和轨迹，只画这些，
+// 绘制开销取决于可见的车辆数而不是桥上的车辆总数。
+
+// 世界坐标中的矩形（包含边界）
+struct WorldRect
+{
+    int left, top, right, bottom;
+
+    bool intersects(const WorldRect &o) const
+    {
+        return left <= o.right && o.left <= right && top <= o.bottom && o.top <= bottom;
+    }
+    // 四边各向外扩展
+    WorldRect expanded(int dx, int dy) const { return WorldRect{left - dx, top - dy, right + dx, bottom + dy}; }
+};
+
+// 相机：视口左上角的世界坐标和缩放倍数
+struct Camera
+{
+    int screenWidth = 0, screenHeight = 0; // 视口（窗口）像素
+    int worldWidth = 0, worldHeight = 0;   // 桥面的世界尺寸
+    double zoom = 1;                       // 1为整座桥放进窗口
+    double originX = 0, originY = 0;       // 视口左上角的世界坐标
+    double maxZoom = 64;
+
+    // 按窗口和桥面尺寸初始化，显示整座桥
+    void fit(int viewWidth, int viewHeight, int bridgeWidth, int bridgeHeight);
+    // 以屏幕上的(screenX, screenY)为中心缩放factor倍，该点下的世界位置保持不动
+    void zoomAt(int screenX, int screenY, double factor);
+    // 视口移动（屏幕像素，与拖动方向相同时画面跟着鼠标走）
+    void pan(int dxScreen, int dyScreen);
+    // 把缩放限制在[1, maxZoom]，视口限制在桥面之内
+    void clamp();
+
+    // 视口覆盖的世界范围
+    WorldRect visibleRect() const;
+    // 绘制用的坐标变换
+    RenderTransform transform() const { return RenderTransform{zoom, originX, originY}; }
+    // 世界长度在屏幕上的像素数
+    int screenLength(int worldLength) const { return (int)(worldLength * zoom); }
+};
+
+// 均匀网格空间索引：按车辆中心把下标分到（车道行 × x列）的格子里，
+// 计数排序构建，同一格内的下标保持递增
+struct VehicleGrid
+{
+    int cellWidth = 64;              // 列宽（世界像素）
+    int columns = 0, rows = 0;
+    int rowHeight = 1;               // 行高（车道宽度）
+    vector<int> cellStart;           // 第i格的车辆在entries中的范围为[cellStart[i], cellStart[i + 1])
+    vector<int> entries;             // 车辆在vehicles中的下标
+    vector<int> cellOf, cursor;      // 构建用的缓冲区（每辆车所在的格子、每格的写入位置）
+    vector<int> spanLeft, spanRight; // 每格车辆的车身和预测轨迹合起来的x范围（空格子为空范围）
+    int maxHalfLength = 0, maxHalfWidth = 0; // 车辆半长、半宽的最大值（查询时扩展范围）
+
+    // 按当前车辆位置重建（桥面外的车辆归到边缘的格子），
+    // 同时按各车自己的预测帧数记录每格轨迹伸出的范围（需在SimulationScope内调用）
+    void build(const vector<Vehicle> &vehicles, int worldWidth, int worldHeight, int laneHeight);
+    // 车身可能与area相交的车辆下标，按递增顺序追加到out（结果是候选集，调用者再精确判断）
+    void query(const WorldRect &area, vector<int> &out) const;
+    // 车身或预测轨迹可能与area在x方向相交的车辆下标，行的范围与query相同（变道轨迹伸进相邻车道由调用者扩展area）
+    void queryTrajectories(const WorldRect &area, vector<int> &out) const;
+};
+
+// 车身在世界坐标中的范围
+WorldRect vehicleBounds(const Vehicle &v);
+// 预测轨迹（predictAndDrawTrajectory画出的折线）在世界坐标中的范围，方向按车道布局
+WorldRect trajectoryBounds(const Vehicle &v, int predictionSteps);
+
+#pragma once
@@ -0,0 +1,66 @@
+﻿#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "WarmStart.h"
+#include "VehicleTypes.h"
+using namespace std;
+
+int warmStart(Simulation &sim, const WarmStartConfig &config)
+{
+    // 热启动同样只使用仿真自己的随机数引擎和参数，保证可复现
+    SimulationScope scope(sim);
+
+    int placed = 0;
+    int laneCount = min(sim.laneCount, (int)config.lanes.size());
+    for (int lane = 0; lane < laneCount; ++lane)
+    {
+        const LaneWarmStart &laneConfig = config.lanes[lane];
+        if (laneConfig.density <= 0)
+            continue;
+
+        // 目标车头间距（像素）：scale为每米像素数
+        int headway = (int)(100 * sim.scale / laneConfig.density);
+        bool isMovingRight = sim.laneKernels.topology.direction(lane) > 0;
+        int y = sim.laneCenterY(lane);
+
+        // 从出口端向入口端依次放置车辆，前车先放
+        int frontEdge = isMovingRight ? sim.windowWidth : 0; // 前车车尾位置
+        bool first = true;
+        while (true)
+        {
+            int carwidth = sim.sampleCarWidth();
+            int carlength = sim.sampleCarLength();
+            int vehicleType = sim.sampleVehicleType();
+            int speed = uniform_int_distribution<int>(laneConfig.minSpeed, laneConfig.maxSpeed)(sim.engine);
+
+            // 按车型确定安全距离（跟车的后车使用自己的安全距离）
+            Vehicle v;
+            if (vehicleType == 0)
+                v = Sedan(lane, carlength, carwidth, 0, y, speed);
+            else if (vehicleType == 1)
+                v = SUV(lane, carlength, carwidth, 0, y, speed);
+            else
+                v = Truck(lane, carlength, carwidth, 0, y, speed);
+            int safeDistance = v.getSafeDistance();
+            // 第一辆车只需离开出口一个车长
+            int gap = first ? carlength : max(safeDistance + 1, headway - carlength);
+
+            int center = isMovingRight ? frontEdge - gap - carlength / 2
+                                       : frontEdge + gap + carlength / 2;
+            // 车辆必须完全在桥面上
+            if (center - carlength / 2 < 0 || center + carlength / 2 > sim.windowWidth)
+                break;
+
+            v.x = center;
+            v.id = sim.nextVehicleId++;
+            v.rng = SimRandom(sim.engine());
+            sim.vehicles.push_back(v);
+            ++placed;
+            frontEdge = isMovingRight ? center - carlength / 2 : center + carlength / 2;
+            first = false;
+        }
+    }
+
+    return placed;
+}
@@ -0,0 +1,24 @@
+﻿#include <vector>
+#include "Simulation.h"
+using namespace std;
+
+// 单条车道的初始交通状态
+struct LaneWarmStart
+{
+    double density = 4;  // 目标密度（辆/100米）
+    int minSpeed = 20;   // 速度范围，默认与main()中生成新车时的均匀分布相同
+    int maxSpeed = 120;
+};
+
+// 稳态热启动配置：每条车道一项
+struct WarmStartConfig
+{
+    vector<LaneWarmStart> lanes = vector<LaneWarmStart>(6);
+};
+
+// 直接按目标密度和速度分布把车辆铺满桥面，代替从空桥开始慢慢生成
+// 车辆间距不小于各车型的getSafeDistance()，长宽和车型按Simulation的分布采样
+// 返回放置的车辆数
+int warmStart(Simulation &sim, const WarmStartConfig &config);
+
+#pragma once
@@ -0,0 +1,64 @@
+// 实时状态读取示例：映射仿真发布的共享内存（Car_Sim --publish 名称），定时读取一致快照并输出统计
+// 运行：live_reader 名称 [间隔毫秒] [次数]
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <chrono>
+#include "LiveState.h"
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: live_reader name [interval-ms] [count]\n");
+        return 1;
+    }
+    int intervalMs = argc > 2 ? atoi(argv[2]) : 500;
+    long long count = argc > 3 ? atoll(argv[3]) : -1;
+
+    LiveStateReader reader;
+    if (!reader.open(argv[1]))
+    {
+        printf("cannot open shared memory %s\n", argv[1]);
+        return 1;
+    }
+    printf("bridge %dx%d  lanes %d  capacity %u\n", reader.layout.header()->windowWidth,
+           reader.layout.header()->windowHeight, reader.layout.header()->laneCount, reader.layout.capacity);
+
+    for (long long i = 0; count < 0 || i < count; ++i)
+    {
+        // 在共享内存上直接统计，读取期间被覆盖时自动重试
+        long long tick = 0, total = 0, published = 0, exited = 0, broken = 0, speedSum = 0, changing = 0, flashing = 0;
+        double time = 0;
+        bool ok = reader.read([&](const LiveSnapshot &s)
+                              {
+                                  tick = s.frame->tick;
+                                  time = s.frame->time;
+                                  total = s.frame->total;
+                                  published = s.count; // 超出容量时只发布了一部分车辆
+                                  exited = s.frame->exitedCount;
+                                  broken = s.frame->brokenDownCount;
+                                  speedSum = changing = flashing = 0;
+                                  for (uint32_t k = 0; k < s.count; ++k)
+                                  {
+                                      speedSum += s.vehicles[k].speed;
+                                      changing += (s.vehicles[k].flags & LIVE_CHANGING_LANE) != 0;
+                                      flashing += (s.vehicles[k].flags & LIVE_FLASHING) != 0;
+                                  }
+                              });
+        if (ok)
+        {
+            printf("tick %lld  t=%.1fs  vehicles %lld  mean speed %.1f  changing %lld  too close %lld  exited %lld  broken %lld  retries %lld\n",
+                   tick, time, total, published > 0 ? (double)speedSum / published : 0.0, changing, flashing, exited, broken,
+                   reader.retries);
+        }
+        else
+        {
+            printf("no frame published yet\n");
+        }
+        fflush(stdout);
+        this_thread::sleep_for(chrono::milliseconds(intervalMs));
+    }
+    return 0;
+}
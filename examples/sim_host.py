@@ -0,0 +1,54 @@
+# 嵌入示例：通过ctypes加载libcarsim.so，按列视图零复制读取车辆状态
+# 运行：python3 examples/sim_host.py build/libcarsim.so [帧数]
+import ctypes
+import sys
+
+
+class SimColumn(ctypes.Structure):
+    _fields_ = [("data", ctypes.c_void_p), ("stride", ctypes.c_size_t),
+                ("count", ctypes.c_size_t), ("elementType", ctypes.c_int)]
+
+
+SIM_COL_ID, SIM_COL_LANE, SIM_COL_X, SIM_COL_SPEED = 0, 1, 2, 4
+ELEMENT_TYPES = {0: ctypes.c_int32, 1: ctypes.c_float, 2: ctypes.c_uint8}
+
+
+def load(path):
+    lib = ctypes.CDLL(path)
+    lib.sim_create.restype = ctypes.c_void_p
+    lib.sim_create.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_double, ctypes.c_double, ctypes.c_uint64]
+    lib.sim_destroy.argtypes = [ctypes.c_void_p]
+    lib.sim_step.restype = ctypes.c_longlong
+    lib.sim_step.argtypes = [ctypes.c_void_p, ctypes.c_longlong]
+    lib.sim_spawn.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int,
+                              ctypes.c_double, ctypes.c_double, ctypes.c_double]
+    lib.sim_clear_lane.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    lib.sim_time.restype = ctypes.c_double
+    lib.sim_time.argtypes = [ctypes.c_void_p]
+    lib.sim_vehicle_count.restype = ctypes.c_size_t
+    lib.sim_vehicle_count.argtypes = [ctypes.c_void_p]
+    lib.sim_column.restype = SimColumn
+    lib.sim_column.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    return lib
+
+
+def column(lib, sim, column_id):
+    """返回列的值；读取时直接按地址和跨度访问仿真内部的车辆数组"""
+    view = lib.sim_column(sim, column_id)
+    ctype = ELEMENT_TYPES[view.elementType]
+    return [ctype.from_address(view.data + i * view.stride).value for i in range(view.count)]
+
+
+def main():
+    lib = load(sys.argv[1] if len(sys.argv) > 1 else "build/libcarsim.so")
+    ticks = int(sys.argv[2]) if len(sys.argv) > 2 else 500
+    sim = lib.sim_create(1600, 300, 4.0, 2.0, 42)
+    lib.sim_spawn(sim, 1, 2, 12.0, 2.5, 20.0)
+    lib.sim_step(sim, ticks)
+    xs = column(lib, sim, SIM_COL_X)
+    print("time=%.1fs vehicles=%d sumX=%d" % (lib.sim_time(sim), lib.sim_vehicle_count(sim), sum(xs)))
+    lib.sim_destroy(sim)
+
+
+if __name__ == "__main__":
+    main()
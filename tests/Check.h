@@ -0,0 +1,28 @@
+﻿#include <cstdio>
+
+// 无界面测试用的最小检查：失败时输出位置和表达式，main最后返回failures()
+inline int &testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                  \
+    do                                                                                    \
+    {                                                                                     \
+        if (!(condition))                                                                 \
+        {                                                                                 \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);          \
+            ++testFailures();                                                             \
+        }                                                                                 \
+    } while (0)
+
+// 测试结果：没有失败时返回0
+inline int testResult()
+{
+    if (testFailures() == 0)
+        printf("all checks passed\n");
+    return testFailures() == 0 ? 0 : 1;
+}
+
+#pragma once
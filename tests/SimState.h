@@ -0,0 +1,21 @@
+﻿#include "Simulation.h"
+
+// 两个仿真的状态是否完全相同：帧号、时钟、随机数、统计量和每辆车的状态
+inline bool sameState(const Simulation &a, const Simulation &b)
+{
+    if (a.tick != b.tick || a.time != b.time || a.engine.state != b.engine.state ||
+        a.nextVehicleId != b.nextVehicleId || a.exitedCount != b.exitedCount ||
+        a.brokenDownCount != b.brokenDownCount || a.vehicles.size() != b.vehicles.size())
+        return false;
+    for (size_t i = 0; i < a.vehicles.size(); ++i)
+    {
+        const Vehicle &u = a.vehicles[i], &v = b.vehicles[i];
+        if (u.id != v.id || u.x != v.x || u.y != v.y || u.speed != v.speed || u.lane != v.lane ||
+            u.targetLane != v.targetLane || u.isChangingLane != v.isChangingLane ||
+            u.changeProgress != v.changeProgress || u.isBrokenDown != v.isBrokenDown || u.rng.state != v.rng.state)
+            return false;
+    }
+    return true;
+}
+
+#pragma once
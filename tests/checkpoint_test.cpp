@@ -0,0 +1,125 @@
+﻿#include <vector>
+#include <algorithm>
+#include <cstring>
+#include "Check.h"
+#include "SimState.h"
+#include "Checkpoint.h"
+using namespace std;
+
+namespace
+{
+    Simulation makeSimulation()
+    {
+        Simulation sim(1800, 600, 3, 1, 7);
+        sim.params.logRelativeSpeed = false;
+        sim.params.spawnPeriod = 3;
+        for (int i = 0; i < 400; ++i)
+        {
+            sim.step();
+        }
+        return sim;
+    }
+}
+
+// 保存后恢复的状态与原状态逐帧推进结果完全相同
+void testRoundTrip()
+{
+    Simulation sim = makeSimulation();
+    CHECK(!sim.vehicles.empty());
+    vector<char> blob = saveCheckpoint(sim);
+
+    Simulation restored;
+    CHECK(restoreCheckpoint(restored, blob));
+    CHECK(sameState(sim, restored));
+    CHECK(saveCheckpoint(restored) == blob);
+    for (int i = 0; i < 300; ++i)
+    {
+        sim.step();
+        restored.step();
+    }
+    CHECK(sameState(sim, restored));
+}
+
+// 无效数据不修改目标状态
+void testRejectsInvalid()
+{
+    Simulation sim = makeSimulation();
+    vector<char> blob = saveCheckpoint(sim);
+    Simulation target = sim;
+    vector<char> truncated(blob.begin(), blob.end() - 1);
+    CHECK(!restoreCheckpoint(target, truncated));
+    vector<char> corrupted = blob;
+    corrupted[0] ^= 1;
+    CHECK(!restoreCheckpoint(target, corrupted));
+    CHECK(sameState(sim, target));
+}
+
+// 字段越界的数据不分配内存、不修改目标状态
+void testRejectsOutOfRange()
+{
+    Simulation sim = makeSimulation();
+    vector<char> blob = saveCheckpoint(sim);
+    Simulation target = sim;
+    // 固定头部之后依次是车辆数和第一辆车（id 4字节、随机数8字节、类型、车道、目标车道各1字节）
+    size_t countOffset = blob.size() - sim.vehicles.size() * 60 - 4;
+    size_t laneCountOffset = 4 + 4 + 8 + 8 + 8 + 4 + 4 + 4; // 魔数、版本、时钟、随机数引擎、车辆编号、窗口尺寸之后
+
+    vector<char> hugeCount = blob;
+    uint32_t count = 0xFFFFFFFF;
+    memcpy(hugeCount.data() + countOffset, &count, sizeof(count));
+    CHECK(!restoreCheckpoint(target, hugeCount));
+
+    const int32_t laneCounts[] = {0, -3, 256};
+    for (int32_t laneCount : laneCounts)
+    {
+        vector<char> badLaneCount = blob;
+        memcpy(badLaneCount.data() + laneCountOffset, &laneCount, sizeof(laneCount));
+        CHECK(!restoreCheckpoint(target, badLaneCount));
+    }
+
+    const size_t fieldOffsets[] = {12, 13, 14}; // 类型、车道、目标车道
+    for (size_t field : fieldOffsets)
+    {
+        vector<char> badVehicle = blob;
+        badVehicle[countOffset + 4 + field] = (char)sim.laneCount;
+        CHECK(!restoreCheckpoint(target, badVehicle));
+    }
+    CHECK(sameState(sim, target));
+}
+
+// 分支在修改前共享前缀；不做修改的分支与直接推进的结果相同，修改只影响自己的分支
+void testFork()
+{
+    Simulation prefix = makeSimulation();
+    shared_ptr<const Simulation> shared = make_shared<Simulation>(prefix);
+    SimulationFork fork(shared);
+    CHECK(&fork.view() == shared.get());
+    fork.mutate();
+    CHECK(&fork.view() != shared.get());
+
+    Simulation continued = prefix;
+    for (int i = 0; i < 200; ++i)
+    {
+        continued.step();
+    }
+    int lane = prefix.vehicles.front().lane;
+    auto clearLane = [lane](Simulation &sim) {
+        sim.vehicles.erase(remove_if(sim.vehicles.begin(), sim.vehicles.end(),
+                                     [lane](const Vehicle &v) { return v.lane == lane; }),
+                           sim.vehicles.end());
+    };
+    vector<function<void(Simulation &)>> edits = {[](Simulation &) {}, clearLane};
+    vector<Simulation> results = runWhatIf(prefix, edits, 200);
+    CHECK(results.size() == 2);
+    CHECK(sameState(results[0], continued));
+    CHECK(!sameState(results[1], continued));
+}
+
+int main()
+{
+    testRoundTrip();
+    testRejectsInvalid();
+    testRejectsOutOfRange();
+    testFork();
+    return testResult();
+}
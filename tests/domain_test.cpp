@@ -0,0 +1,56 @@
+﻿#include "Check.h"
+#include "SimState.h"
+#include "Domain.h"
+using namespace std;
+
+namespace
+{
+    DomainConfig makeConfig(int domains)
+    {
+        DomainConfig config;
+        config.domains = domains;
+        config.ticks = 300;
+        config.seed = 5;
+        config.corridorWidth = 1800 * 4;
+        config.windowHeight = 600;
+        config.scale = 3;
+        return config;
+    }
+
+    // 分域结果按sameState比较：只填入分域运行回传的车辆和统计量
+    Simulation asState(const DomainRunResult &result)
+    {
+        Simulation sim;
+        sim.vehicles = result.vehicles;
+        sim.exitedCount = result.exitedCount;
+        sim.brokenDownCount = result.brokenDownCount;
+        return sim;
+    }
+}
+
+// 任意分域数的运行结果与单进程运行逐车完全相同
+void testMatchesSingleProcess()
+{
+    DomainRunResult reference = runSingleDomain(makeConfig(1));
+    CHECK(!reference.vehicles.empty());
+    const int counts[] = {1, 2, 3, 4, 8};
+    for (int domains : counts)
+    {
+        DomainRunResult result;
+        CHECK(runDomainProcesses(makeConfig(domains), result));
+        CHECK(sameState(asState(result), asState(reference)));
+    }
+}
+
+// 启动器自身的比较也报告一致
+void testLauncher()
+{
+    CHECK(runDomainLauncher(makeConfig(4)) == 0);
+}
+
+int main()
+{
+    testMatchesSingleProcess();
+    testLauncher();
+    return testResult();
+}
@@ -0,0 +1,54 @@
+﻿#include <vector>
+#include "Check.h"
+#include "SimState.h"
+#include "EventEngine.h"
+using namespace std;
+
+namespace
+{
+    Simulation makeSimulation(int spawnPeriod)
+    {
+        Simulation sim(1800, 600, 3, 1, 11);
+        sim.params.logRelativeSpeed = false;
+        sim.params.spawnPeriod = spawnPeriod;
+        return sim;
+    }
+}
+
+// 稀疏交通：事件引擎跳过大部分帧，分段推进到任意帧号的结果都与逐帧推进相同
+void testSparseEquivalence()
+{
+    Simulation fixed = makeSimulation(200);
+    Simulation evented = makeSimulation(200);
+    EventEngine engine(evented);
+    for (long long target : {1LL, 7LL, 500LL, 501LL, 3000LL, 20000LL})
+    {
+        while (fixed.tick < target)
+        {
+            fixed.step();
+        }
+        engine.advanceTo(target);
+        CHECK(evented.tick == target);
+        CHECK(sameState(fixed, evented));
+    }
+    CHECK(engine.stats.coastedTicks > engine.stats.fullSteps);
+    CHECK(engine.stats.fullSteps + engine.stats.coastedTicks == evented.tick);
+}
+
+// 拥堵交通：大多数帧都有事件，结果仍与逐帧推进相同，交通事件逐一对应
+void testDenseEquivalence()
+{
+    EventComparison report = runEventComparison(1800, 600, 3, 1, 3, 2000, 5);
+    CHECK(report.identicalState);
+    CHECK(report.fixedEvents > 0);
+    CHECK(report.eventEvents == report.fixedEvents);
+    CHECK(report.matched == report.fixedEvents);
+    CHECK(report.maxTickError == 0);
+}
+
+int main()
+{
+    testSparseEquivalence();
+    testDenseEquivalence();
+    return testResult();
+}
@@ -0,0 +1,137 @@
+﻿#include "Check.h"
+#include "FrameGovernor.h"
+using namespace std;
+
+namespace
+{
+    GovernorConfig testConfig()
+    {
+        GovernorConfig config;
+        config.budgetMilliseconds = 10;
+        config.smoothing = 0.5;
+        config.degradeFrames = 3;
+        config.restoreFraction = 0.5;
+        config.restoreFrames = 4;
+        config.reducedRateDivisor = 3;
+        return config;
+    }
+
+    // 以固定耗时记录frames帧，返回其中等级改变的次数
+    int recordFrames(FrameGovernor &governor, double milliseconds, int frames)
+    {
+        int changes = 0;
+        for (int i = 0; i < frames; ++i)
+        {
+            changes += governor.record(milliseconds) ? 1 : 0;
+        }
+        return changes;
+    }
+}
+
+// 持续超出预算时每degradeFrames帧降一级，降到REDUCED_RATE后不再变化
+void testDegrade()
+{
+    FrameGovernor governor(testConfig());
+    CHECK(recordFrames(governor, 20, 2) == 0);
+    CHECK(governor.level == QualityLevel::FULL);
+    CHECK(recordFrames(governor, 20, 1) == 1);
+    CHECK(governor.level == QualityLevel::NO_TRAJECTORIES);
+    for (int level = 2; level < QUALITY_LEVEL_COUNT; ++level)
+    {
+        CHECK(recordFrames(governor, 20, 2) == 0);
+        CHECK(recordFrames(governor, 20, 1) == 1);
+        CHECK((int)governor.level == level);
+    }
+    CHECK(recordFrames(governor, 20, 50) == 0);
+    CHECK(governor.level == QualityLevel::REDUCED_RATE);
+    CHECK(governor.levelChanges == QUALITY_LEVEL_COUNT - 1);
+    CHECK(governor.frames == 3 * (QUALITY_LEVEL_COUNT - 1) + 50);
+}
+
+// 耗时低于预算的restoreFraction时每restoreFrames帧升一级，介于两者之间时保持不变
+void testRestore()
+{
+    FrameGovernor governor(testConfig());
+    recordFrames(governor, 20, 3 * (QUALITY_LEVEL_COUNT - 1));
+    CHECK(governor.level == QualityLevel::REDUCED_RATE);
+
+    // 在预算内但没有余量
+    CHECK(recordFrames(governor, 7, 100) == 0);
+    CHECK(governor.level == QualityLevel::REDUCED_RATE);
+
+    // 换级后平均值从本级第一帧重新开始，旧等级的慢帧不会拖住恢复
+    for (int level = QUALITY_LEVEL_COUNT - 2; level >= 0; --level)
+    {
+        CHECK(recordFrames(governor, 2, 3) == 0);
+        CHECK(recordFrames(governor, 2, 1) == 1);
+        CHECK((int)governor.level == level);
+    }
+    CHECK(recordFrames(governor, 2, 20) == 0);
+    CHECK(governor.level == QualityLevel::FULL);
+}
+
+// 偶发的单帧超时被平均值吸收，不触发降级
+void testSpike()
+{
+    FrameGovernor governor(testConfig());
+    for (int i = 0; i < 40; ++i)
+    {
+        governor.record(i % 10 == 0 ? 30 : 3);
+    }
+    CHECK(governor.level == QualityLevel::FULL);
+    CHECK(governor.levelChanges == 0);
+}
+
+// 预算不大于0时不调节
+void testDisabled()
+{
+    GovernorConfig config = testConfig();
+    config.budgetMilliseconds = 0;
+    FrameGovernor governor(config);
+    CHECK(recordFrames(governor, 1000, 100) == 0);
+    CHECK(governor.level == QualityLevel::FULL);
+    CHECK(governor.framesAt[0] == 100);
+}
+
+// 各等级的细节阈值逐级收紧；REDUCED_RATE每reducedRateDivisor个新快照绘制一次
+void testApplyAndRate()
+{
+    LodConfig base;
+    FrameGovernor governor(testConfig());
+    CHECK(governor.apply(base).trajectoryMaxVehicles == base.trajectoryMaxVehicles);
+    CHECK(governor.apply(base).labelMaxVehicles == base.labelMaxVehicles);
+    for (int i = 0; i < 10; ++i)
+    {
+        CHECK(governor.shouldDraw());
+    }
+
+    recordFrames(governor, 20, 3);
+    CHECK(governor.apply(base).trajectoryMaxVehicles == -1);
+    CHECK(governor.apply(base).labelMaxVehicles == base.labelMaxVehicles);
+    recordFrames(governor, 20, 3);
+    CHECK(governor.apply(base).labelMaxVehicles == -1);
+    CHECK(governor.apply(base).fullMaxVehicles == base.fullMaxVehicles);
+    recordFrames(governor, 20, 3);
+    CHECK(governor.apply(base).fullMaxVehicles == -1);
+    CHECK(governor.shouldDraw());
+    recordFrames(governor, 20, 3);
+    CHECK(governor.level == QualityLevel::REDUCED_RATE);
+
+    int drawn = 0;
+    for (int i = 0; i < 30; ++i)
+    {
+        drawn += governor.shouldDraw() ? 1 : 0;
+    }
+    CHECK(drawn == 10);
+    CHECK(governor.skipped == 20);
+}
+
+int main()
+{
+    testDegrade();
+    testRestore();
+    testSpike();
+    testDisabled();
+    testApplyAndRate();
+    return testResult();
+}
@@ -0,0 +1,99 @@
+﻿#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include "Check.h"
+#include "LiveState.h"
+#include "Simulation.h"
+using namespace std;
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // 第tick帧发布的车辆数和车辆位置：读取方据此判断快照是否混入了两帧的数据
+    uint32_t vehiclesAt(long long tick) { return 20 + (uint32_t)(tick % 7); }
+}
+
+// 发布方不停写入时，读取方得到的每个快照都是同一帧的完整数据，帧号不倒退
+void testConsistentSnapshots()
+{
+    Simulation sim(1800, 600, 3, 1, 3);
+    sim.params.logRelativeSpeed = false;
+    sim.params.spawnPeriod = 1;
+    while (sim.vehicles.size() < vehiclesAt(6))
+    {
+        sim.step();
+    }
+    vector<Vehicle> prototype = sim.vehicles;
+
+    string name = "carsim_live_state_test_" + to_string((long long)getpid());
+    LiveStatePublisher publisher;
+    CHECK(publisher.create(name, sim, 64));
+    LiveStateReader reader;
+    CHECK(reader.open(name));
+    if (reader.layout.base == nullptr)
+        return;
+
+    const long long frames = 200000;
+    atomic<bool> done(false);
+    thread writer([&]()
+                  {
+                      for (long long tick = 1; tick <= frames; ++tick)
+                      {
+                          sim.tick = tick;
+                          sim.vehicles.assign(prototype.begin(), prototype.begin() + vehiclesAt(tick));
+                          for (auto &v : sim.vehicles)
+                          {
+                              v.x = (int)tick;
+                          }
+                          publisher.publish(sim);
+                      }
+                      done.store(true);
+                  });
+
+    long long reads = 0, inconsistent = 0, lastTick = 0, regressions = 0;
+    while (!done.load())
+    {
+        long long tick = 0;
+        bool consistent = true;
+        bool ok = reader.read([&](const LiveSnapshot &s)
+                              {
+                                  tick = s.frame->tick;
+                                  consistent = s.count == vehiclesAt(tick) && s.frame->total == s.count;
+                                  for (uint32_t i = 0; i < s.count && consistent; ++i)
+                                  {
+                                      consistent = s.vehicles[i].x == tick && s.vehicles[i].id == prototype[i].id;
+                                  }
+                              });
+        if (!ok)
+            continue;
+        ++reads;
+        if (!consistent)
+            ++inconsistent;
+        if (tick < lastTick)
+            ++regressions;
+        lastTick = tick;
+    }
+    writer.join();
+
+    CHECK(reads > 0);
+    CHECK(inconsistent == 0);
+    CHECK(regressions == 0);
+    CHECK(publisher.truncatedFrames == 0);
+    // 写入结束后读到的是最后一帧
+    long long finalTick = 0;
+    CHECK(reader.read([&](const LiveSnapshot &s) { finalTick = s.frame->tick; }));
+    CHECK(finalTick == frames);
+}
+
+int main()
+{
+    testConsistentSnapshots();
+    return testResult();
+}
@@ -0,0 +1,171 @@
+﻿#include <vector>
+#include <map>
+#include <cstdio>
+#include "Check.h"
+#include "Recording.h"
+using namespace std;
+
+namespace
+{
+    const char *RECORDING_PATH = "recording_test.rec";
+
+    struct Sample
+    {
+        long long tick;
+        int x, lane, speed;
+    };
+
+    // 逐帧记录的同时在内存中保存每辆车的轨迹和进出桥面的帧号，作为查询的参照
+    struct Reference
+    {
+        map<int, vector<Sample>> history;
+        vector<pair<long long, int>> entered, exited; // (帧号, 车辆编号)
+        vector<RecordedEvent> events[RECORDED_EVENT_KINDS];
+        vector<double> frameTimes;
+    };
+
+    bool recordRun(Reference &reference)
+    {
+        Simulation sim(1800, 600, 3, 1, 21);
+        sim.params.logRelativeSpeed = false;
+        sim.params.spawnPeriod = 3;
+        RunRecorder recorder;
+        if (!recorder.open(RECORDING_PATH, sim, 16))
+            return false;
+        vector<int> previous;
+        while (sim.tick < 1500)
+        {
+            sim.step();
+            recorder.record(sim);
+            long long tick = sim.tick - 1; // 记录中的帧号是推进前的帧号
+            vector<int> current;
+            for (const Vehicle &v : sim.vehicles)
+            {
+                reference.history[v.id].push_back({tick, v.x, v.lane, v.speed});
+                current.push_back(v.id);
+                if (!binary_search(previous.begin(), previous.end(), v.id))
+                    reference.entered.push_back(make_pair(tick, v.id));
+            }
+            for (int id : previous)
+            {
+                if (!binary_search(current.begin(), current.end(), id))
+                    reference.exited.push_back(make_pair(tick, id));
+            }
+            previous.swap(current);
+            reference.frameTimes.push_back(sim.time);
+        }
+        for (int k = 0; k < RECORDED_EVENT_KINDS; ++k)
+        {
+            reference.events[k] = recorder.events[k];
+        }
+        return recorder.close();
+    }
+
+    vector<pair<long long, int>> ticksAndIds(const vector<RecordedEvent> &events)
+    {
+        vector<pair<long long, int>> result;
+        for (const RecordedEvent &e : events)
+        {
+            result.push_back(make_pair((long long)e.tick, (int)e.vehicleId));
+        }
+        return result;
+    }
+}
+
+// 车辆轨迹查询与逐帧保存的轨迹相同
+void testVehicleHistory(const RunReader &reader, const Reference &reference)
+{
+    CHECK(reader.index.header->vehicleCount == reference.history.size());
+    for (const auto &entry : reference.history)
+    {
+        vector<VehicleSample> samples = reader.vehicleHistory(entry.first);
+        const vector<Sample> &expected = entry.second;
+        CHECK(samples.size() == expected.size());
+        for (size_t i = 0; i < samples.size() && i < expected.size(); ++i)
+        {
+            CHECK(samples[i].tick == expected[i].tick && samples[i].state.x == expected[i].x &&
+                  samples[i].state.lane == expected[i].lane && samples[i].state.speed == expected[i].speed);
+        }
+    }
+    CHECK(reader.vehicleHistory(-1).empty());
+}
+
+// 事件查询：进出桥面与车辆出现、消失的帧号一致，按时间和车道筛选的结果与逐条筛选相同
+void testEvents(const RunReader &reader, const Reference &reference)
+{
+    double end = reference.frameTimes.back();
+    CHECK(ticksAndIds(reader.index.findEvents(RecordedEventKind::ENTER, 0, end)) == reference.entered);
+    CHECK(ticksAndIds(reader.index.findEvents(RecordedEventKind::EXIT, 0, end)) == reference.exited);
+    CHECK(!reference.exited.empty());
+
+    for (int k = 0; k < RECORDED_EVENT_KINDS; ++k)
+    {
+        RecordedEventKind kind = (RecordedEventKind)k;
+        for (double t0 : {0.0, 33.3, 100.0})
+        {
+            for (int lane = -1; lane < 6; ++lane)
+            {
+                double t1 = t0 + 120;
+                vector<RecordedEvent> expected;
+                for (const RecordedEvent &e : reference.events[k])
+                {
+                    if (e.time >= t0 && e.time <= t1 && (lane < 0 || e.lane == lane))
+                        expected.push_back(e);
+                }
+                vector<RecordedEvent> found = reader.index.findEvents(kind, t0, t1, lane);
+                CHECK(found.size() == expected.size());
+                for (size_t i = 0; i < found.size() && i < expected.size(); ++i)
+                {
+                    CHECK(found[i].tick == expected[i].tick && found[i].vehicleId == expected[i].vehicleId &&
+                          found[i].lane == expected[i].lane && found[i].x == expected[i].x);
+                }
+            }
+        }
+    }
+}
+
+// 时间范围内的数据块覆盖范围内的所有帧
+void testFrames(const RunReader &reader, const Reference &reference)
+{
+    double t0 = 50, t1 = 75.5;
+    uint64_t first, last;
+    reader.index.chunksInTime(t0, t1, first, last);
+    CHECK(first < last);
+    size_t frames = 0;
+    for (uint64_t c = first; c < last; ++c)
+    {
+        CHECK(reader.forEachFrame(reader.index.chunks()[c], [&](const RecordedFrame &frame, const LiveVehicle *)
+                                  {
+                                      if (frame.time >= t0 && frame.time <= t1)
+                                          ++frames;
+                                  }));
+    }
+    size_t expected = 0;
+    for (double t : reference.frameTimes)
+    {
+        if (t >= t0 && t <= t1)
+            ++expected;
+    }
+    CHECK(frames == expected);
+    CHECK(reader.header.frameCount == (int64_t)reference.frameTimes.size());
+}
+
+int main()
+{
+    Reference reference;
+    CHECK(recordRun(reference));
+    {
+        RunReader reader;
+        string error;
+        CHECK(reader.open(RECORDING_PATH, error));
+        if (reader.index.header != nullptr)
+        {
+            testVehicleHistory(reader, reference);
+            testEvents(reader, reference);
+            testFrames(reader, reference);
+        }
+    }
+    remove(RECORDING_PATH);
+    remove((string(RECORDING_PATH) + ".idx").c_str());
+    return testResult();
+}
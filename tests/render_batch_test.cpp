@@ -0,0 +1,111 @@
+﻿#include <vector>
+#include "Check.h"
+#include "RenderBatch.h"
+#include "Scene.h"
+#include "Simulation.h"
+using namespace std;
+
+namespace
+{
+    const int WIDTH = 1800, HEIGHT = 600;
+
+    // 按记录顺序和按批次提交顺序光栅化，返回不同的像素数
+    long long replayDifference(RenderBatcher &batcher, TileRenderer &renderer, const RasterCanvas &canvas)
+    {
+        RasterCanvas replayed;
+        batcher.build(canvas);
+        batcher.replay(canvas, replayed);
+        vector<uint32_t> expected((size_t)canvas.width * canvas.height), actual(expected.size());
+        renderer.render(canvas, expected.data(), canvas.width);
+        renderer.render(replayed, actual.data(), canvas.width);
+        return compareFrames(expected.data(), actual.data(), expected.size(), 0).differing;
+    }
+}
+
+// 两种颜色交替的图元：不相交的合并成两个批次，相交的保持原来的覆盖顺序
+void testOverlapOrder()
+{
+    RenderBatcher batcher;
+    TileRenderer renderer(1);
+    RasterCanvas canvas;
+
+    // 互不相交：只按颜色分成两批
+    canvas.reset(WIDTH, HEIGHT);
+    {
+        RasterCanvasScope scope(canvas);
+        for (int i = 0; i < 20; ++i)
+        {
+            render::setfillcolor(i % 2 == 0 ? RED : BLUE);
+            render::solidrectangle(i * 60, 10, i * 60 + 40, 50);
+        }
+    }
+    CHECK(replayDifference(batcher, renderer, canvas) == 0);
+    CHECK(batcher.stats.commands == 20);
+    CHECK(batcher.stats.batches == 2);
+
+    // 每个矩形都压住前一个：任何图元都不能越过前面的批次
+    canvas.reset(WIDTH, HEIGHT);
+    {
+        RasterCanvasScope scope(canvas);
+        for (int i = 0; i < 20; ++i)
+        {
+            render::setfillcolor(i % 2 == 0 ? RED : BLUE);
+            render::solidrectangle(i * 30, 10, i * 30 + 40, 50);
+        }
+    }
+    CHECK(replayDifference(batcher, renderer, canvas) == 0);
+    CHECK(batcher.stats.batches == 20);
+
+    // 完全在画面外的图元不提交
+    canvas.reset(WIDTH, HEIGHT);
+    {
+        RasterCanvasScope scope(canvas);
+        render::setfillcolor(WHITE);
+        render::solidrectangle(-100, -100, -50, -50);
+        render::solidrectangle(10, 10, 50, 50);
+    }
+    CHECK(replayDifference(batcher, renderer, canvas) == 0);
+    CHECK(batcher.stats.culled == 1);
+}
+
+// 仿真场景在不同缩放下分组前后的画面完全相同，并且状态设置调用更少
+void testSceneReplay()
+{
+    Bridge bridge = {100, 50, 1};
+    Simulation sim(WIDTH, HEIGHT, 3, bridge.widthScale, 1);
+    sim.params.logRelativeSpeed = false;
+    sim.params.spawnPeriod = 2;
+    LodConfig lodConfig;
+    RenderBatcher batcher;
+    TileRenderer renderer(1);
+    RasterCanvas canvas;
+    const double zooms[] = {1, 3};
+    for (int i = 1; i <= 300; ++i)
+    {
+        sim.step();
+        if (i % 50 != 0)
+            continue;
+        for (double zoom : zooms)
+        {
+            SceneView view;
+            view.camera.fit(WIDTH, HEIGHT, WIDTH, HEIGHT);
+            view.camera.zoomAt(WIDTH / 2, HEIGHT / 2, zoom);
+            canvas.reset(WIDTH, HEIGHT);
+            {
+                RasterCanvasScope scope(canvas);
+                drawScene(bridge, sim, lodConfig, view);
+            }
+            CHECK(replayDifference(batcher, renderer, canvas) == 0);
+            CHECK(batcher.stats.stateChanges <= batcher.stats.stateCalls);
+            CHECK(batcher.stats.batches < batcher.stats.commands);
+        }
+    }
+    CHECK(!sim.vehicles.empty());
+}
+
+int main()
+{
+    testOverlapOrder();
+    testSceneReplay();
+    return testResult();
+}
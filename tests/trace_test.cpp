@@ -0,0 +1,121 @@
+﻿#include <vector>
+#include <string>
+#include <cstdio>
+#include <fstream>
+#include <cmath>
+#include "Check.h"
+#include "Trace.h"
+using namespace std;
+
+namespace
+{
+    const char *CSV_PATH = "trace_test.csv";
+    const char *TRACE_PATH = "trace_test.trace";
+    const int RECORDS = 3000;
+    const double INTERVAL = 0.02; // 每秒50辆，远超入口的通行能力
+
+    // 第i条记录：车道和车型轮流变化
+    bool writeTrace(int laneCount)
+    {
+        ofstream csv(CSV_PATH);
+        csv << "time,lane,type,length,width,speed\n";
+        for (int i = 0; i < RECORDS; ++i)
+        {
+            csv << i * INTERVAL << "," << i % laneCount << "," << i % 3 << ",4.5,1.8,20\n";
+        }
+        csv.close();
+        string error;
+        return convertTraceCsv(CSV_PATH, TRACE_PATH, error);
+    }
+
+    Simulation makeSimulation()
+    {
+        Simulation sim(1800, 600, 3, 1, 11);
+        sim.params.logRelativeSpeed = false;
+        return sim;
+    }
+
+    // 按记录推进仿真，每帧检查等待车辆数不超过上限
+    void replay(TraceDemand &demand, Simulation &sim, int ticks)
+    {
+        sim.spawnSource = [&demand](Simulation &s) { demand.spawnDue(s); };
+        for (int i = 0; i < ticks; ++i)
+        {
+            sim.step();
+            CHECK(demand.waitingCount() <= demand.maxWaiting);
+        }
+    }
+}
+
+// 窗口远小于文件、记录跨越窗口边界时，顺序读出的记录与写入的相同
+void testSmallWindows()
+{
+    Simulation sim = makeSimulation();
+    TraceReader reader;
+    string error;
+    CHECK(reader.open(TRACE_PATH, error, 1));
+    CHECK(reader.recordCount == RECORDS);
+    CHECK(reader.windowSize % sizeof(TraceRecord) != 0);
+    int matched = 0;
+    for (int i = 0; reader.hasNext(); ++i)
+    {
+        const TraceRecord *record = reader.next();
+        if (record != nullptr && abs(record->time - i * INTERVAL) < 1e-9 && record->lane == i % sim.laneCount &&
+            record->type == i % 3)
+            ++matched;
+    }
+    CHECK(matched == RECORDS);
+    CHECK(!reader.failed);
+    CHECK(reader.peek() == nullptr);
+}
+
+// 映射失败后不再返回记录，需求随之结束而不是访问空指针
+void testMappingFailure()
+{
+    TraceDemand demand;
+    string error;
+    CHECK(demand.open(TRACE_PATH, error, 1));
+    demand.reader.file.close();
+    Simulation sim = makeSimulation();
+    replay(demand, sim, 10);
+    CHECK(demand.reader.failed);
+    CHECK(demand.released == 0);
+    CHECK(demand.finished());
+}
+
+// 需求超过入口通行能力时等待车辆数受上限约束，其余到期的记录留在文件中
+void testBacklogCap()
+{
+    TraceDemand uncapped, capped;
+    string error;
+    CHECK(uncapped.open(TRACE_PATH, error, 1));
+    CHECK(capped.open(TRACE_PATH, error, 1));
+    uncapped.maxWaiting = RECORDS;
+    capped.maxWaiting = 40;
+    Simulation a = makeSimulation(), b = makeSimulation();
+    const int ticks = 400; // 80秒，所有记录都已到期
+    replay(uncapped, a, ticks);
+    replay(capped, b, ticks);
+
+    CHECK(uncapped.released == RECORDS);
+    CHECK(uncapped.deferred == 0);
+    CHECK(uncapped.waitingCount() > capped.maxWaiting);
+    CHECK(capped.released < RECORDS);
+    CHECK(capped.deferred > 0);
+    CHECK(capped.released == (long long)capped.reader.position);
+    CHECK(capped.spawned + (long long)capped.waitingCount() == capped.released);
+    CHECK(capped.spawned > 0);
+    CHECK(!capped.finished());
+}
+
+int main()
+{
+    Simulation sim = makeSimulation();
+    CHECK(writeTrace(sim.laneCount));
+    testSmallWindows();
+    testMappingFailure();
+    testBacklogCap();
+    remove(CSV_PATH);
+    remove(TRACE_PATH);
+    return testResult();
+}